@@ -0,0 +1,51 @@
+#ifndef BASE_DEADLINE_H_
+#define BASE_DEADLINE_H_
+
+#include <atomic>
+#include <chrono>
+
+// Deadline is a point in the monotonic clock by which some work should be done.
+// Long-running algorithms check hasPassed() cooperatively, and return early.
+// A default-constructed Deadline never passes. A Deadline can also be cancelled
+// from another thread with a flag (see withCancelFlag()).
+class Deadline {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    Deadline() : infinite_(true) {}
+    explicit Deadline(Clock::time_point timePoint) : infinite_(false), timePoint_(timePoint) {}
+
+    static Deadline infinite() { return Deadline(); }
+    static Deadline fromNow(std::chrono::microseconds duration) { return Deadline(Clock::now() + duration); }
+
+    // Returns a copy which has also passed when |*cancelled| becomes true.
+    // Doesn't take the ownership of |cancelled|.
+    Deadline withCancelFlag(const std::atomic<bool>* cancelled) const
+    {
+        Deadline d(*this);
+        d.cancelled_ = cancelled;
+        return d;
+    }
+
+    bool isInfinite() const { return infinite_ && !cancelled_; }
+    bool isCancelled() const { return cancelled_ && cancelled_->load(std::memory_order_relaxed); }
+    bool hasPassed() const { return isCancelled() || (!infinite_ && timePoint_ <= Clock::now()); }
+
+    // Returns the remaining time. Returns Clock::duration::max() if infinite.
+    Clock::duration remaining() const
+    {
+        if (isCancelled())
+            return Clock::duration::zero();
+        if (infinite_)
+            return Clock::duration::max();
+        Clock::time_point now = Clock::now();
+        return now < timePoint_ ? timePoint_ - now : Clock::duration::zero();
+    }
+
+private:
+    bool infinite_;
+    Clock::time_point timePoint_;
+    const std::atomic<bool>* cancelled_ = nullptr;
+};
+
+#endif
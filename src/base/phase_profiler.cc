@@ -0,0 +1,300 @@
+#include "base/phase_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+using namespace std;
+
+DEFINE_bool(phase_profile, false, "record the time of each phase with PhaseProfiler");
+DEFINE_string(phase_profile_dump_file, "", "the file to dump the phase profile to");
+
+namespace {
+
+// The records of one phase in one thread. Only the owner thread writes, so relaxed
+// load and store are enough.
+struct PhaseCounters {
+    atomic<uint64_t> counts[LatencyHistogram::NUM_BUCKETS];
+    atomic<uint64_t> sum;
+    atomic<uint64_t> max;
+};
+
+// Histograms are owned by one thread at a time. They're never freed, so that the
+// records of finished threads are kept, and a new thread reuses them.
+// PhaseCounters (about 8KB) is allocated when the owner records the phase first,
+// since most threads record only a few phases.
+struct ThreadHistograms {
+    atomic<PhaseCounters*> phases[PhaseProfiler::MAX_PHASES];
+    atomic<bool> inUse { true };
+    ThreadHistograms* next = nullptr;
+};
+
+atomic<ThreadHistograms*> g_histograms { nullptr };
+
+ThreadHistograms* acquireHistograms()
+{
+    for (ThreadHistograms* h = g_histograms.load(memory_order_acquire); h; h = h->next) {
+        bool expected = false;
+        if (h->inUse.compare_exchange_strong(expected, true))
+            return h;
+    }
+
+    // Value-initialization makes all the PhaseCounters null.
+    ThreadHistograms* h = new ThreadHistograms();
+    h->next = g_histograms.load(memory_order_relaxed);
+    while (!g_histograms.compare_exchange_weak(h->next, h)) {}
+    return h;
+}
+
+struct ThreadHistogramsHolder {
+    ThreadHistogramsHolder() : histograms(acquireHistograms()) {}
+    ~ThreadHistogramsHolder() { histograms->inUse = false; }
+
+    ThreadHistograms* histograms;
+};
+
+ThreadHistograms* threadHistograms()
+{
+    static thread_local ThreadHistogramsHolder holder;
+    return holder.histograms;
+}
+
+void increment(atomic<uint64_t>* v, uint64_t n)
+{
+    v->store(v->load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+struct PhaseRegistry {
+    mutex mu;
+    vector<string> names;
+    atomic<int> numPhases { 0 };
+
+    // The origin to measure the clock rate of the time stamp counter.
+    unsigned long long originCycles = readTimeStampCounter();
+    chrono::steady_clock::time_point originTime = chrono::steady_clock::now();
+};
+
+PhaseRegistry& registry()
+{
+    static PhaseRegistry registry;
+    return registry;
+}
+
+// Returns 0 if it's not measured well yet.
+double cyclesPerMicrosecond()
+{
+    const PhaseRegistry& r = registry();
+    double micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - r.originTime).count();
+    if (micros < 1000)
+        return 0;
+    return (readTimeStampCounter() - r.originCycles) / micros;
+}
+
+} // anonymous namespace
+
+// static
+int LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+        return static_cast<int>(value);
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS;
+    int sub = static_cast<int>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    return (shift + 1) * SUB_BUCKET_COUNT + sub;
+}
+
+// static
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKET_COUNT)
+        return index;
+
+    int shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t sub = index % SUB_BUCKET_COUNT;
+    uint64_t lower = (SUB_BUCKET_COUNT + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::addBucket(int index, uint64_t count, uint64_t sum, uint64_t max)
+{
+    DCHECK(0 <= index && index < NUM_BUCKETS) << index;
+    counts_[index] += count;
+    count_ += count;
+    sum_ += sum;
+    max_ = std::max(max_, max);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    if (count_ == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(ceil(p / 100 * count_));
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t accumulated = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        accumulated += counts_[i];
+        if (accumulated >= rank)
+            return std::min(bucketUpperBound(i), max_);
+    }
+    return max_;
+}
+
+// static
+int PhaseProfiler::registerPhase(const string& name)
+{
+    PhaseRegistry& r = registry();
+    lock_guard<mutex> lock(r.mu);
+    for (size_t i = 0; i < r.names.size(); ++i) {
+        if (r.names[i] == name)
+            return static_cast<int>(i);
+    }
+
+    CHECK_LT(r.names.size(), static_cast<size_t>(MAX_PHASES)) << "Too many phases: " << name;
+    r.names.push_back(name);
+    r.numPhases = static_cast<int>(r.names.size());
+    return r.numPhases - 1;
+}
+
+// static
+string PhaseProfiler::phaseName(int phase)
+{
+    PhaseRegistry& r = registry();
+    lock_guard<mutex> lock(r.mu);
+    return r.names[phase];
+}
+
+// static
+int PhaseProfiler::numPhases()
+{
+    return registry().numPhases;
+}
+
+// static
+bool PhaseProfiler::isEnabled()
+{
+    return FLAGS_phase_profile;
+}
+
+// static
+void PhaseProfiler::record(int phase, uint64_t cycles)
+{
+    DCHECK(0 <= phase && phase < MAX_PHASES) << phase;
+
+    ThreadHistograms* h = threadHistograms();
+    PhaseCounters* c = h->phases[phase].load(memory_order_relaxed);
+    if (!c) {
+        // Value-initialization makes all the counters zero.
+        c = new PhaseCounters();
+        h->phases[phase].store(c, memory_order_release);
+    }
+
+    increment(&c->counts[LatencyHistogram::bucketIndex(cycles)], 1);
+    increment(&c->sum, cycles);
+    if (c->max.load(memory_order_relaxed) < cycles)
+        c->max.store(cycles, memory_order_relaxed);
+}
+
+// static
+LatencyHistogram PhaseProfiler::histogram(int phase)
+{
+    LatencyHistogram result;
+    for (ThreadHistograms* h = g_histograms.load(memory_order_acquire); h; h = h->next) {
+        const PhaseCounters* c = h->phases[phase].load(memory_order_acquire);
+        if (!c)
+            continue;
+
+        LatencyHistogram histogram;
+        for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+            uint64_t count = c->counts[i].load(memory_order_relaxed);
+            if (count > 0)
+                histogram.addBucket(i, count, 0, 0);
+        }
+        histogram.addBucket(0, 0, c->sum.load(memory_order_relaxed), c->max.load(memory_order_relaxed));
+        result.merge(histogram);
+    }
+    return result;
+}
+
+// static
+string PhaseProfiler::toString()
+{
+    double rate = cyclesPerMicrosecond();
+    auto format = [rate](double cycles) {
+        ostringstream ss;
+        if (rate > 0)
+            ss << fixed << setprecision(1) << cycles / rate;
+        else
+            ss << static_cast<uint64_t>(cycles) << "c";
+        return ss.str();
+    };
+
+    ostringstream ss;
+    ss << left << setw(32) << "phase" << right
+       << setw(10) << "count" << setw(12) << "mean"
+       << setw(12) << "p50" << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "max"
+       << (rate > 0 ? "  [us]" : "  [cycles]") << '\n';
+    for (int phase = 0; phase < numPhases(); ++phase) {
+        LatencyHistogram h = histogram(phase);
+        ss << left << setw(32) << phaseName(phase) << right
+           << setw(10) << h.count()
+           << setw(12) << format(h.mean())
+           << setw(12) << format(h.percentile(50))
+           << setw(12) << format(h.percentile(90))
+           << setw(12) << format(h.percentile(99))
+           << setw(12) << format(h.max()) << '\n';
+    }
+    return ss.str();
+}
+
+// static
+bool PhaseProfiler::dumpToFile()
+{
+    if (FLAGS_phase_profile_dump_file.empty())
+        return true;
+
+    ofstream ofs(FLAGS_phase_profile_dump_file, ios::out | ios::trunc);
+    ofs << toString();
+    if (!ofs) {
+        LOG(WARNING) << "PhaseProfiler::dumpToFile failed: " << FLAGS_phase_profile_dump_file;
+        return false;
+    }
+    return true;
+}
+
+// static
+void PhaseProfiler::clear()
+{
+    for (ThreadHistograms* h = g_histograms.load(memory_order_acquire); h; h = h->next) {
+        for (int phase = 0; phase < MAX_PHASES; ++phase) {
+            PhaseCounters* c = h->phases[phase].load(memory_order_acquire);
+            if (!c)
+                continue;
+            for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i)
+                c->counts[i].store(0, memory_order_relaxed);
+            c->sum.store(0, memory_order_relaxed);
+            c->max.store(0, memory_order_relaxed);
+        }
+    }
+}
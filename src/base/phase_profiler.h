@@ -0,0 +1,97 @@
+#ifndef BASE_PHASE_PROFILER_H_
+#define BASE_PHASE_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "base/noncopyable.h"
+#include "base/time_stamp_counter.h"
+
+// LatencyHistogram is an HDR-style histogram. Values less than SUB_BUCKET_COUNT are
+// counted exactly. Larger values are counted in buckets whose width is 1/SUB_BUCKET_COUNT
+// of their power of 2, so the relative error is at most 1/SUB_BUCKET_COUNT for any value.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    static int bucketIndex(uint64_t value);
+    // Returns the largest value counted in the |index|-th bucket.
+    static uint64_t bucketUpperBound(int index);
+
+    LatencyHistogram() : counts_() {}
+
+    void add(uint64_t value) { addBucket(bucketIndex(value), 1, value, value); }
+    // Adds |count| values in the |index|-th bucket, whose sum is |sum| and max is |max|.
+    void addBucket(int index, uint64_t count, uint64_t sum, uint64_t max);
+    void merge(const LatencyHistogram&);
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    // Returns the |p|-th percentile (0 <= p <= 100) with the nearest-rank method.
+    // The value is the upper bound of the bucket, but not more than max().
+    uint64_t percentile(double p) const;
+
+private:
+    uint64_t counts_[NUM_BUCKETS];
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+// PhaseProfiler measures how long each phase of an algorithm takes with
+// ScopedPhaseTimer. The time stamp counter is recorded into a per-thread histogram
+// without any lock, and the histograms of all the threads are merged when they are read.
+// Recording is enabled with --phase_profile.
+class PhaseProfiler {
+public:
+    static const int MAX_PHASES = 16;
+
+    // Returns the id of the phase |name|. The same id is returned for the same name.
+    // Call this once and keep the id, e.g. in a function-local static variable.
+    static int registerPhase(const std::string& name);
+    static std::string phaseName(int phase);
+    static int numPhases();
+
+    static bool isEnabled();
+    static void record(int phase, uint64_t cycles);
+
+    // Returns the histogram of |phase| of all the threads in cycles.
+    static LatencyHistogram histogram(int phase);
+    // Returns the table of count, mean, p50, p90, p99 and max for each phase.
+    // The cycles are converted to microseconds with the measured clock rate.
+    static std::string toString();
+    // Writes toString() to --phase_profile_dump_file. Does nothing if it's empty.
+    static bool dumpToFile();
+
+    // Removes all the records. The phases are kept.
+    static void clear();
+};
+
+// Records the time from the construction to the destruction to |phase|.
+class ScopedPhaseTimer : noncopyable {
+public:
+    explicit ScopedPhaseTimer(int phase) :
+        phase_(phase),
+        start_(PhaseProfiler::isEnabled() ? readTimeStampCounter() : 0)
+    {
+    }
+
+    ~ScopedPhaseTimer()
+    {
+        if (!start_)
+            return;
+        unsigned long long end = readTimeStampCounter();
+        if (end > start_)
+            PhaseProfiler::record(phase_, end - start_);
+    }
+
+private:
+    int phase_;
+    unsigned long long start_;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "base/phase_profiler.h"
+
+#include <string>
+#include <thread>
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+DECLARE_bool(phase_profile);
+
+using namespace std;
+
+TEST(LatencyHistogramTest, bucketIndex)
+{
+    for (uint64_t v = 0; v < 16; ++v) {
+        EXPECT_EQ(static_cast<int>(v), LatencyHistogram::bucketIndex(v));
+        EXPECT_EQ(v, LatencyHistogram::bucketUpperBound(v));
+    }
+
+    EXPECT_EQ(16, LatencyHistogram::bucketIndex(16));
+    EXPECT_EQ(31, LatencyHistogram::bucketIndex(31));
+    EXPECT_EQ(32, LatencyHistogram::bucketIndex(32));
+    EXPECT_EQ(32, LatencyHistogram::bucketIndex(33));
+    EXPECT_EQ(33U, LatencyHistogram::bucketUpperBound(32));
+    EXPECT_EQ(LatencyHistogram::NUM_BUCKETS - 1, LatencyHistogram::bucketIndex(~0ULL));
+    EXPECT_EQ(~0ULL, LatencyHistogram::bucketUpperBound(LatencyHistogram::NUM_BUCKETS - 1));
+
+    // The relative error is at most 1/16.
+    for (uint64_t v = 1; v < (1ULL << 40); v = v * 3 + 1) {
+        uint64_t upper = LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketIndex(v));
+        EXPECT_LE(v, upper);
+        EXPECT_LE(upper - v, v / 16);
+    }
+}
+
+TEST(LatencyHistogramTest, percentile)
+{
+    LatencyHistogram h;
+    EXPECT_EQ(0U, h.percentile(50));
+
+    for (uint64_t v = 1; v <= 100; ++v)
+        h.add(v * 1000);
+
+    EXPECT_EQ(100U, h.count());
+    EXPECT_EQ(100000U, h.max());
+    EXPECT_DOUBLE_EQ(50500.0, h.mean());
+
+    uint64_t p50 = h.percentile(50);
+    EXPECT_LE(50000U, p50);
+    EXPECT_LE(p50, 50000U + 50000U / 16);
+    uint64_t p99 = h.percentile(99);
+    EXPECT_LE(99000U, p99);
+    EXPECT_LE(p99, 100000U);
+    EXPECT_EQ(100000U, h.percentile(100));
+
+    LatencyHistogram other;
+    other.add(200000);
+    h.merge(other);
+    EXPECT_EQ(101U, h.count());
+    EXPECT_EQ(200000U, h.percentile(100));
+}
+
+TEST(PhaseProfilerTest, registerPhase)
+{
+    int a = PhaseProfiler::registerPhase("test.a");
+    int b = PhaseProfiler::registerPhase("test.b");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, PhaseProfiler::registerPhase("test.a"));
+    EXPECT_EQ("test.b", PhaseProfiler::phaseName(b));
+}
+
+TEST(PhaseProfilerTest, recordFromThreads)
+{
+    int phase = PhaseProfiler::registerPhase("test.threads");
+    PhaseProfiler::clear();
+
+    PhaseProfiler::record(phase, 100);
+    thread th([phase]() {
+        for (int i = 0; i < 10; ++i)
+            PhaseProfiler::record(phase, 1000);
+    });
+    th.join();
+
+    LatencyHistogram h = PhaseProfiler::histogram(phase);
+    EXPECT_EQ(11U, h.count());
+    EXPECT_EQ(1000U, h.max());
+    EXPECT_LE(100U, h.percentile(0));
+    EXPECT_GE(100U + 100U / 16, h.percentile(0));
+
+    EXPECT_NE(string::npos, PhaseProfiler::toString().find("test.threads"));
+}
+
+TEST(PhaseProfilerTest, scopedPhaseTimer)
+{
+    int phase = PhaseProfiler::registerPhase("test.timer");
+    PhaseProfiler::clear();
+
+    FLAGS_phase_profile = false;
+    {
+        ScopedPhaseTimer timer(phase);
+    }
+    EXPECT_EQ(0U, PhaseProfiler::histogram(phase).count());
+
+    FLAGS_phase_profile = true;
+    {
+        ScopedPhaseTimer timer(phase);
+        this_thread::sleep_for(chrono::microseconds(10));
+    }
+    FLAGS_phase_profile = false;
+
+    if (readTimeStampCounter() == 0) {
+        // Nothing can be measured without the time stamp counter.
+        EXPECT_EQ(0U, PhaseProfiler::histogram(phase).count());
+    } else {
+        EXPECT_EQ(1U, PhaseProfiler::histogram(phase).count());
+    }
+}
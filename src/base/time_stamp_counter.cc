@@ -27,6 +27,11 @@ unsigned long long rdtsc()
 
 }
 
+unsigned long long readTimeStampCounter()
+{
+    return rdtsc();
+}
+
 void TimeStampCounterData::showStatistics() const
 {
     int n = data_.size();
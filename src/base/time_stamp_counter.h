@@ -3,6 +3,9 @@
 
 #include <vector>
 
+// Returns the current time stamp counter of the CPU. Returns 0 if not supported.
+unsigned long long readTimeStampCounter();
+
 class TimeStampCounterData {
 public:
     void showStatistics() const;
@@ -0,0 +1,250 @@
+#include "base/trace.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+using namespace std;
+
+DEFINE_string(trace_dump_file, "", "the file to dump the trace records to");
+
+namespace trace {
+
+namespace {
+
+const char* const EVENT_NAMES[] = {
+    "FRAME_RECEIVED",
+    "KEY_SET_SEQ",
+    "MESSAGE_SENT",
+    "MESSAGE_RECEIVED",
+};
+
+static_assert(sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]) == static_cast<size_t>(Event::NUM_EVENTS),
+              "EVENT_NAMES should have a name for each event");
+static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "RING_SIZE should be a power of 2");
+
+// A buffer is owned by one thread at a time. Buffers are never freed, so that
+// the records of finished threads can still be dumped, and a new thread reuses them.
+struct ThreadBuffer {
+    Record records[RING_SIZE];
+    // The number of records written so far.
+    atomic<uint64_t> count { 0 };
+    atomic<bool> inUse { true };
+    int index = 0;
+    ThreadBuffer* next = nullptr;
+};
+
+atomic<ThreadBuffer*> g_buffers { nullptr };
+atomic<int> g_numBuffers { 0 };
+
+ThreadBuffer* acquireBuffer()
+{
+    for (ThreadBuffer* b = g_buffers.load(memory_order_acquire); b; b = b->next) {
+        bool expected = false;
+        if (b->inUse.compare_exchange_strong(expected, true))
+            return b;
+    }
+
+    ThreadBuffer* b = new ThreadBuffer;
+    b->index = g_numBuffers++;
+    b->next = g_buffers.load(memory_order_relaxed);
+    while (!g_buffers.compare_exchange_weak(b->next, b)) {}
+    return b;
+}
+
+struct ThreadBufferHolder {
+    ThreadBufferHolder() : buffer(acquireBuffer()) {}
+    ~ThreadBufferHolder() { buffer->inUse = false; }
+
+    ThreadBuffer* buffer;
+};
+
+ThreadBuffer* threadBuffer()
+{
+    static thread_local ThreadBufferHolder holder;
+    return holder.buffer;
+}
+
+Record* startRecord(ThreadBuffer* b, Event event, int64_t value)
+{
+    Record* r = &b->records[b->count.load(memory_order_relaxed) & (RING_SIZE - 1)];
+    r->timestampNs = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+    r->event = event;
+    r->value = value;
+    r->value2 = 0;
+    r->textSize = 0;
+    return r;
+}
+
+// Publishes the record to dump().
+void finishRecord(ThreadBuffer* b)
+{
+    b->count.store(b->count.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Formatting helpers for dump(). They must be async-signal-safe, so snprintf
+// and memory allocation are not used.
+class LineWriter {
+public:
+    explicit LineWriter(int fd) : fd_(fd) {}
+
+    void append(const char* s, size_t n)
+    {
+        n = min(n, sizeof(buf_) - size_);
+        memcpy(buf_ + size_, s, n);
+        size_ += n;
+    }
+    void append(const char* s) { append(s, strlen(s)); }
+    void append(char c) { append(&c, 1); }
+
+    void appendInt(int64_t v, int minDigits = 1)
+    {
+        char tmp[24];
+        int n = 0;
+        bool negative = v < 0;
+        uint64_t u = negative ? -static_cast<uint64_t>(v) : v;
+        while (u > 0 || n < minDigits) {
+            tmp[n++] = '0' + u % 10;
+            u /= 10;
+        }
+        if (negative)
+            append('-');
+        while (n > 0)
+            append(tmp[--n]);
+    }
+
+    void flush()
+    {
+        size_t pos = 0;
+        while (pos < size_) {
+            ssize_t n = ::write(fd_, buf_ + pos, size_ - pos);
+            if (n <= 0)
+                break;
+            pos += n;
+        }
+        size_ = 0;
+    }
+
+private:
+    int fd_;
+    char buf_[256];
+    size_t size_ = 0;
+};
+
+struct sigaction g_oldActions[NSIG];
+atomic<bool> g_crashed { false };
+
+void crashHandler(int sig)
+{
+    if (!g_crashed.exchange(true)) {
+        LineWriter w(STDERR_FILENO);
+        w.append("*** trace records ***\n");
+        w.flush();
+        dump(STDERR_FILENO);
+    }
+
+    // The signal is raised again with the previous handler when this handler returns.
+    sigaction(sig, &g_oldActions[sig], nullptr);
+    raise(sig);
+}
+
+} // anonymous namespace
+
+const char* eventName(Event event)
+{
+    size_t i = static_cast<size_t>(event);
+    if (i >= static_cast<size_t>(Event::NUM_EVENTS))
+        return "UNKNOWN";
+    return EVENT_NAMES[i];
+}
+
+void record(Event event, int64_t value, int32_t value2)
+{
+    ThreadBuffer* b = threadBuffer();
+    Record* r = startRecord(b, event, value);
+    r->value2 = value2;
+    finishRecord(b);
+}
+
+void record(Event event, int64_t value, int32_t value2, const char* text, size_t size)
+{
+    ThreadBuffer* b = threadBuffer();
+    Record* r = startRecord(b, event, value);
+    r->value2 = value2;
+    r->textSize = static_cast<uint16_t>(min(size, Record::TEXT_SIZE));
+    memcpy(r->text, text, r->textSize);
+    finishRecord(b);
+}
+
+void dump(int fd)
+{
+    LineWriter w(fd);
+    for (ThreadBuffer* b = g_buffers.load(memory_order_acquire); b; b = b->next) {
+        uint64_t end = b->count.load(memory_order_acquire);
+        uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+        // The oldest records might be overwritten while dumping. It's OK for diagnostics.
+        for (uint64_t i = begin; i < end; ++i) {
+            const Record& r = b->records[i & (RING_SIZE - 1)];
+            w.append("[T");
+            w.appendInt(b->index);
+            w.append("] ");
+            w.appendInt(r.timestampNs / 1000000000);
+            w.append('.');
+            w.appendInt(r.timestampNs / 1000 % 1000000, 6);
+            w.append(' ');
+            w.append(eventName(r.event));
+            w.append(' ');
+            w.appendInt(r.value);
+            w.append(' ');
+            w.appendInt(r.value2);
+            if (r.textSize > 0) {
+                w.append(' ');
+                w.append(r.text, min<size_t>(r.textSize, Record::TEXT_SIZE));
+            }
+            w.append('\n');
+            w.flush();
+        }
+    }
+}
+
+void dumpToFile()
+{
+    if (FLAGS_trace_dump_file.empty())
+        return;
+
+    int fd = open(FLAGS_trace_dump_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        PLOG(ERROR) << "failed to open " << FLAGS_trace_dump_file;
+        return;
+    }
+    dump(fd);
+    close(fd);
+}
+
+void installCrashHandler()
+{
+    for (int sig : { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL }) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = crashHandler;
+        sigemptyset(&action.sa_mask);
+        sigaction(sig, &action, &g_oldActions[sig]);
+    }
+}
+
+void clear()
+{
+    for (ThreadBuffer* b = g_buffers.load(memory_order_acquire); b; b = b->next)
+        b->count = 0;
+}
+
+} // namespace trace
@@ -0,0 +1,61 @@
+#ifndef BASE_TRACE_H_
+#define BASE_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// trace records events on hot paths into a per-thread ring buffer in a fixed
+// binary form. Recording doesn't format, lock nor do I/O, so it can be used in
+// every frame. The buffers are dumped on demand with trace::dump(), or on crash
+// once trace::installCrashHandler() has been called.
+namespace trace {
+
+// Event IDs. Add a name to EVENT_NAMES in trace.cc when adding an event.
+enum class Event : uint16_t {
+    FRAME_RECEIVED,     // value: frame id, value2: elapsed time [us]
+    KEY_SET_SEQ,        // value: player id, value2: size, text: 2 hex digits per KeySet::toInt()
+    MESSAGE_SENT,       // value: file descriptor, text: message
+    MESSAGE_RECEIVED,   // value: file descriptor, text: message
+    NUM_EVENTS
+};
+
+struct Record {
+    static const size_t TEXT_SIZE = 36;
+
+    uint64_t timestampNs;  // monotonic clock
+    int64_t value;
+    int32_t value2;
+    Event event;
+    uint16_t textSize;     // text might be truncated.
+    char text[TEXT_SIZE];
+};
+
+// The number of records kept per thread. Must be a power of 2.
+const size_t RING_SIZE = 4096;
+
+const char* eventName(Event);
+
+void record(Event, int64_t value, int32_t value2 = 0);
+void record(Event, int64_t value, int32_t value2, const char* text, size_t size);
+inline void record(Event event, int64_t value, const std::string& text)
+{
+    record(event, value, 0, text.data(), text.size());
+}
+
+// Writes the records to |fd|, thread by thread. The records of a thread are in the
+// chronological order. This is async-signal-safe.
+void dump(int fd);
+// Writes the records to the file specified by --trace_dump_file. Does nothing if it's empty.
+void dumpToFile();
+
+// Dumps the records to stderr on SIGSEGV, SIGABRT, SIGBUS, SIGFPE or SIGILL,
+// then calls the previous handler. Call this after google::InstallFailureSignalHandler().
+void installCrashHandler();
+
+// Removes all the records. For testing.
+void clear();
+
+} // namespace trace
+
+#endif
@@ -0,0 +1,76 @@
+#include "base/trace.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+string dumpToString()
+{
+    FILE* fp = tmpfile();
+    trace::dump(fileno(fp));
+
+    string s;
+    rewind(fp);
+    char buf[1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        s.append(buf, n);
+    fclose(fp);
+    return s;
+}
+
+}
+
+TEST(TraceTest, record)
+{
+    trace::clear();
+    trace::record(trace::Event::FRAME_RECEIVED, 10, 345);
+    trace::record(trace::Event::MESSAGE_SENT, 0, string("ID=1 X=3 R=0"));
+
+    string s = dumpToString();
+    EXPECT_NE(string::npos, s.find(" FRAME_RECEIVED 10 345\n"));
+    EXPECT_NE(string::npos, s.find(" MESSAGE_SENT 0 0 ID=1 X=3 R=0\n"));
+    EXPECT_LT(s.find("FRAME_RECEIVED"), s.find("MESSAGE_SENT"));
+}
+
+TEST(TraceTest, truncated)
+{
+    trace::clear();
+    trace::record(trace::Event::MESSAGE_RECEIVED, 0, string(100, 'a'));
+
+    string s = dumpToString();
+    EXPECT_NE(string::npos, s.find(string(trace::Record::TEXT_SIZE, 'a') + "\n"));
+    EXPECT_EQ(string::npos, s.find(string(trace::Record::TEXT_SIZE + 1, 'a')));
+}
+
+TEST(TraceTest, ringBuffer)
+{
+    trace::clear();
+    for (size_t i = 0; i < trace::RING_SIZE + 10; ++i)
+        trace::record(trace::Event::FRAME_RECEIVED, i);
+
+    string s = dumpToString();
+    EXPECT_EQ(string::npos, s.find(" FRAME_RECEIVED 9 0\n"));
+    EXPECT_NE(string::npos, s.find(" FRAME_RECEIVED 10 0\n"));
+    EXPECT_NE(string::npos, s.find(" FRAME_RECEIVED " + to_string(trace::RING_SIZE + 9) + " 0\n"));
+}
+
+TEST(TraceTest, finishedThread)
+{
+    trace::clear();
+    thread th([]() {
+        trace::record(trace::Event::KEY_SET_SEQ, 1, string("v,v,A"));
+    });
+    th.join();
+
+    // The records of a finished thread are kept.
+    EXPECT_NE(string::npos, dumpToString().find(" KEY_SET_SEQ 1 0 v,v,A\n"));
+}
@@ -1,11 +1,16 @@
 #include "capture/ac_analyzer.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include <gflags/gflags.h>
+
 #include "capture/color.h"
+#include "capture/real_color_classifier.h"
 #include "gui/pixel_color.h"
 #include "gui/util.h"
 
@@ -15,6 +20,8 @@ DEFINE_double(bb_x, 69, "bouding box x");
 DEFINE_double(bb_y, 80, "bouding box y");
 DEFINE_double(bb_w, 32, "bouding box w");
 DEFINE_double(bb_h, 32, "bouding box h");
+DEFINE_bool(analyzer_skip_unchanged_boxes, true, "reuse the analysis of the boxes whose pixels are unchanged");
+DEFINE_int32(analyzer_unchanged_tolerance, 24, "the max difference of RGB values of the unchanged boxes");
 
 namespace {
 const int BOX_THRESHOLD = 70;
@@ -23,37 +30,20 @@ const int SMALLER_BOX_THRESHOLD = 20;
 const int SMALLER_BOX_THRESHOLD_HALF = 15;
 }
 
-static RealColor toRealColor(const HSV& hsv)
+// Returns true if the RealColors of |surface| can be counted with RealColorClassifier::countRowByTable.
+static bool toPixelLayout32(const SDL_Surface* surface, PixelLayout32* layout)
 {
-    if (hsv.v < 38)
-        return RealColor::RC_EMPTY;
-
-    if (hsv.s < 50 && 130 < hsv.v)
-        return RealColor::RC_OJAMA;
-
-    // The other colors are relatively easier. A bit tight range for now.
-    if ((hsv.h <= 15 || 350 < hsv.h) && 70 < hsv.v)
-        return RealColor::RC_RED;
-    if (35 <= hsv.h && hsv.h <= 75 && 90 < hsv.v)
-        return RealColor::RC_YELLOW;
-    if (85 <= hsv.h && hsv.h <= 135 && 70 < hsv.v)
-        return RealColor::RC_GREEN;
-    // Detecting blue is relatively hard. Let's have a relaxed margin.
-    if (180 <= hsv.h && hsv.h <= 255 && 60 < hsv.v)
-        return RealColor::RC_BLUE;
-    // Detecting purple is really hard. We'd like to have relaxed margin for purple.
-    if (290 <= hsv.h && hsv.h < 340 && 65 < hsv.v)
-        return RealColor::RC_PURPLE;
-
-    // Hard to distinguish RED and PURPLE.
-    if (340 <= hsv.h && hsv.h <= 350) {
-        if (160 < hsv.s + hsv.v)
-            return RealColor::RC_RED;
-        if (65 < hsv.v)
-            return RealColor::RC_PURPLE;
-    }
+    const SDL_PixelFormat* format = surface->format;
+    if (format->BytesPerPixel != 4 || format->Rloss != 0 || format->Gloss != 0 || format->Bloss != 0)
+        return false;
 
-    return RealColor::RC_EMPTY;
+    *layout = PixelLayout32(format->Rshift, format->Gshift, format->Bshift);
+    return true;
+}
+
+static bool isSameBox(const Box& lhs, const Box& rhs)
+{
+    return lhs.sx == rhs.sx && lhs.sy == rhs.sy && lhs.dx == rhs.dx && lhs.dy == rhs.dy;
 }
 
 static RealColor estimateRealColorFromColorCount(int colorCount[NUM_REAL_COLORS], int threshold,
@@ -103,6 +93,9 @@ ACAnalyzer::ACAnalyzer()
     BoundingBox::instance().setGenerator(FLAGS_bb_x, FLAGS_bb_y, FLAGS_bb_w, FLAGS_bb_h);
     BoundingBox::instance().setRegion(BoundingBox::Region::LEVEL_SELECT, Box(260, 256, 270, 280));
     BoundingBox::instance().setRegion(BoundingBox::Region::GAME_FINISHED, Box(292, 352, 420, 367));
+
+    // Build the table now not to delay the first frame.
+    RealColorClassifier::initializeTable();
 }
 
 ACAnalyzer::~ACAnalyzer()
@@ -115,28 +108,41 @@ BoxAnalyzeResult ACAnalyzer::analyzeBox(const SDL_Surface* surface, const Box& b
     int colorCount[3][NUM_REAL_COLORS] = { { 0 } };
 
     // We'd like to take padding 1 pixel.
-    for (int by = b.sy + 1; by <= b.dy - 1; ++by) {
-        for (int bx = b.sx + 1; bx <= b.dx - 1; ++bx) {
-            Uint32 c = getpixel(surface, bx, by);
-            Uint8 r, g, b;
-            SDL_GetRGB(c, surface->format, &r, &g, &b);
-
-            RGB rgb(r, g, b);
-            HSV hsv = rgb.toHSV();
-
-            RealColor rc = toRealColor(hsv);
-
-            if (showsColor) {
-                // TODO(mayah): stringstream?
-                char buf[240];
-                sprintf(buf, "%3d %3d : %3d %3d %3d : %7.3f %7.3f %7.3f : %s",
-                        by, bx, static_cast<int>(r), static_cast<int>(g), static_cast<int>(b),
-                        hsv.h, hsv.s, hsv.v, toString(rc).c_str());
-                cout << buf << endl;
+    // Count by the table row by row if possible. It gives the same result as the loop with getpixel.
+    PixelLayout32 layout(0, 0, 0);
+    if (!showsColor && toPixelLayout32(surface, &layout)) {
+        for (int by = b.sy + 1; by <= b.dy - 1; ++by) {
+            const Uint8* p = static_cast<const Uint8*>(surface->pixels) + by * surface->pitch;
+            const Uint32* row = reinterpret_cast<const Uint32*>(p) + b.sx + 1;
+            int rowCount[NUM_REAL_COLORS] = { 0 };
+            RealColorClassifier::countRowByTable(row, b.dx - b.sx - 1, layout, rowCount);
+            for (int i = 0; i < NUM_REAL_COLORS; ++i) {
+                colorCount[0][i] += rowCount[i];
+                colorCount[(by % 2) + 1][i] += rowCount[i];
+            }
+        }
+    } else {
+        for (int by = b.sy + 1; by <= b.dy - 1; ++by) {
+            for (int bx = b.sx + 1; bx <= b.dx - 1; ++bx) {
+                Uint32 c = getpixel(surface, bx, by);
+                Uint8 r, g, b;
+                SDL_GetRGB(c, surface->format, &r, &g, &b);
+
+                RealColor rc = RealColorClassifier::classifyByTable(r, g, b);
+
+                if (showsColor) {
+                    HSV hsv = RGB(r, g, b).toHSV();
+                    // TODO(mayah): stringstream?
+                    char buf[240];
+                    sprintf(buf, "%3d %3d : %3d %3d %3d : %7.3f %7.3f %7.3f : %s",
+                            by, bx, static_cast<int>(r), static_cast<int>(g), static_cast<int>(b),
+                            hsv.h, hsv.s, hsv.v, toString(rc).c_str());
+                    cout << buf << endl;
+                }
+
+                colorCount[0][static_cast<int>(rc)]++;
+                colorCount[(by % 2) + 1][static_cast<int>(rc)]++;
             }
-
-            colorCount[0][static_cast<int>(rc)]++;
-            colorCount[(by % 2) + 1][static_cast<int>(rc)]++;
         }
     }
 
@@ -167,6 +173,85 @@ BoxAnalyzeResult ACAnalyzer::analyzeBox(const SDL_Surface* surface, const Box& b
     return BoxAnalyzeResult(prc, vanishing);
 }
 
+// static
+vector<uint8_t> ACAnalyzer::sampleBox(const SDL_Surface* surface, const Box& b)
+{
+    vector<uint8_t> samples;
+    samples.reserve((b.w() / SAMPLE_STEP_X + 1) * (b.h() / SAMPLE_STEP_Y + 1) * 3);
+    for (int by = b.sy; by <= b.dy; by += SAMPLE_STEP_Y) {
+        for (int bx = b.sx; bx <= b.dx; bx += SAMPLE_STEP_X) {
+            Uint8 r, g, b;
+            SDL_GetRGB(getpixel(surface, bx, by), surface->format, &r, &g, &b);
+            samples.push_back(r);
+            samples.push_back(g);
+            samples.push_back(b);
+        }
+    }
+    return samples;
+}
+
+// static
+bool ACAnalyzer::isSimilarSamples(const vector<uint8_t>& lhs, const vector<uint8_t>& rhs, int tolerance)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (abs(lhs[i] - rhs[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+double ACAnalyzer::fieldBoxCacheHitRatio() const
+{
+    int numHits = fieldBoxCache_[0].numHits + fieldBoxCache_[1].numHits;
+    int numLookups = fieldBoxCache_[0].numLookups + fieldBoxCache_[1].numLookups;
+    return numLookups > 0 ? static_cast<double>(numHits) / numLookups : 0;
+}
+
+void ACAnalyzer::resetFieldBoxCacheStats()
+{
+    for (int pi = 0; pi < 2; ++pi) {
+        fieldBoxCache_[pi].numHits = 0;
+        fieldBoxCache_[pi].numLookups = 0;
+    }
+}
+
+// static
+bool ACAnalyzer::lookUpCache(const SDL_Surface* surface, const Box& b, CachedSamples* cache)
+{
+    vector<uint8_t> samples = sampleBox(surface, b);
+    if (cache->valid && isSameBox(cache->box, b) &&
+        isSimilarSamples(cache->samples, samples, FLAGS_analyzer_unchanged_tolerance)) {
+        return true;
+    }
+
+    cache->valid = true;
+    cache->box = b;
+    cache->samples.swap(samples);
+    return false;
+}
+
+BoxAnalyzeResult ACAnalyzer::analyzeBoxWithCache(const SDL_Surface* surface, const Box& b,
+                                                 ACAnalyzer::AllowOjama allowOjama,
+                                                 FieldBoxCache* fieldCache, int index) const
+{
+    if (!FLAGS_analyzer_skip_unchanged_boxes)
+        return analyzeBox(surface, b, allowOjama);
+
+    // analyzeBox() doesn't see the border of the box.
+    CachedBox* cache = &fieldCache->boxes[index];
+    ++fieldCache->numLookups;
+    if (lookUpCache(surface, Box(b.sx + 1, b.sy + 1, b.dx - 1, b.dy - 1), cache)) {
+        ++fieldCache->numHits;
+        return cache->result;
+    }
+
+    cache->result = analyzeBox(surface, b, allowOjama);
+    return cache->result;
+}
+
 CaptureGameState ACAnalyzer::detectGameState(const SDL_Surface* surface)
 {
     if (isLevelSelect(surface))
@@ -183,12 +268,14 @@ unique_ptr<DetectedField> ACAnalyzer::detectField(int pi,
                                                   const SDL_Surface* prevSurface)
 {
     unique_ptr<DetectedField> result(new DetectedField);
+    FieldBoxCache* fieldCache = &fieldBoxCache_[pi];
+    int index = 0;
 
     // detect field
     for (int y = 1; y <= 12; ++y) {
         for (int x = 1; x <= 6; ++x) {
             Box b = BoundingBox::instance().get(pi, x, y);
-            BoxAnalyzeResult r = analyzeBox(surface, b);
+            BoxAnalyzeResult r = analyzeBoxWithCache(surface, b, ACAnalyzer::AllowOjama::ALLOW_OJAMA, fieldCache, index++);
 
             result->field.set(x, y, r.realColor);
             result->vanishing.set(x, y, r.vanishing);
@@ -206,7 +293,7 @@ unique_ptr<DetectedField> ACAnalyzer::detectField(int pi,
 
         for (int i = 0; i < 4; ++i) {
             Box b = BoundingBox::instance().get(pi, np[i]);
-            BoxAnalyzeResult r = analyzeBox(surface, b, ACAnalyzer::AllowOjama::DONT_ALLOW_OJAMA);
+            BoxAnalyzeResult r = analyzeBoxWithCache(surface, b, ACAnalyzer::AllowOjama::DONT_ALLOW_OJAMA, fieldCache, index++);
             result->setRealColor(np[i], r.realColor);
         }
     }
@@ -215,9 +302,10 @@ unique_ptr<DetectedField> ACAnalyzer::detectField(int pi,
     {
         Box b = BoundingBox::instance().get(pi, NextPuyoPosition::NEXT1_AXIS);
         b = Box(b.sx, b.sy + b.h() / 2, b.dx, b.dy);
-        BoxAnalyzeResult r = analyzeBox(surface, b, ACAnalyzer::AllowOjama::DONT_ALLOW_OJAMA);
+        BoxAnalyzeResult r = analyzeBoxWithCache(surface, b, ACAnalyzer::AllowOjama::DONT_ALLOW_OJAMA, fieldCache, index++);
         result->next1AxisMoving = (r.realColor == RealColor::RC_EMPTY);
     }
+    DCHECK_EQ(NUM_CACHED_FIELD_BOXES, index);
 
     // detect ojama
     {
@@ -247,7 +335,7 @@ bool ACAnalyzer::detectOjamaDrop(const SDL_Surface* currentSurface,
             SDL_GetRGB(c1, currentSurface->format, &r1, &g1, &b1);
 
             // Since 3 SET MATCH etc. has RED or GREEN, we'd like to ignore them.
-            RealColor rc = toRealColor(RGB(r1, g1, b1).toHSV());
+            RealColor rc = RealColorClassifier::classify(RGB(r1, g1, b1).toHSV());
             if (rc == RealColor::RC_RED || rc == RealColor::RC_GREEN)
                 continue;
 
@@ -273,29 +361,22 @@ bool ACAnalyzer::detectOjamaDrop(const SDL_Surface* currentSurface,
 bool ACAnalyzer::isLevelSelect(const SDL_Surface* surface)
 {
     Box b = BoundingBox::instance().getBy(BoundingBox::Region::LEVEL_SELECT);
-
-    int whiteCount = 0;
-    for (int bx = b.sx; bx <= b.dx; ++bx) {
-        for (int by = b.sy; by <= b.dy; ++by) {
-            Uint32 c = getpixel(surface, bx, by);
-            Uint8 r, g, b;
-            SDL_GetRGB(c, surface->format, &r, &g, &b);
-
-            RGB rgb(r, g, b);
-            HSV hsv = rgb.toHSV();
-            RealColor rc = toRealColor(hsv);
-
-            if (rc == RealColor::RC_OJAMA)
-                ++whiteCount;
-        }
-    }
-
-    return whiteCount >= 40;
+    return countWhite(surface, b, 40, &levelSelectCache_);
 }
 
 bool ACAnalyzer::isGameFinished(const SDL_Surface* surface)
 {
     Box b = BoundingBox::instance().getBy(BoundingBox::Region::GAME_FINISHED);
+    return countWhite(surface, b, 50, &gameFinishedCache_);
+}
+
+// Returns true if |b| has |threshold| or more white pixels.
+bool ACAnalyzer::countWhite(const SDL_Surface* surface, const Box& b, int threshold, CachedRegion* cache) const
+{
+    if (!FLAGS_analyzer_skip_unchanged_boxes)
+        cache->valid = false;
+    else if (lookUpCache(surface, b, cache))
+        return cache->result;
 
     int whiteCount = 0;
     for (int bx = b.sx; bx <= b.dx; ++bx) {
@@ -306,14 +387,15 @@ bool ACAnalyzer::isGameFinished(const SDL_Surface* surface)
 
             RGB rgb(r, g, b);
             HSV hsv = rgb.toHSV();
-            RealColor rc = toRealColor(hsv);
+            RealColor rc = RealColorClassifier::classify(hsv);
 
             if (rc == RealColor::RC_OJAMA)
                 ++whiteCount;
         }
     }
 
-    return whiteCount >= 50;
+    cache->result = whiteCount >= threshold;
+    return cache->result;
 }
 
 void ACAnalyzer::drawWithAnalysisResult(SDL_Surface* surface)
@@ -354,7 +436,7 @@ void ACAnalyzer::drawBoxWithAnalysisResult(SDL_Surface* surface, const Box& box)
             RGB rgb(r, g, b);
             HSV hsv = rgb.toHSV();
 
-            RealColor rc = toRealColor(hsv);
+            RealColor rc = RealColorClassifier::classify(hsv);
             putpixel(surface, bx, by, toPixelColor(surface, rc));
         }
     }
@@ -363,5 +445,5 @@ void ACAnalyzer::drawBoxWithAnalysisResult(SDL_Surface* surface, const Box& box)
 // static
 RealColor ACAnalyzer::estimateRealColor(const HSV& hsv)
 {
-    return toRealColor(hsv);
+    return RealColorClassifier::classify(hsv);
 }
@@ -1,6 +1,9 @@
 #ifndef CAPTURE_AC_ANALYZER_H_
 #define CAPTURE_AC_ANALYZER_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "base/base.h"
 #include "capture/analyzer.h"
 #include "gui/bounding_box.h"  // TODO(mayah): Consider removing this
@@ -33,15 +36,68 @@ public:
 
     static RealColor estimateRealColor(const HSV&);
 
+    // Samples the RGB of the pixels in |box| every SAMPLE_STEP_X pixels horizontally and
+    // every SAMPLE_STEP_Y pixels vertically. SAMPLE_STEP_Y is odd, so that both the fields of
+    // interlaced video are sampled. A moving puyo often appears only in one of them.
+    static const int SAMPLE_STEP_X = 4;
+    static const int SAMPLE_STEP_Y = 3;
+    static std::vector<uint8_t> sampleBox(const SDL_Surface*, const Box&);
+    // Returns true if all the samples differ by |tolerance| or less. Analog video has noise,
+    // so the pixels of an unchanged box are not the same in 2 frames.
+    static bool isSimilarSamples(const std::vector<uint8_t>&, const std::vector<uint8_t>&, int tolerance);
+
+    // The ratio of the field boxes whose analyses are reused. Returns 0 if nothing is analyzed.
+    double fieldBoxCacheHitRatio() const;
+    void resetFieldBoxCacheStats();
+
 private:
+    // The boxes analyzed in detectField(): 6x12 field cells, 4 NEXT cells and the NEXT1 move box.
+    static const int NUM_CACHED_FIELD_BOXES = 6 * 12 + 4 + 1;
+
+    // Remembers the samples of a box in the frame it's analyzed in, so that the box is not
+    // analyzed again while its pixels stay similar to them. The samples are not updated
+    // on hits, so that slow drift doesn't accumulate.
+    struct CachedSamples {
+        bool valid = false;
+        Box box;
+        std::vector<uint8_t> samples;
+    };
+
+    struct CachedBox : public CachedSamples {
+        BoxAnalyzeResult result = BoxAnalyzeResult(RealColor::RC_EMPTY, false);
+    };
+
+    struct CachedRegion : public CachedSamples {
+        bool result = false;
+    };
+
+    struct FieldBoxCache {
+        CachedBox boxes[NUM_CACHED_FIELD_BOXES];
+        int numHits = 0;
+        int numLookups = 0;
+    };
+
     virtual CaptureGameState detectGameState(const SDL_Surface*) override;
     virtual std::unique_ptr<DetectedField> detectField(int pi, const SDL_Surface* current, const SDL_Surface* prev) override;
     bool detectOjamaDrop(const SDL_Surface* current, const SDL_Surface* prev, const Box&);
 
+    // Returns true if |cache| is for |b| and the pixels of |b| are similar to its samples.
+    // Otherwise, |cache| takes the samples of |b|, and the caller should set its result.
+    static bool lookUpCache(const SDL_Surface*, const Box& b, CachedSamples* cache);
+
+    BoxAnalyzeResult analyzeBoxWithCache(const SDL_Surface*, const Box&, AllowOjama, FieldBoxCache*, int index) const;
+
     bool isLevelSelect(const SDL_Surface*);
     bool isGameFinished(const SDL_Surface*);
+    bool countWhite(const SDL_Surface*, const Box&, int threshold, CachedRegion*) const;
 
     void drawBoxWithAnalysisResult(SDL_Surface*, const Box&);
+
+    // Indexed by the player. detectField() of a player touches only the cache of the player,
+    // so the fields of 2 players can be detected in parallel.
+    FieldBoxCache fieldBoxCache_[2];
+    CachedRegion levelSelectCache_;
+    CachedRegion gameFinishedCache_;
 };
 
 #endif
@@ -0,0 +1,226 @@
+#include "capture/ac_analyzer.h"
+
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <SDL_image.h>
+
+#include "base/time_stamp_counter.h"
+#include "capture/real_color_classifier.h"
+#include "gui/bounding_box.h"
+#include "gui/unique_sdl_surface.h"
+
+using namespace std;
+
+DECLARE_string(testdata_dir);
+DECLARE_bool(analyzer_skip_unchanged_boxes);
+
+namespace {
+
+const char* const FRAMES[] = {
+    "/somagic/field-another1.png",
+    "/somagic/field-another2.png",
+    "/somagic/field-moving1.png",
+    "/somagic/field-normal1.png",
+    "/somagic/field-normal2.png",
+    "/somagic/field-normal3.png",
+    "/somagic/field-normal4.png",
+    "/somagic/field-normal5.png",
+    "/somagic/field-normal6.png",
+    "/somagic/field-normal7.png",
+    "/somagic/field-normal8.png",
+    "/somagic/field-normal9.png",
+    "/somagic/field-zenkeshi.png",
+    "/somagic/vanishing-green.png",
+    "/somagic/vanishing-red-yellow.png",
+    "/somagic/zenkeshi-extreme.png",
+};
+
+vector<UniqueSDLSurface> loadFrames()
+{
+    vector<UniqueSDLSurface> surfaces;
+    for (const char* frame : FRAMES) {
+        string filename = FLAGS_testdata_dir + frame;
+        UniqueSDLSurface surface(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+        CHECK(surface.get()) << "Failed to load " << filename;
+        surfaces.push_back(move(surface));
+    }
+    return surfaces;
+}
+
+// Consecutive frames recorded from analog video.
+const char* const RECORDED_FRAME_DIRS[] = {
+    "/somagic/chigiri",
+    "/somagic/game-start",
+    "/somagic/next-arrival",
+    "/somagic/next-arrival-irregular",
+    "/somagic/next-arrival-sousai",
+    "/somagic/next-arrival-sousai-2",
+    "/somagic/nonfastmove",
+    "/somagic/ojama-drop-2p",
+    "/somagic/vanish-after-ojama-drop-2p",
+    "/somagic/vanishing",
+};
+
+vector<UniqueSDLSurface> loadRecordedFrames(const char* dir)
+{
+    vector<UniqueSDLSurface> surfaces;
+    for (int i = 0; ; ++i) {
+        char buf[80];
+        sprintf(buf, "%s/frame%02d.png", dir, i);
+        string filename = FLAGS_testdata_dir + buf;
+        UniqueSDLSurface surface(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+        if (!surface.get())
+            break;
+        surfaces.push_back(move(surface));
+    }
+    CHECK(!surfaces.empty()) << "Failed to load " << dir;
+    return surfaces;
+}
+
+typedef void (*CountRowFunc)(const uint32_t*, int, const PixelLayout32&, int[NUM_REAL_COLORS]);
+
+// Counts the colors of all the field cells like ACAnalyzer::analyzeBox does.
+void countField(const SDL_Surface* surface, CountRowFunc countRow, int colorCount[NUM_REAL_COLORS])
+{
+    const SDL_PixelFormat* format = surface->format;
+    PixelLayout32 layout(format->Rshift, format->Gshift, format->Bshift);
+    for (int pi = 0; pi < 2; ++pi) {
+        for (int y = 1; y <= 12; ++y) {
+            for (int x = 1; x <= 6; ++x) {
+                Box b = BoundingBox::instance().get(pi, x, y);
+                for (int by = b.sy + 1; by <= b.dy - 1; ++by) {
+                    const Uint8* p = static_cast<const Uint8*>(surface->pixels) + by * surface->pitch;
+                    countRow(reinterpret_cast<const Uint32*>(p) + b.sx + 1, b.dx - b.sx - 1, layout, colorCount);
+                }
+            }
+        }
+    }
+}
+
+}
+
+TEST(ACAnalyzerPerformanceTest, analyze)
+{
+    vector<UniqueSDLSurface> surfaces = loadFrames();
+    ACAnalyzer analyzer;
+
+    TimeStampCounterData tsc;
+    for (int i = 0; i < 10; ++i) {
+        for (const auto& surface : surfaces) {
+            ScopedTimeStampCounter stsc(&tsc);
+            (void)analyzer.analyze(surface.get(), nullptr, deque<unique_ptr<AnalyzerResult>>());
+        }
+    }
+
+    cout << "analyze per frame:" << endl;
+    tsc.showStatistics();
+}
+
+TEST(ACAnalyzerPerformanceTest, analyzeRecordedFrames)
+{
+    // Analyzes the recorded frames in order, so that the boxes unchanged from the previous
+    // frames are reused in spite of the noise of analog video.
+    TimeStampCounterData cachedTsc;
+    TimeStampCounterData uncachedTsc;
+    int numFrames = 0;
+    int numDifferentFrames = 0;
+    double hitRatioSum = 0;
+    for (const char* dir : RECORDED_FRAME_DIRS) {
+        vector<UniqueSDLSurface> surfaces = loadRecordedFrames(dir);
+        ACAnalyzer cachedAnalyzer;
+        ACAnalyzer uncachedAnalyzer;
+        for (const auto& surface : surfaces) {
+            unique_ptr<AnalyzerResult> cached;
+            unique_ptr<AnalyzerResult> uncached;
+
+            cachedAnalyzer.resetFieldBoxCacheStats();
+            {
+                ScopedTimeStampCounter stsc(&cachedTsc);
+                cached = cachedAnalyzer.analyze(surface.get(), nullptr, deque<unique_ptr<AnalyzerResult>>());
+            }
+            hitRatioSum += cachedAnalyzer.fieldBoxCacheHitRatio();
+
+            FLAGS_analyzer_skip_unchanged_boxes = false;
+            {
+                ScopedTimeStampCounter stsc(&uncachedTsc);
+                uncached = uncachedAnalyzer.analyze(surface.get(), nullptr, deque<unique_ptr<AnalyzerResult>>());
+            }
+            FLAGS_analyzer_skip_unchanged_boxes = true;
+
+            ++numFrames;
+            if (cached->playerResult(0)->toString() != uncached->playerResult(0)->toString() ||
+                cached->playerResult(1)->toString() != uncached->playerResult(1)->toString()) {
+                ++numDifferentFrames;
+            }
+        }
+    }
+
+    cout << "analyze per recorded frame with unchanged boxes reused:" << endl;
+    cachedTsc.showStatistics();
+    cout << "analyze per recorded frame:" << endl;
+    uncachedTsc.showStatistics();
+    cout << "field box cache hit ratio: " << hitRatioSum / numFrames << endl;
+    cout << "frames analyzed differently: " << numDifferentFrames << " / " << numFrames << endl;
+}
+
+TEST(ACAnalyzerPerformanceTest, countField)
+{
+    vector<UniqueSDLSurface> surfaces = loadFrames();
+    // Sets up BoundingBox.
+    ACAnalyzer analyzer;
+
+    TimeStampCounterData tableTsc;
+    TimeStampCounterData simdTsc;
+    TimeStampCounterData scalarTsc;
+    for (int i = 0; i < 10; ++i) {
+        for (const auto& surface : surfaces) {
+            ASSERT_EQ(4, surface->format->BytesPerPixel);
+
+            int tableCount[NUM_REAL_COLORS] {};
+            int simdCount[NUM_REAL_COLORS] {};
+            int scalarCount[NUM_REAL_COLORS] {};
+            {
+                ScopedTimeStampCounter stsc(&tableTsc);
+                countField(surface.get(), RealColorClassifier::countRowByTable, tableCount);
+            }
+            {
+                ScopedTimeStampCounter stsc(&simdTsc);
+                countField(surface.get(), RealColorClassifier::countRow, simdCount);
+            }
+            {
+                ScopedTimeStampCounter stsc(&scalarTsc);
+                countField(surface.get(), RealColorClassifier::countRowScalar, scalarCount);
+            }
+
+            for (int j = 0; j < NUM_REAL_COLORS; ++j) {
+                EXPECT_EQ(scalarCount[j], tableCount[j]);
+                EXPECT_EQ(scalarCount[j], simdCount[j]);
+            }
+        }
+    }
+
+    cout << "countRowByTable per frame:" << endl;
+    tableTsc.showStatistics();
+    cout << "countRow per frame:" << endl;
+    simdTsc.showStatistics();
+    cout << "countRowScalar per frame:" << endl;
+    scalarTsc.showStatistics();
+}
+
+int main(int argc, char* argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    testing::InitGoogleTest(&argc, argv);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    SDL_Init(SDL_INIT_VIDEO);
+    int r = RUN_ALL_TESTS();
+    SDL_Quit();
+    return r;
+}
@@ -8,9 +8,11 @@
 #include <SDL_image.h>
 
 #include "capture/color.h"
+#include "capture/real_color_classifier.h"
 #include "core/next_puyo.h"
 #include "core/real_color.h"
 #include "gui/unique_sdl_surface.h"
+#include "gui/util.h"
 
 using namespace std;
 
@@ -105,6 +107,10 @@ TEST_F(ACAnalyzerTest, estimateRealColor)
             << " actual=" << toString(ACAnalyzer::estimateRealColor(testcases[i].rgb.toHSV()))
             << " RGB=" << testcases[i].rgb.toString()
             << " HSV=" << testcases[i].rgb.toHSV().toString();
+
+        const RGB& rgb = testcases[i].rgb;
+        EXPECT_EQ(testcases[i].expected, RealColorClassifier::classifyByTable(rgb.r, rgb.g, rgb.b))
+            << " RGB=" << rgb.toString();
     }
 }
 
@@ -157,6 +163,78 @@ TEST_F(ACAnalyzerTest, analyzeFieldNormal6)
     EXPECT_EQ(RealColor::RC_EMPTY,  r->playerResult(0)->adjustedField.realColor(6, 2));
 }
 
+TEST_F(ACAnalyzerTest, analyzeWithUnchangedBoxes)
+{
+    const char* const filenames[] = {
+        "/somagic/field-normal1.png",
+        "/somagic/field-normal6.png",
+        "/somagic/field-normal6.png",
+        "/somagic/field-normal1.png",
+    };
+
+    // The analyzer reuses the results of the boxes unchanged from the previous frame.
+    // They should be the same as the results of a fresh analyzer.
+    ACAnalyzer analyzer;
+    for (const char* imgFilename : filenames) {
+        string filename = FLAGS_testdata_dir + imgFilename;
+        UniqueSDLSurface surf(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+        CHECK(surf.get()) << "Failed to load " << filename;
+
+        unique_ptr<AnalyzerResult> expected = analyze(imgFilename);
+        unique_ptr<AnalyzerResult> actual = analyzer.analyze(surf.get(), nullptr, deque<unique_ptr<AnalyzerResult>>());
+        EXPECT_EQ(expected->state(), actual->state()) << imgFilename;
+        for (int pi = 0; pi < 2; ++pi)
+            EXPECT_EQ(expected->playerResult(pi)->toString(), actual->playerResult(pi)->toString()) << imgFilename;
+    }
+}
+
+TEST_F(ACAnalyzerTest, analyzeRecordedFramesWithUnchangedBoxes)
+{
+    // The 2P blue puyos are falling in frame 03. They appear only in the odd lines of
+    // the interlaced video, and later frames have nearly the same pixels in the even lines.
+    ACAnalyzer analyzer;
+    for (int i = 0; i <= 19; ++i) {
+        char buf[80];
+        sprintf(buf, "/somagic/chigiri/frame%02d.png", i);
+        string filename = FLAGS_testdata_dir + buf;
+        UniqueSDLSurface surf(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+        CHECK(surf.get()) << "Failed to load " << filename;
+
+        unique_ptr<AnalyzerResult> expected = analyze(buf);
+        unique_ptr<AnalyzerResult> actual = analyzer.analyze(surf.get(), nullptr, deque<unique_ptr<AnalyzerResult>>());
+        for (int pi = 0; pi < 2; ++pi)
+            EXPECT_EQ(expected->playerResult(pi)->toString(), actual->playerResult(pi)->toString()) << buf;
+    }
+
+    // Most of the boxes are reused in spite of the noise of the video.
+    EXPECT_LT(0.5, analyzer.fieldBoxCacheHitRatio());
+}
+
+TEST_F(ACAnalyzerTest, sampleBox)
+{
+    string filename = FLAGS_testdata_dir + "/somagic/field-normal1.png";
+    UniqueSDLSurface surf(makeUniqueSDLSurface(IMG_Load(filename.c_str())));
+    CHECK(surf.get()) << "Failed to load " << filename;
+
+    ACAnalyzer analyzer;
+    Box b = BoundingBox::instance().get(0, 3, 1);
+    vector<uint8_t> samples = ACAnalyzer::sampleBox(surf.get(), b);
+    EXPECT_TRUE(ACAnalyzer::isSimilarSamples(samples, ACAnalyzer::sampleBox(surf.get(), b), 0));
+
+    // A little noise is tolerated.
+    int x = b.sx + ACAnalyzer::SAMPLE_STEP_X;
+    int y = b.sy + ACAnalyzer::SAMPLE_STEP_Y;
+    Uint8 r, g, bl;
+    SDL_GetRGB(getpixel(surf.get(), x, y), surf->format, &r, &g, &bl);
+    putpixel(surf.get(), x, y, SDL_MapRGB(surf->format, r ^ 8, g, bl));
+    EXPECT_FALSE(ACAnalyzer::isSimilarSamples(samples, ACAnalyzer::sampleBox(surf.get(), b), 0));
+    EXPECT_TRUE(ACAnalyzer::isSimilarSamples(samples, ACAnalyzer::sampleBox(surf.get(), b), 8));
+
+    // A real change is not.
+    putpixel(surf.get(), x, y, SDL_MapRGB(surf->format, r ^ 0x80, g, bl));
+    EXPECT_FALSE(ACAnalyzer::isSimilarSamples(samples, ACAnalyzer::sampleBox(surf.get(), b), 24));
+}
+
 TEST_F(ACAnalyzerTest, analyzeFieldNormal7)
 {
     unique_ptr<AnalyzerResult> r = analyze("/somagic/field-normal7.png");
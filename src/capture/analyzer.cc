@@ -2,6 +2,8 @@
 
 #include <queue>
 
+#include "base/executor.h"
+#include "base/wait_group.h"
 #include "core/constant.h"
 
 using namespace std;
@@ -142,9 +144,40 @@ std::unique_ptr<AnalyzerResult> Analyzer::analyze(const SDL_Surface* surface,
                                                   const SDL_Surface* prevSurface,
                                                   const deque<unique_ptr<AnalyzerResult>>& previousResults)
 {
-    auto gameState = detectGameState(surface);
-    auto player1FieldResult = detectField(0, surface, prevSurface);
-    auto player2FieldResult = detectField(1, surface, prevSurface);
+    unique_ptr<DetectedFrame> detected = detect(surface, prevSurface);
+    return analyzeDetectedFrame(*detected, previousResults);
+}
+
+unique_ptr<DetectedFrame> Analyzer::detect(const SDL_Surface* surface, const SDL_Surface* prevSurface)
+{
+    unique_ptr<DetectedFrame> detected(new DetectedFrame);
+
+    WaitGroup wg;
+    if (executor_) {
+        wg.add(1);
+        executor_->submit([&]() {
+            detected->fields[1] = detectField(1, surface, prevSurface);
+            wg.done();
+        });
+    }
+
+    detected->gameState = detectGameState(surface);
+    detected->fields[0] = detectField(0, surface, prevSurface);
+
+    if (executor_)
+        wg.waitUntilDone();
+    else
+        detected->fields[1] = detectField(1, surface, prevSurface);
+
+    return detected;
+}
+
+unique_ptr<AnalyzerResult> Analyzer::analyzeDetectedFrame(const DetectedFrame& detected,
+                                                          const deque<unique_ptr<AnalyzerResult>>& previousResults)
+{
+    const CaptureGameState gameState = detected.gameState;
+    const DetectedField* player1FieldResult = detected.fields[0].get();
+    const DetectedField* player2FieldResult = detected.fields[1].get();
 
     switch (gameState) {
     case CaptureGameState::UNKNOWN: {
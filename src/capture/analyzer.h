@@ -17,6 +17,8 @@
 #include "gui/bounding_box.h"
 #include "capture/real_color_field.h"
 
+class Executor;
+
 // TODO(mayah): Should be renamed?
 enum class CaptureGameState {
     UNKNOWN,
@@ -152,17 +154,37 @@ private:
     std::unique_ptr<PlayerAnalyzerResult> playerResults_[2];
 };
 
+// The fields and the game state detected from a frame.
+struct DetectedFrame {
+    CaptureGameState gameState = CaptureGameState::UNKNOWN;
+    std::unique_ptr<DetectedField> fields[2];
+};
+
 class Analyzer {
 public:
     virtual ~Analyzer() {}
 
     // Analyzes the specified frame. previousResults.front() should be the most recent results.
+    // This is the same as detect() followed by analyzeDetectedFrame().
     std::unique_ptr<AnalyzerResult> analyze(const SDL_Surface* current,
                                             const SDL_Surface* prev,
                                             const std::deque<std::unique_ptr<AnalyzerResult>>& previousResults);
 
+    // Detects the game state and the fields of |current|. This doesn't depend on the previous
+    // results, so different frames can be detected in parallel with different analyzers.
+    std::unique_ptr<DetectedFrame> detect(const SDL_Surface* current, const SDL_Surface* prev);
+    // Makes the result from the detected frame. This depends on the previous results,
+    // so the frames should be passed in order.
+    std::unique_ptr<AnalyzerResult> analyzeDetectedFrame(const DetectedFrame&,
+                                                         const std::deque<std::unique_ptr<AnalyzerResult>>& previousResults);
+
+    // When |executor| is set, the fields of 2 players are detected in parallel.
+    // Does not take the ownership. nullptr means detecting them sequentially.
+    void setExecutor(Executor* executor) { executor_ = executor; }
+
 protected:
     // These methods should be implemented in the derived class.
+    // detectField() should be thread-safe, since it can be called from the executor.
     virtual CaptureGameState detectGameState(const SDL_Surface*) = 0;
     virtual std::unique_ptr<DetectedField> detectField(int pi, const SDL_Surface* current, const SDL_Surface* prev) = 0;
 
@@ -189,6 +211,8 @@ private:
     void analyzeFieldForLevelSelect(const DetectedField&, PlayerAnalyzerResult*);
 
     int countVanishing(const RealColorField&, const FieldBitField& vanishing);
+
+    Executor* executor_ = nullptr;
 };
 
 #endif
@@ -14,14 +14,27 @@ AnalyzerResultDrawer::AnalyzerResultDrawer(AnalyzerResultRetriever* retriever) :
 {
 }
 
+AnalyzerResultDrawer::~AnalyzerResultDrawer()
+{
+}
+
+bool AnalyzerResultDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    // The result is taken once a frame, since draw() might be called several times.
+    // It's drawn only in the main box, but we cannot tell whether it has changed.
+    result_ = retriever_->analyzerResult();
+    rects->push_back(screen->mainBox());
+    return true;
+}
+
 void AnalyzerResultDrawer::draw(Screen* screen)
 {
     SDL_Surface* surface = screen->surface();
     if (!surface)
         return;
 
-    unique_ptr<AnalyzerResult> result(retriever_->analyzerResult());
-    if (!result.get())
+    const AnalyzerResult* result = result_.get();
+    if (!result)
         return;
 
     CHECK_EQ(SDL_LockSurface(surface), 0);
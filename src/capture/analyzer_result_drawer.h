@@ -2,6 +2,7 @@
 #define CAPTURE_ANALYZER_RESULT_DRAWER
 
 #include <memory>
+#include <vector>
 
 #include "base/base.h"
 #include "gui/drawer.h"
@@ -20,11 +21,15 @@ class AnalyzerResultDrawer : public Drawer {
 public:
     // Don't take ownership of Capture.
     explicit AnalyzerResultDrawer(AnalyzerResultRetriever*);
+    virtual ~AnalyzerResultDrawer();
 
+    bool addDirtyRects(Screen*, std::vector<Box>*) override;
     void draw(Screen*) override;
 
 private:
     AnalyzerResultRetriever* retriever_;
+    // The result drawn in the current frame.
+    std::unique_ptr<AnalyzerResult> result_;
 };
 
 #endif
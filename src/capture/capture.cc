@@ -1,39 +1,82 @@
 #include "capture/capture.h"
 
+#include <glog/logging.h>
+
 #include "capture/source.h"
 #include "gui/screen.h"
 #include "gui/SDL_prims.h"
 
 using namespace std;
 
+namespace {
+
+// When the analysis is slower than the source for a while, the oldest frame is dropped
+// not to block the source.
+const size_t MAX_QUEUED_FRAMES = 4;
+
+// The number of the previous results passed to the analyzer.
+const size_t MAX_PREVIOUS_RESULTS = 10;
+
+}
+
 Capture::Capture(Source* source, Analyzer* analyzer) :
     source_(source),
     analyzer_(analyzer),
+    executor_(1),
     shouldStop_(false),
-    surface_(makeUniqueSDLSurface(nullptr))
+    numDroppedFrames_(0)
+{
+}
+
+Capture::~Capture()
 {
+    stop();
 }
 
 bool Capture::start()
 {
-    th_ = thread([this](){
-        this->runLoop();
+    // Executor cannot be restarted, so neither can Capture.
+    if (started_ || shouldStop_)
+        return false;
+    started_ = true;
+
+    executor_.start();
+    analyzer_->setExecutor(&executor_);
+
+    analysisThread_ = thread([this]() {
+        this->runAnalysisLoop();
+    });
+    captureThread_ = thread([this]() {
+        this->runCaptureLoop();
     });
-    th_.detach();
     return true;
 }
 
 void Capture::stop()
 {
-    shouldStop_ = true;
-    if (th_.joinable())
-        th_.join();
+    // Called from the destructor even if start() has not been called.
+    if (!started_)
+        return;
+    started_ = false;
+
+    {
+        lock_guard<mutex> lock(queueMu_);
+        shouldStop_ = true;
+    }
+    queueCondVar_.notify_all();
+
+    if (captureThread_.joinable())
+        captureThread_.join();
+    if (analysisThread_.joinable())
+        analysisThread_.join();
+
+    analyzer_->setExecutor(nullptr);
+    executor_.stop();
 }
 
-void Capture::runLoop()
+void Capture::runCaptureLoop()
 {
     int frameId = 0;
-    UniqueSDLSurface prevSurface(emptyUniqueSDLSurface());
 
     while (!shouldStop_) {
         UniqueSDLSurface surface(source_->getNextFrame());
@@ -43,30 +86,86 @@ void Capture::runLoop()
         // We set frameId to surface's userdata. This will be useful for saving screen shot.
         surface->userdata = reinterpret_cast<void*>(static_cast<uintptr_t>(++frameId));
 
-        lock_guard<mutex> lock(mu_);
-        unique_ptr<AnalyzerResult> r = analyzer_->analyze(surface.get(), prevSurface.get(), results_);
-        prevSurface = move(surface_);
-        surface_ = move(surface);
-        results_.push_front(move(r));
-        while (results_.size() > 10)
-            results_.pop_back();
+        {
+            lock_guard<mutex> lock(queueMu_);
+            if (queue_.size() >= MAX_QUEUED_FRAMES) {
+                source_->recycleFrame(move(queue_.front()));
+                queue_.pop_front();
+                ++numDroppedFrames_;
+                LOG(WARNING) << "Capture dropped a frame: total=" << numDroppedFrames_;
+            }
+            queue_.push_back(move(surface));
+        }
+        queueCondVar_.notify_one();
     }
 }
 
+void Capture::runAnalysisLoop()
+{
+    shared_ptr<SDL_Surface> prevSurface;
+    shared_ptr<SDL_Surface> lastSurface;
+    deque<unique_ptr<AnalyzerResult>> results;
+
+    while (true) {
+        UniqueSDLSurface surface(emptyUniqueSDLSurface());
+        {
+            unique_lock<mutex> lock(queueMu_);
+            queueCondVar_.wait(lock, [this]() { return shouldStop_ || !queue_.empty(); });
+            if (shouldStop_)
+                return;
+            surface = move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // The surface goes back to the source when no one refers it.
+        Source* source = source_;
+        shared_ptr<SDL_Surface> currentSurface(surface.release(), [source](SDL_Surface* s) {
+            source->recycleFrame(makeUniqueSDLSurface(s));
+        });
+        unique_ptr<AnalyzerResult> r = analyzer_->analyze(currentSurface.get(), prevSurface.get(), results);
+
+        shared_ptr<AnalyzedFrame> frame(new AnalyzedFrame);
+        frame->surface = currentSurface;
+        frame->result = r->copy();
+        atomic_store(&published_, shared_ptr<const AnalyzedFrame>(move(frame)));
+
+        results.push_front(move(r));
+        while (results.size() > MAX_PREVIOUS_RESULTS)
+            results.pop_back();
+        prevSurface = move(lastSurface);
+        lastSurface = move(currentSurface);
+    }
+}
+
+bool Capture::addDirtyRects(Screen*, vector<Box>* rects)
+{
+    // The same frame is drawn until the next GUI frame, even if a new one is published.
+    shared_ptr<const AnalyzedFrame> frame = atomic_load(&published_);
+    if (frame == drawnFrame_)
+        return true;
+
+    if (drawnFrame_)
+        rects->push_back(Box(0, 0, drawnFrame_->surface->w, drawnFrame_->surface->h));
+    if (frame)
+        rects->push_back(Box(0, 0, frame->surface->w, frame->surface->h));
+    drawnFrame_ = frame;
+    return true;
+}
+
 void Capture::draw(Screen* screen)
 {
-    SDL_Surface* surface = screen->surface();
+    if (!drawnFrame_)
+        return;
 
-    lock_guard<mutex> lock(mu_);
-    SDL_BlitSurface(surface_.get(), nullptr, surface, nullptr);
+    SDL_Surface* surface = screen->surface();
+    SDL_BlitSurface(drawnFrame_->surface.get(), nullptr, surface, nullptr);
 }
 
 unique_ptr<AnalyzerResult> Capture::analyzerResult() const
 {
-    lock_guard<mutex> lock(mu_);
-
-    if (results_.empty())
+    shared_ptr<const AnalyzedFrame> frame = atomic_load(&published_);
+    if (!frame)
         return unique_ptr<AnalyzerResult>();
 
-    return results_.front().get()->copy();
+    return frame->result->copy();
 }
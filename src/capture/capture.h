@@ -1,11 +1,16 @@
 #ifndef CAPTURE_CAPTURE_H_
 #define CAPTURE_CAPTURE_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "base/base.h"
+#include "base/executor.h"
 #include "capture/analyzer.h"
 #include "capture/analyzer_result_drawer.h"
 #include "gui/drawer.h"
@@ -15,32 +20,61 @@ class Analyzer;
 class Source;
 class Screen;
 
+// Capture runs a pipeline of 2 threads. The capture thread takes frames from the source,
+// and the analysis thread analyzes them in order. Each analyzed frame is published
+// as an immutable object, so draw() and analyzerResult() never wait for the analysis.
 class Capture : public Drawer, public AnalyzerResultRetriever {
 public:
     // Does not take the ownership of |source| and |analyzer|.
     // They should be alive during Capture is alive.
     explicit Capture(Source* source, Analyzer* analyzer);
-    virtual ~Capture() {}
+    virtual ~Capture();
 
+    // Returns false if already started or stopped.
     bool start();
+    // Does nothing if not started.
     void stop();
 
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
 
     virtual std::unique_ptr<AnalyzerResult> analyzerResult() const override;
 
+    // The number of the frames dropped since the analysis couldn't catch up with the source.
+    int numDroppedFrames() const { return numDroppedFrames_; }
+
 private:
-    void runLoop();
+    // A frame and its analysis result. This is not modified after published.
+    struct AnalyzedFrame {
+        std::shared_ptr<SDL_Surface> surface;
+        std::unique_ptr<AnalyzerResult> result;
+    };
+
+    void runCaptureLoop();
+    void runAnalysisLoop();
 
     Source* source_;
     Analyzer* analyzer_;
 
-    std::thread th_;
-    volatile bool shouldStop_;
+    // Used to detect the fields of 2 players in parallel.
+    Executor executor_;
+
+    // start() and stop() are called from the same thread.
+    bool started_ = false;
+    std::thread captureThread_;
+    std::thread analysisThread_;
+    std::atomic<bool> shouldStop_;
+
+    // The frames captured but not analyzed yet.
+    std::mutex queueMu_;
+    std::condition_variable queueCondVar_;
+    std::deque<UniqueSDLSurface> queue_;
+    std::atomic<int> numDroppedFrames_;
 
-    mutable std::mutex mu_;
-    UniqueSDLSurface surface_;
-    std::deque<std::unique_ptr<AnalyzerResult>> results_;
+    // Accessed only with std::atomic_load and std::atomic_store.
+    std::shared_ptr<const AnalyzedFrame> published_;
+    // The frame drawn in the current frame of the GUI. Used only by the GUI thread.
+    std::shared_ptr<const AnalyzedFrame> drawnFrame_;
 };
 
 #endif  // CAPTURE_CAPTURE_H_
@@ -7,8 +7,7 @@ using namespace std;
 MovieSource::MovieSource(const char* filename) :
     filename_(filename),
     waitUntilTrue_(true),
-    sws_(NULL),
-    surf_(makeUniqueSDLSurface(nullptr))
+    sws_(NULL)
 {
     format_ = NULL;
 
@@ -60,29 +59,10 @@ MovieSource::MovieSource(const char* filename) :
         return;
     }
 
-    frame_rgb_ = avcodec_alloc_frame();
-    if (frame_rgb_ == NULL) {
-        fprintf(stderr, "Couldn't allocate frame_rgb memory\n");
-        return;
-    }
-
-    int buf_len = avpicture_get_size(PIX_FMT_RGB24, width_, height_);
-    uint8_t* buffer = (uint8_t*)calloc(sizeof(uint8_t), buf_len);
-    avpicture_fill((AVPicture*)frame_rgb_, buffer,
-                   PIX_FMT_RGB24, width_, height_);
+    // Frames are scaled into the surfaces of this format directly.
+    initSurfacePool(24, 255, 255 << 8, 255 << 16, 0);
 
-#if 1
-    SDL_Surface* surf = SDL_CreateRGBSurfaceFrom(frame_rgb_->data[0], width_, height_, 24,
-                                                 buf_len / height_,
-                                                 255, 255 << 8, 255 << 16, 0);
-#else
-    SDL_Surface* surf = SDL_CreateRGBSurface(SDL_SWSURFACE, width_, height_, 24,
-                                             255, 255 << 8, 255 << 16, 0);
-#endif
-    surf_ = makeUniqueSDLSurface(surf);
-
-    fprintf(stderr,"Parsed movie: width=%d height=%d pitch=%d\n",
-            width_, height_, surf_->pitch);
+    fprintf(stderr,"Parsed movie: width=%d height=%d\n", width_, height_);
 
     ok_ = true;
 }
@@ -99,6 +79,7 @@ void MovieSource::nextStep()
 
 UniqueSDLSurface MovieSource::getNextFrame()
 {
+    UniqueSDLSurface surface(emptyUniqueSDLSurface());
     int frame_finished;
     while (true) {
         if (av_read_frame(format_, &packet_) < 0)
@@ -113,15 +94,11 @@ UniqueSDLSurface MovieSource::getNextFrame()
                                             width_, height_, PIX_FMT_RGB24,
                                             SWS_BICUBIC, NULL, NULL, NULL);
 
-                sws_scale(sws_, frame_->data, frame_->linesize, 0, height_, frame_rgb_->data, frame_rgb_->linesize);
-
-#if 0
-                for (int y = 0; y < height_; y++) {
-                    memcpy((char*)surf_->pixels + y * surf_->pitch,
-                           frame_rgb_->data[0] + y * frame_rgb_->linesize[0],
-                           frame_rgb_->linesize[0]);
-                }
-#endif
+                // Scale into a recycled surface directly.
+                surface = takeSurface();
+                uint8_t* data[4] = { static_cast<uint8_t*>(surface->pixels), nullptr, nullptr, nullptr };
+                int linesize[4] = { surface->pitch, 0, 0, 0 };
+                sws_scale(sws_, frame_->data, frame_->linesize, 0, height_, data, linesize);
 
                 break;
             }
@@ -130,6 +107,9 @@ UniqueSDLSurface MovieSource::getNextFrame()
         av_free_packet(&packet_);
     }
 
+    if (!paced_)
+        return surface;
+
     // Wait until next frame.
     Uint32 currentTime = SDL_GetTicks();
     Uint32 elapsed = currentTime - lastTaken_;
@@ -146,7 +126,7 @@ UniqueSDLSurface MovieSource::getNextFrame()
     }
     lastTaken_ = SDL_GetTicks();
 
-    return makeUniqueSDLSurface(SDL_ConvertSurface(surf_.get(), surf_->format, 0));
+    return surface;
 }
 
 void MovieSource::init()
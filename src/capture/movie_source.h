@@ -27,6 +27,8 @@ public:
     virtual UniqueSDLSurface getNextFrame();
 
     void setFPS(int fps) { fps_ = fps; }
+    // When false, frames are returned as fast as they are decoded, ignoring FPS.
+    void setPaced(bool paced) { paced_ = paced; }
     void nextStep();
 
     static void init();
@@ -35,6 +37,7 @@ private:
     const char* filename_;
 
     int fps_ = 30;
+    bool paced_ = true;
     Uint32 lastTaken_ = 0;
     // Default must be true to show the first image.
     std::atomic<bool> waitUntilTrue_;
@@ -42,13 +45,10 @@ private:
     AVFormatContext* format_;
     AVCodecContext* codec_;
     AVFrame* frame_;
-    AVFrame* frame_rgb_;
     int video_index_;
 
     AVPacket packet_;
     SwsContext* sws_;
-
-    UniqueSDLSurface surf_;
 };
 
 #endif  // CAPTURE_MOVIE_H_
@@ -0,0 +1,270 @@
+#include "capture/real_color_classifier.h"
+
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "capture/color.h"
+
+using namespace std;
+
+namespace {
+
+inline RealColor classifyPixel(uint32_t c, const PixelLayout32& layout)
+{
+    return RealColorClassifier::classify((c >> layout.rShift) & 0xFF,
+                                         (c >> layout.gShift) & 0xFF,
+                                         (c >> layout.bShift) & 0xFF);
+}
+
+#ifdef __SSE2__
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128i select(__m128 mask, __m128i a, __m128i b)
+{
+    __m128i m = _mm_castps_si128(mask);
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+inline __m128 ps(float v) { return _mm_set1_ps(v); }
+inline __m128i rc(RealColor c) { return _mm_set1_epi32(ordinal(c)); }
+
+// Classifies 4 pixels. Each lane of the result is the ordinal of RealColor.
+// This follows RGB::toHSV() and RealColorClassifier::classify(const HSV&) operation
+// by operation in single precision, so that the results are exactly the same.
+inline __m128i classify4(__m128i pixels, __m128i rShift, __m128i gShift, __m128i bShift)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(pixels, rShift), mask));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(pixels, gShift), mask));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(pixels, bShift), mask));
+
+    __m128 mx = _mm_max_ps(_mm_max_ps(r, g), b);
+    __m128 mn = _mm_min_ps(_mm_min_ps(r, g), b);
+    __m128 d = _mm_sub_ps(mx, mn);
+
+    // The lanes with d == 0 are overwritten below, so division by zero is harmless.
+    __m128 hr = _mm_div_ps(_mm_mul_ps(ps(60), _mm_sub_ps(g, b)), d);
+    __m128 hg = _mm_add_ps(_mm_div_ps(_mm_mul_ps(ps(60), _mm_sub_ps(b, r)), d), ps(120));
+    __m128 hb = _mm_add_ps(_mm_div_ps(_mm_mul_ps(ps(60), _mm_sub_ps(r, g)), d), ps(240));
+
+    __m128 h = select(_mm_cmpeq_ps(mx, g), hg, hb);
+    h = select(_mm_cmpeq_ps(mx, r), hr, h);
+    h = select(_mm_cmpeq_ps(mx, mn), ps(180), h);
+    // |h| is in [-60, 300], and |h| < 0 means |h| <= -60 / 255, so one step is enough.
+    h = select(_mm_cmplt_ps(h, ps(0)), _mm_add_ps(h, ps(360)), h);
+    h = select(_mm_cmpge_ps(h, ps(360)), _mm_sub_ps(h, ps(360)), h);
+
+    // s is 0 when mx is 0, since mn is 0, too.
+    __m128 s = d;
+    __m128 v = mx;
+
+    // Applies the rules from the lowest priority, so that the higher one overwrites.
+    __m128i result = rc(RealColor::RC_EMPTY);
+
+    __m128 redPurple = _mm_and_ps(_mm_cmple_ps(ps(340), h), _mm_cmple_ps(h, ps(350)));
+    result = select(_mm_and_ps(redPurple, _mm_cmplt_ps(ps(65), v)), rc(RealColor::RC_PURPLE), result);
+    result = select(_mm_and_ps(redPurple, _mm_cmplt_ps(ps(160), _mm_add_ps(s, v))), rc(RealColor::RC_RED), result);
+
+    __m128 purple = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(ps(290), h), _mm_cmplt_ps(h, ps(340))), _mm_cmplt_ps(ps(65), v));
+    result = select(purple, rc(RealColor::RC_PURPLE), result);
+    __m128 blue = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(ps(180), h), _mm_cmple_ps(h, ps(255))), _mm_cmplt_ps(ps(60), v));
+    result = select(blue, rc(RealColor::RC_BLUE), result);
+    __m128 green = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(ps(85), h), _mm_cmple_ps(h, ps(135))), _mm_cmplt_ps(ps(70), v));
+    result = select(green, rc(RealColor::RC_GREEN), result);
+    __m128 yellow = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(ps(35), h), _mm_cmple_ps(h, ps(75))), _mm_cmplt_ps(ps(90), v));
+    result = select(yellow, rc(RealColor::RC_YELLOW), result);
+    __m128 red = _mm_and_ps(_mm_or_ps(_mm_cmple_ps(h, ps(15)), _mm_cmplt_ps(ps(350), h)), _mm_cmplt_ps(ps(70), v));
+    result = select(red, rc(RealColor::RC_RED), result);
+    __m128 ojama = _mm_and_ps(_mm_cmplt_ps(s, ps(50)), _mm_cmplt_ps(ps(130), v));
+    result = select(ojama, rc(RealColor::RC_OJAMA), result);
+    result = select(_mm_cmplt_ps(v, ps(38)), rc(RealColor::RC_EMPTY), result);
+
+    return result;
+}
+
+#endif
+
+const uint8_t AMBIGUOUS = 0xFF;
+const uint8_t UNSET = 0xFE;
+
+inline int tableIndex(int r, int g, int b)
+{
+    const int bits = RealColorClassifier::TABLE_BITS;
+    const int shift = 8 - bits;
+    return ((r >> shift) << (2 * bits)) | ((g >> shift) << bits) | (b >> shift);
+}
+
+vector<uint8_t> makeTable()
+{
+    vector<uint8_t> table(RealColorClassifier::TABLE_SIZE, UNSET);
+
+    // ARGB8888
+    const PixelLayout32 layout(16, 8, 0);
+    uint32_t row[256];
+    RealColor colors[256];
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b)
+                row[b] = (r << 16) | (g << 8) | b;
+            RealColorClassifier::classifyRow(row, 256, layout, colors);
+            for (int b = 0; b < 256; ++b) {
+                uint8_t& cell = table[tableIndex(r, g, b)];
+                uint8_t c = static_cast<uint8_t>(ordinal(colors[b]));
+                if (cell == UNSET)
+                    cell = c;
+                else if (cell != c)
+                    cell = AMBIGUOUS;
+            }
+        }
+    }
+
+    return table;
+}
+
+} // anonymous namespace
+
+// static
+RealColor RealColorClassifier::classify(const HSV& hsv)
+{
+    if (hsv.v < 38)
+        return RealColor::RC_EMPTY;
+
+    if (hsv.s < 50 && 130 < hsv.v)
+        return RealColor::RC_OJAMA;
+
+    // The other colors are relatively easier. A bit tight range for now.
+    if ((hsv.h <= 15 || 350 < hsv.h) && 70 < hsv.v)
+        return RealColor::RC_RED;
+    if (35 <= hsv.h && hsv.h <= 75 && 90 < hsv.v)
+        return RealColor::RC_YELLOW;
+    if (85 <= hsv.h && hsv.h <= 135 && 70 < hsv.v)
+        return RealColor::RC_GREEN;
+    // Detecting blue is relatively hard. Let's have a relaxed margin.
+    if (180 <= hsv.h && hsv.h <= 255 && 60 < hsv.v)
+        return RealColor::RC_BLUE;
+    // Detecting purple is really hard. We'd like to have relaxed margin for purple.
+    if (290 <= hsv.h && hsv.h < 340 && 65 < hsv.v)
+        return RealColor::RC_PURPLE;
+
+    // Hard to distinguish RED and PURPLE.
+    if (340 <= hsv.h && hsv.h <= 350) {
+        if (160 < hsv.s + hsv.v)
+            return RealColor::RC_RED;
+        if (65 < hsv.v)
+            return RealColor::RC_PURPLE;
+    }
+
+    return RealColor::RC_EMPTY;
+}
+
+// static
+RealColor RealColorClassifier::classify(int r, int g, int b)
+{
+    return classify(RGB(r, g, b).toHSV());
+}
+
+// static
+void RealColorClassifier::classifyRow(const uint32_t* row, int width, const PixelLayout32& layout, RealColor* out)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i rShift = _mm_cvtsi32_si128(layout.rShift);
+    const __m128i gShift = _mm_cvtsi32_si128(layout.gShift);
+    const __m128i bShift = _mm_cvtsi32_si128(layout.bShift);
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        alignas(16) int32_t colors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(colors), classify4(pixels, rShift, gShift, bShift));
+        for (int i = 0; i < 4; ++i)
+            out[x + i] = intToRealColor(colors[i]);
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = classifyPixel(row[x], layout);
+}
+
+// static
+void RealColorClassifier::countRow(const uint32_t* row, int width, const PixelLayout32& layout, int counts[NUM_REAL_COLORS])
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i rShift = _mm_cvtsi32_si128(layout.rShift);
+    const __m128i gShift = _mm_cvtsi32_si128(layout.gShift);
+    const __m128i bShift = _mm_cvtsi32_si128(layout.bShift);
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        alignas(16) int32_t colors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(colors), classify4(pixels, rShift, gShift, bShift));
+        ++counts[colors[0]];
+        ++counts[colors[1]];
+        ++counts[colors[2]];
+        ++counts[colors[3]];
+    }
+#endif
+    for (; x < width; ++x)
+        ++counts[ordinal(classifyPixel(row[x], layout))];
+}
+
+// static
+void RealColorClassifier::countRowScalar(const uint32_t* row, int width, const PixelLayout32& layout, int counts[NUM_REAL_COLORS])
+{
+    for (int x = 0; x < width; ++x)
+        ++counts[ordinal(classifyPixel(row[x], layout))];
+}
+
+// static
+const uint8_t* RealColorClassifier::table()
+{
+    static const vector<uint8_t> table = makeTable();
+    return table.data();
+}
+
+// static
+void RealColorClassifier::initializeTable()
+{
+    (void)table();
+}
+
+// static
+RealColor RealColorClassifier::classifyByTable(int r, int g, int b)
+{
+    uint8_t c = table()[tableIndex(r, g, b)];
+    if (c != AMBIGUOUS)
+        return intToRealColor(c);
+    return classify(r, g, b);
+}
+
+// static
+void RealColorClassifier::countRowByTable(const uint32_t* row, int width, const PixelLayout32& layout, int counts[NUM_REAL_COLORS])
+{
+    const uint8_t* t = table();
+    for (int x = 0; x < width; ++x) {
+        int r = (row[x] >> layout.rShift) & 0xFF;
+        int g = (row[x] >> layout.gShift) & 0xFF;
+        int b = (row[x] >> layout.bShift) & 0xFF;
+        uint8_t c = t[tableIndex(r, g, b)];
+        if (c != AMBIGUOUS)
+            ++counts[c];
+        else
+            ++counts[ordinal(classify(r, g, b))];
+    }
+}
+
+// static
+double RealColorClassifier::ambiguousCellRatio()
+{
+    const uint8_t* t = table();
+    int count = 0;
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        if (t[i] == AMBIGUOUS)
+            ++count;
+    }
+    return static_cast<double>(count) / TABLE_SIZE;
+}
@@ -0,0 +1,55 @@
+#ifndef CAPTURE_REAL_COLOR_CLASSIFIER_H_
+#define CAPTURE_REAL_COLOR_CLASSIFIER_H_
+
+#include <cstdint>
+
+#include "core/real_color.h"
+
+struct HSV;
+
+// The layout of a 32-bit pixel whose R, G and B channels are 8 bits.
+struct PixelLayout32 {
+    PixelLayout32(int rShift, int gShift, int bShift) : rShift(rShift), gShift(gShift), bShift(bShift) {}
+
+    int rShift;
+    int gShift;
+    int bShift;
+};
+
+// RealColorClassifier classifies pixels into RealColor with the HSV thresholds
+// tuned for AC puyo puyo. The row functions use SSE2 when available, and give
+// exactly the same results as classify(RGB(r, g, b).toHSV()).
+//
+// The table functions look up RealColor by RGB quantized to TABLE_BITS bits per
+// channel. A table cell whose colors are classified differently is marked as
+// ambiguous, and its pixels are classified with classify(). So they also give
+// exactly the same results.
+class RealColorClassifier {
+public:
+    static const int TABLE_BITS = 6;
+    static const int TABLE_SIZE = 1 << (3 * TABLE_BITS);
+
+    // The reference implementation.
+    static RealColor classify(const HSV&);
+    static RealColor classify(int r, int g, int b);
+
+    // Classifies |width| pixels of |row| into |out|.
+    static void classifyRow(const std::uint32_t* row, int width, const PixelLayout32&, RealColor* out);
+    // Classifies |width| pixels of |row|, and adds the number of each RealColor to |counts|.
+    static void countRow(const std::uint32_t* row, int width, const PixelLayout32&, int counts[NUM_REAL_COLORS]);
+    // Same as countRow, but without SIMD. For benchmark.
+    static void countRowScalar(const std::uint32_t* row, int width, const PixelLayout32&, int counts[NUM_REAL_COLORS]);
+
+    // Builds the table if it's not built yet. This takes about 120 [ms] with -O2, so call this
+    // at startup not to delay the first frame. The table functions call this, too.
+    static void initializeTable();
+    static RealColor classifyByTable(int r, int g, int b);
+    static void countRowByTable(const std::uint32_t* row, int width, const PixelLayout32&, int counts[NUM_REAL_COLORS]);
+    // The ratio of the ambiguous cells in the table.
+    static double ambiguousCellRatio();
+
+private:
+    static const std::uint8_t* table();
+};
+
+#endif
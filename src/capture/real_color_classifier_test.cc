@@ -0,0 +1,84 @@
+#include "capture/real_color_classifier.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "capture/color.h"
+
+using namespace std;
+
+TEST(RealColorClassifierTest, classifyRowForAll)
+{
+    // ARGB8888
+    PixelLayout32 layout(16, 8, 0);
+
+    vector<uint32_t> row(256);
+    vector<RealColor> colors(256);
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b)
+                row[b] = 0xFF000000 | (r << 16) | (g << 8) | b;
+
+            RealColorClassifier::classifyRow(row.data(), 256, layout, colors.data());
+            for (int b = 0; b < 256; ++b) {
+                RealColor expected = RealColorClassifier::classify(RGB(r, g, b).toHSV());
+                ASSERT_EQ(expected, colors[b]) << r << ' ' << g << ' ' << b;
+            }
+        }
+    }
+}
+
+TEST(RealColorClassifierTest, countRow)
+{
+    // ABGR8888
+    PixelLayout32 layout(0, 8, 16);
+
+    // 7 pixels to check the remainder, too.
+    uint32_t row[] = {
+        0xFF000000, // empty
+        0xFFFFFFFF, // ojama
+        0xFF0000FF, // red
+        0xFF00FFFF, // yellow
+        0xFF00FF00, // green
+        0xFFFF0000, // blue
+        0xFFFF00FF, // purple
+    };
+
+    int expected[NUM_REAL_COLORS] {};
+    for (int i = 0; i < 7; ++i)
+        ++expected[ordinal(RealColorClassifier::classify(row[i] & 0xFF, (row[i] >> 8) & 0xFF, (row[i] >> 16) & 0xFF))];
+
+    int counts[NUM_REAL_COLORS] {};
+    RealColorClassifier::countRow(row, 7, layout, counts);
+    int scalarCounts[NUM_REAL_COLORS] {};
+    RealColorClassifier::countRowScalar(row, 7, layout, scalarCounts);
+
+    for (int i = 0; i < NUM_REAL_COLORS; ++i) {
+        EXPECT_EQ(expected[i], counts[i]) << toString(intToRealColor(i));
+        EXPECT_EQ(expected[i], scalarCounts[i]) << toString(intToRealColor(i));
+    }
+
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_EMPTY)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_OJAMA)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_RED)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_YELLOW)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_GREEN)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_BLUE)]);
+    EXPECT_EQ(1, counts[ordinal(RealColor::RC_PURPLE)]);
+}
+
+TEST(RealColorClassifierTest, classifyByTableForAll)
+{
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                RealColor expected = RealColorClassifier::classify(RGB(r, g, b).toHSV());
+                ASSERT_EQ(expected, RealColorClassifier::classifyByTable(r, g, b)) << r << ' ' << g << ' ' << b;
+            }
+        }
+    }
+
+    // Most of the cells should be unambiguous. Otherwise, the table doesn't make sense.
+    EXPECT_GT(0.2, RealColorClassifier::ambiguousCellRatio());
+}
@@ -0,0 +1,130 @@
+#include "capture/replay.h"
+
+#include <algorithm>
+#include <deque>
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "base/wait_group.h"
+#include "capture/analyzer.h"
+#include "capture/source.h"
+
+using namespace std;
+
+namespace {
+
+// Capture passes the surface 2 frames before as the previous surface. Do the same
+// so that the results are the same as the live analysis.
+const int PREV_FRAME_DISTANCE = 2;
+
+// The same as Capture.
+const size_t MAX_PREVIOUS_RESULTS = 10;
+
+struct Chunk {
+    // The first PREV_FRAME_DISTANCE surfaces are the last ones of the previous chunk,
+    // which are used only as the previous surfaces. They can be nullptr.
+    vector<shared_ptr<SDL_Surface>> surfaces;
+    vector<unique_ptr<DetectedFrame>> detected;
+    WaitGroup wg;
+};
+
+// The surfaces go back to the source when no one refers them.
+shared_ptr<SDL_Surface> share(Source* source, UniqueSDLSurface surface)
+{
+    return shared_ptr<SDL_Surface>(surface.release(), [source](SDL_Surface* s) {
+        source->recycleFrame(makeUniqueSDLSurface(s));
+    });
+}
+
+void pushResult(unique_ptr<AnalyzerResult> result, deque<unique_ptr<AnalyzerResult>>* results)
+{
+    results->push_front(move(result));
+    while (results->size() > MAX_PREVIOUS_RESULTS)
+        results->pop_back();
+}
+
+}
+
+int replay(Source* source, Analyzer* analyzer, const ReplayCallback& callback)
+{
+    vector<shared_ptr<SDL_Surface>> surfaces(PREV_FRAME_DISTANCE);
+    deque<unique_ptr<AnalyzerResult>> results;
+    int frameId = 0;
+
+    while (true) {
+        UniqueSDLSurface surface(source->getNextFrame());
+        if (!surface.get())
+            break;
+
+        surfaces.push_back(share(source, move(surface)));
+        unique_ptr<AnalyzerResult> r = analyzer->analyze(surfaces.back().get(), surfaces.front().get(), results);
+        surfaces.erase(surfaces.begin());
+
+        callback(++frameId, *r);
+        pushResult(move(r), &results);
+    }
+
+    return frameId;
+}
+
+int replayInParallel(Source* source, Executor* executor, const vector<unique_ptr<Analyzer>>& detectors,
+                     int chunkFrames, Analyzer* analyzer, const ReplayCallback& callback)
+{
+    CHECK(!detectors.empty());
+    CHECK_GT(chunkFrames, 0);
+
+    // Since a chunk is not submitted before the chunk |detectors.size()| chunks before has finished,
+    // a chunk can use the detector of its index modulo the number of the detectors.
+    const size_t maxChunksInFlight = detectors.size();
+    deque<unique_ptr<Chunk>> chunksInFlight;
+    vector<shared_ptr<SDL_Surface>> prevSurfaces(PREV_FRAME_DISTANCE);
+    int numChunks = 0;
+    bool eof = false;
+
+    deque<unique_ptr<AnalyzerResult>> results;
+    int frameId = 0;
+
+    while (!eof || !chunksInFlight.empty()) {
+        if (!eof) {
+            unique_ptr<Chunk> chunk(new Chunk);
+            chunk->surfaces = prevSurfaces;
+            while (chunk->surfaces.size() < static_cast<size_t>(PREV_FRAME_DISTANCE + chunkFrames)) {
+                UniqueSDLSurface surface(source->getNextFrame());
+                if (!surface.get()) {
+                    eof = true;
+                    break;
+                }
+                chunk->surfaces.push_back(share(source, move(surface)));
+            }
+            copy(chunk->surfaces.end() - PREV_FRAME_DISTANCE, chunk->surfaces.end(), prevSurfaces.begin());
+
+            if (chunk->surfaces.size() > static_cast<size_t>(PREV_FRAME_DISTANCE)) {
+                Chunk* c = chunk.get();
+                Analyzer* detector = detectors[numChunks++ % detectors.size()].get();
+                c->wg.add(1);
+                executor->submit([c, detector]() {
+                    for (size_t i = PREV_FRAME_DISTANCE; i < c->surfaces.size(); ++i)
+                        c->detected.push_back(detector->detect(c->surfaces[i].get(), c->surfaces[i - PREV_FRAME_DISTANCE].get()));
+                    c->wg.done();
+                });
+                chunksInFlight.push_back(move(chunk));
+            }
+        }
+
+        if (chunksInFlight.empty() || (!eof && chunksInFlight.size() < maxChunksInFlight))
+            continue;
+
+        unique_ptr<Chunk> chunk = move(chunksInFlight.front());
+        chunksInFlight.pop_front();
+        chunk->wg.waitUntilDone();
+
+        for (const auto& detected : chunk->detected) {
+            unique_ptr<AnalyzerResult> r = analyzer->analyzeDetectedFrame(*detected, results);
+            callback(++frameId, *r);
+            pushResult(move(r), &results);
+        }
+    }
+
+    return frameId;
+}
@@ -0,0 +1,29 @@
+#ifndef CAPTURE_REPLAY_H_
+#define CAPTURE_REPLAY_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Analyzer;
+class AnalyzerResult;
+class Executor;
+class Source;
+
+// Replays analyze all the frames of a source as fast as possible, and call |callback|
+// with the result of each frame in order. frameId starts from 1.
+// They return the number of the analyzed frames.
+typedef std::function<void (int frameId, const AnalyzerResult&)> ReplayCallback;
+
+// Analyzes the frames one by one like Capture.
+int replay(Source*, Analyzer*, const ReplayCallback&);
+
+// Detects chunks of |chunkFrames| frames on |executor| in parallel, and makes the results
+// from the detections with |analyzer| in order. Each in-flight chunk uses its own detector,
+// so up to |detectors.size()| chunks are detected at the same time.
+// The results are the same as replay() as long as detect() doesn't depend on
+// the frames detected before.
+int replayInParallel(Source*, Executor*, const std::vector<std::unique_ptr<Analyzer>>& detectors,
+                     int chunkFrames, Analyzer* analyzer, const ReplayCallback&);
+
+#endif
@@ -0,0 +1,176 @@
+// replay_analyzer analyzes recorded movies without a window, as fast as possible,
+// and writes the result of each frame in one line. Diffing the outputs of 2 versions
+// shows the frames where the analysis changed.
+//
+// The detection of the frames runs in parallel by chunks, and the results are made
+// from the detections in order, since they depend on the previous results.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "capture/ac_analyzer.h"
+#include "capture/movie_source.h"
+#include "capture/replay.h"
+
+using namespace std;
+
+DEFINE_string(output, "", "the file to write the results to. When empty, stdout is used.");
+DEFINE_int32(threads, 0, "the number of threads to detect frames. When 0, the number of cores is used.");
+DEFINE_int32(chunk_frames, 16, "the number of frames detected in one task");
+DECLARE_bool(analyzer_skip_unchanged_boxes);
+
+namespace {
+
+char toStateChar(CaptureGameState state)
+{
+    switch (state) {
+    case CaptureGameState::UNKNOWN:      return 'U';
+    case CaptureGameState::LEVEL_SELECT: return 'L';
+    case CaptureGameState::PLAYING:      return 'P';
+    case CaptureGameState::FINISHED:     return 'F';
+    }
+
+    CHECK(false) << "Unknown CaptureGameState: " << static_cast<int>(state);
+    return '?';
+}
+
+// Writes the adjusted field (vanishing puyos are in lower case), NEXT and the user events.
+void writePlayerResult(const PlayerAnalyzerResult& result, ostream* os)
+{
+    static const NextPuyoPosition nexts[] = {
+        NextPuyoPosition::NEXT1_AXIS,
+        NextPuyoPosition::NEXT1_CHILD,
+        NextPuyoPosition::NEXT2_AXIS,
+        NextPuyoPosition::NEXT2_CHILD,
+    };
+
+    const AdjustedField& field = result.adjustedField;
+    for (int y = 1; y <= 12; ++y) {
+        for (int x = 1; x <= 6; ++x)
+            *os << toChar(field.realColor(x, y), !field.isVanishing(x, y));
+    }
+    *os << ':';
+    for (NextPuyoPosition npp : nexts)
+        *os << toChar(field.realColor(npp));
+    *os << ':';
+
+    const UserEvent& event = result.userEvent;
+    if (!event.hasEventState())
+        *os << '-';
+    if (event.wnextAppeared)
+        *os << 'W';
+    if (event.grounded)
+        *os << 'G';
+    if (event.decisionRequest)
+        *os << 'D';
+    if (event.decisionRequestAgain)
+        *os << 'A';
+    if (event.chainFinished)
+        *os << 'C';
+    if (event.ojamaDropped)
+        *os << 'O';
+    if (event.puyoErased)
+        *os << 'E';
+}
+
+void writeResult(int frameId, const AnalyzerResult& result, ostream* os)
+{
+    *os << frameId << ' ' << toStateChar(result.state());
+    for (int pi = 0; pi < 2; ++pi) {
+        *os << ' ';
+        if (result.playerResult(pi))
+            writePlayerResult(*result.playerResult(pi), os);
+        else
+            *os << '-';
+    }
+    *os << '\n';
+}
+
+// Returns the number of the analyzed frames.
+int replayMovie(const char* filename, Executor* executor, const vector<unique_ptr<Analyzer>>& detectors,
+                Analyzer* analyzer, ostream* os)
+{
+    MovieSource source(filename);
+    if (!source.ok()) {
+        LOG(ERROR) << "Failed to load " << filename;
+        return 0;
+    }
+    source.setPaced(false);
+
+    *os << "# " << filename << '\n';
+    return replayInParallel(&source, executor, detectors, FLAGS_chunk_frames, analyzer,
+                            [os](int frameId, const AnalyzerResult& result) {
+        writeResult(frameId, result, os);
+    });
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    // Reusing the analyses of the unchanged boxes makes the detection of a frame depend on
+    // the frames the detector has seen before, so the results would depend on --threads
+    // and --chunk_frames. It can still be enabled explicitly.
+    FLAGS_analyzer_skip_unchanged_boxes = false;
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s [--output=<out-file>] <in-movie>...\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    MovieSource::init();
+
+    int numThreads = FLAGS_threads > 0 ? FLAGS_threads : max(1u, thread::hardware_concurrency());
+    Executor executor(numThreads);
+    executor.start();
+
+    // Each detector is used by one task at a time. Make them here, since ACAnalyzer
+    // sets up the bounding box in its constructor.
+    vector<unique_ptr<Analyzer>> detectors;
+    for (int i = 0; i < numThreads * 2; ++i)
+        detectors.emplace_back(new ACAnalyzer);
+    ACAnalyzer analyzer;
+
+    ofstream ofs;
+    if (!FLAGS_output.empty()) {
+        ofs.open(FLAGS_output, ios::out | ios::trunc);
+        if (!ofs) {
+            fprintf(stderr, "Failed to open %s\n", FLAGS_output.c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+    ostream* os = FLAGS_output.empty() ? &cout : &ofs;
+
+    int numFrames = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 1; i < argc; ++i)
+        numFrames += replayMovie(argv[i], &executor, detectors, &analyzer, os);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    executor.stop();
+
+    os->flush();
+    if (!*os) {
+        fprintf(stderr, "Failed to write the results\n");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(stderr, "Analyzed %d frames in %.1f seconds (%.1f frames/s) with %d threads\n",
+            numFrames, seconds, seconds > 0 ? numFrames / seconds : 0.0, numThreads);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "capture/replay.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "capture/ac_analyzer.h"
+#include "capture/movie_source.h"
+
+using namespace std;
+
+DECLARE_string(testdata_dir);
+DECLARE_bool(analyzer_skip_unchanged_boxes);
+
+namespace {
+
+struct ReplayedFrame {
+    int frameId;
+    string result;
+};
+
+vector<ReplayedFrame> replayMovie(const string& filename, Executor* executor, int numDetectors, int chunkFrames)
+{
+    MovieSource source(filename);
+    CHECK(source.ok()) << "Failed to load " << filename;
+    source.setPaced(false);
+
+    vector<ReplayedFrame> frames;
+    auto callback = [&frames](int frameId, const AnalyzerResult& result) {
+        frames.push_back(ReplayedFrame { frameId, result.toString() });
+    };
+
+    ACAnalyzer analyzer;
+    if (!executor) {
+        replay(&source, &analyzer, callback);
+        return frames;
+    }
+
+    vector<unique_ptr<Analyzer>> detectors;
+    for (int i = 0; i < numDetectors; ++i)
+        detectors.emplace_back(new ACAnalyzer);
+    replayInParallel(&source, executor, detectors, chunkFrames, &analyzer, callback);
+    return frames;
+}
+
+}
+
+TEST(ReplayTest, parallelIsSameAsSequential)
+{
+    // The cache of the boxes makes the detection depend on the frames detected before.
+    FLAGS_analyzer_skip_unchanged_boxes = false;
+
+    const string filename = FLAGS_testdata_dir + "/somagic/movie/case34-shote.mp4";
+    vector<ReplayedFrame> expected = replayMovie(filename, nullptr, 0, 0);
+    ASSERT_LT(100U, expected.size());
+
+    Executor executor(2);
+    executor.start();
+    // A chunk size not dividing the number of the frames checks the last chunk, too.
+    vector<ReplayedFrame> actual = replayMovie(filename, &executor, 3, 7);
+    executor.stop();
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i + 1), actual[i].frameId);
+        EXPECT_EQ(expected[i].frameId, actual[i].frameId);
+        EXPECT_EQ(expected[i].result, actual[i].result) << "frameId=" << expected[i].frameId;
+    }
+
+    FLAGS_analyzer_skip_unchanged_boxes = true;
+}
+
+int main(int argc, char* argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    testing::InitGoogleTest(&argc, argv);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    MovieSource::init();
+    return RUN_ALL_TESTS();
+}
@@ -8,6 +8,7 @@
 
 #include "capture/somagic_source.h"
 
+#include <chrono>
 #include <memory>
 #include <glog/logging.h>
 
@@ -1104,11 +1105,13 @@ static int somagic_init()
 
 // ----------------------------------------------------------------------
 
-SomagicSource::SomagicSource(const char* name)
+SomagicSource::SomagicSource(const char* name) :
+    readySurface_(emptyUniqueSDLSurface())
 {
     width_ = 720;
     height_ = 480;
     ok_ = false;
+    initSurfacePool(32, 0, 0, 0, 0);
 
     // TODO(mayah): leaking?
 	program_path = (char*)malloc(strlen(name) + 1);
@@ -1136,11 +1139,16 @@ bool SomagicSource::start()
 
 void SomagicSource::setBuffer(const unsigned char* buf, int size)
 {
-    int pos = 0;
-    std::unique_ptr<int[]> data(new int[720 * 480]);
+    const uint64_t FNV_PRIME = 0x100000001b3ULL;
 
-    int y;
-    for (y = 0; y < 480 && size >= 1440; ++y) {
+    // Decode into a recycled surface directly. The surface is passed to the consumer as is.
+    UniqueSDLSurface surface(takeSurface());
+    CHECK_EQ(SDL_LockSurface(surface.get()), 0);
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int y = 0; y < 480 && size >= 1440; ++y) {
+        Uint32* data = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+        int pos = 0;
         for (int x = 0; x < 720; x += 2) {
             int u  = buf[0];
             int y1 = buf[1];
@@ -1148,50 +1156,41 @@ void SomagicSource::setBuffer(const unsigned char* buf, int size)
             int y2 = buf[3];
             int r, g, b;
             convertUVY2RGBA(u, v, y1, &r, &g, &b);
-            data[pos++] = b + (g << 8) + (r << 16);
+            data[pos] = b + (g << 8) + (r << 16);
+            hash = (hash ^ data[pos++]) * FNV_PRIME;
             convertUVY2RGBA(u, v, y2, &r, &g, &b);
-            data[pos++] = b + (g << 8) + (r << 16);
+            data[pos] = b + (g << 8) + (r << 16);
+            hash = (hash ^ data[pos++]) * FNV_PRIME;
             buf += 4;
         }
         size -= 1440;
     }
 
-    lock_guard<mutex> lock(mu_);
+    SDL_UnlockSurface(surface.get());
 
-    if (!currentPixelData_.get()) {
-        currentPixelData_ = std::move(data);
-        cond_.notify_one();
-        return;
-    }
+    lock_guard<mutex> lock(mu_);
 
     // Only show if the different data.
-
-    bool isSame = true;
-    for (int i = 0; i < 720 * 480; ++i) {
-        if (data[i] != currentPixelData_[i]) {
-            isSame = false;
-            break;
-        }
+    if (hasFrame_ && hash == lastFrameHash_) {
+        recycleFrame(move(surface));
+        return;
     }
 
-    if (!isSame) {
-        currentPixelData_ = std::move(data);
-        cond_.notify_one();
-    }
+    hasFrame_ = true;
+    lastFrameHash_ = hash;
+    // When the previous frame has not been taken yet, it's replaced with the new one.
+    recycleFrame(move(readySurface_));
+    readySurface_ = move(surface);
+    cond_.notify_one();
 }
 
 UniqueSDLSurface SomagicSource::getNextFrame()
 {
-    if (!currentPixelData_)
-        return makeUniqueSDLSurface(nullptr);
-
-    SDL_Surface* surface = SDL_CreateRGBSurface(0, width(), height(), 32, 0, 0, 0, 0);
     unique_lock<mutex> lock(mu_);
 
-    cond_.wait(lock);
+    // Don't wait forever, so that the caller can stop.
+    if (!cond_.wait_for(lock, chrono::milliseconds(100), [this]() { return readySurface_.get() != nullptr; }))
+        return emptyUniqueSDLSurface();
 
-    CHECK(SDL_LockSurface(surface) == 0);
-    memmove(surface->pixels, currentPixelData_.get(), width() * height() * sizeof(int));
-    SDL_UnlockSurface(surface);
-    return makeUniqueSDLSurface(surface);
+    return move(readySurface_);
 }
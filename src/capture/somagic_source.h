@@ -2,6 +2,7 @@
 #define CAPTURE_SOMAGIC_H_
 
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -33,7 +34,10 @@ private:
     std::mutex mu_;
     std::condition_variable cond_;
 
-    std::unique_ptr<int[]> currentPixelData_;
+    // The latest frame not taken by getNextFrame() yet.
+    UniqueSDLSurface readySurface_;
+    bool hasFrame_ = false;
+    uint64_t lastFrameHash_ = 0;
 };
 
 #endif
@@ -1,9 +1,12 @@
 #include "source.h"
 
 #include <gflags/gflags.h>
+#include <glog/logging.h>
 
 #include <SDL_image.h>
 
+using namespace std;
+
 Source::Source() :
     ok_(false),
     done_(false),
@@ -11,3 +14,21 @@ Source::Source() :
     height_(-1)
 {
 }
+
+void Source::recycleFrame(UniqueSDLSurface surface)
+{
+    if (surfacePool_)
+        surfacePool_->recycle(move(surface));
+}
+
+void Source::initSurfacePool(int depth, Uint32 rmask, Uint32 gmask, Uint32 bmask, Uint32 amask)
+{
+    CHECK(width_ > 0 && height_ > 0) << "width and height should be set before initializing the pool.";
+    surfacePool_.reset(new SurfacePool(width_, height_, depth, rmask, gmask, bmask, amask));
+}
+
+UniqueSDLSurface Source::takeSurface()
+{
+    CHECK(surfacePool_) << "initSurfacePool() should be called before takeSurface()";
+    return surfacePool_->take();
+}
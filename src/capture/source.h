@@ -1,7 +1,11 @@
 #ifndef CAPTURE_SOURCE_H_
 #define CAPTURE_SOURCE_H_
 
+#include <memory>
+
 #include <SDL.h>
+
+#include "capture/surface_pool.h"
 #include "gui/unique_sdl_surface.h"
 
 class Screen;
@@ -12,6 +16,10 @@ public:
 
     virtual UniqueSDLSurface getNextFrame() = 0;
 
+    // Gives back a surface returned from getNextFrame(), so that it can be reused for a later frame.
+    // Calling this is optional. A surface not given back is just freed.
+    void recycleFrame(UniqueSDLSurface surface);
+
     virtual void handleEvent(const SDL_Event&) {}
     virtual void handleKeys() {}
 
@@ -27,10 +35,18 @@ public:
 protected:
     Source();
 
+    // A source that makes frames of the fixed size and format should call this
+    // and take the surfaces with takeSurface().
+    void initSurfacePool(int depth, Uint32 rmask, Uint32 gmask, Uint32 bmask, Uint32 amask);
+    UniqueSDLSurface takeSurface();
+
     bool ok_;
     bool done_;
     int width_;
     int height_;
+
+private:
+    std::unique_ptr<SurfacePool> surfacePool_;
 };
 
 #endif  // CAPTURE_SOURCE_H_
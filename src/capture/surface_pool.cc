@@ -0,0 +1,69 @@
+#include "capture/surface_pool.h"
+
+#include <glog/logging.h>
+
+using namespace std;
+
+SurfacePool::SurfacePool(int width, int height, int depth,
+                         Uint32 rmask, Uint32 gmask, Uint32 bmask, Uint32 amask,
+                         size_t maxPooledSurfaces) :
+    width_(width),
+    height_(height),
+    depth_(depth),
+    rmask_(rmask),
+    gmask_(gmask),
+    bmask_(bmask),
+    amask_(amask),
+    maxPooledSurfaces_(maxPooledSurfaces)
+{
+}
+
+UniqueSDLSurface SurfacePool::take()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        if (!surfaces_.empty()) {
+            UniqueSDLSurface surface = move(surfaces_.back());
+            surfaces_.pop_back();
+            return surface;
+        }
+    }
+
+    UniqueSDLSurface surface(makeUniqueSDLSurface(
+        SDL_CreateRGBSurface(0, width_, height_, depth_, rmask_, gmask_, bmask_, amask_)));
+    CHECK(surface.get()) << "SDL_CreateRGBSurface failed: " << SDL_GetError();
+
+    lock_guard<mutex> lock(mu_);
+    pixelFormat_ = surface->format->format;
+    pitch_ = surface->pitch;
+    ++numCreatedSurfaces_;
+    return surface;
+}
+
+void SurfacePool::recycle(UniqueSDLSurface surface)
+{
+    if (!surface.get())
+        return;
+
+    lock_guard<mutex> lock(mu_);
+    if (surfaces_.size() >= maxPooledSurfaces_)
+        return;
+    if (surface->w != width_ || surface->h != height_ ||
+        surface->format->format != pixelFormat_ || surface->pitch != pitch_)
+        return;
+
+    surface->userdata = nullptr;
+    surfaces_.push_back(move(surface));
+}
+
+int SurfacePool::numCreatedSurfaces() const
+{
+    lock_guard<mutex> lock(mu_);
+    return numCreatedSurfaces_;
+}
+
+int SurfacePool::numPooledSurfaces() const
+{
+    lock_guard<mutex> lock(mu_);
+    return static_cast<int>(surfaces_.size());
+}
@@ -0,0 +1,45 @@
+#ifndef CAPTURE_SURFACE_POOL_H_
+#define CAPTURE_SURFACE_POOL_H_
+
+#include <mutex>
+#include <vector>
+
+#include <SDL.h>
+
+#include "base/noncopyable.h"
+#include "gui/unique_sdl_surface.h"
+
+// SurfacePool recycles SDL surfaces of the same size and format, so that a source
+// doesn't allocate a new surface for every frame. This class is thread-safe.
+class SurfacePool : noncopyable {
+public:
+    // The arguments are the same as SDL_CreateRGBSurface.
+    SurfacePool(int width, int height, int depth,
+                Uint32 rmask, Uint32 gmask, Uint32 bmask, Uint32 amask,
+                size_t maxPooledSurfaces = 8);
+
+    // Returns a recycled surface if available. Otherwise, a new surface is created.
+    // The pixels of a recycled surface are not cleared.
+    UniqueSDLSurface take();
+
+    // Returns |surface| to the pool. A surface of the different size or format is just freed.
+    void recycle(UniqueSDLSurface surface);
+
+    int numCreatedSurfaces() const;
+    int numPooledSurfaces() const;
+
+private:
+    const int width_;
+    const int height_;
+    const int depth_;
+    const Uint32 rmask_, gmask_, bmask_, amask_;
+    const size_t maxPooledSurfaces_;
+
+    mutable std::mutex mu_;
+    std::vector<UniqueSDLSurface> surfaces_;
+    int numCreatedSurfaces_ = 0;
+    Uint32 pixelFormat_ = 0;
+    int pitch_ = 0;
+};
+
+#endif  // CAPTURE_SURFACE_POOL_H_
@@ -0,0 +1,61 @@
+#include "capture/surface_pool.h"
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(SurfacePoolTest, recycle)
+{
+    SurfacePool pool(16, 8, 32, 0, 0, 0, 0, 2);
+
+    UniqueSDLSurface s1(pool.take());
+    ASSERT_TRUE(s1.get());
+    EXPECT_EQ(16, s1->w);
+    EXPECT_EQ(8, s1->h);
+    EXPECT_EQ(1, pool.numCreatedSurfaces());
+
+    SDL_Surface* p1 = s1.get();
+    s1->userdata = reinterpret_cast<void*>(1);
+    pool.recycle(move(s1));
+    EXPECT_EQ(1, pool.numPooledSurfaces());
+
+    // The recycled surface is returned, and userdata is cleared.
+    UniqueSDLSurface s2(pool.take());
+    EXPECT_EQ(p1, s2.get());
+    EXPECT_EQ(nullptr, s2->userdata);
+    EXPECT_EQ(1, pool.numCreatedSurfaces());
+    EXPECT_EQ(0, pool.numPooledSurfaces());
+
+    // Since the pool is empty, a new surface is created.
+    UniqueSDLSurface s3(pool.take());
+    EXPECT_NE(p1, s3.get());
+    EXPECT_EQ(2, pool.numCreatedSurfaces());
+}
+
+TEST(SurfacePoolTest, recycleDifferentSurface)
+{
+    SurfacePool pool(16, 8, 32, 0, 0, 0, 0, 2);
+    UniqueSDLSurface s(pool.take());
+
+    // A surface of the different size is not pooled.
+    pool.recycle(makeUniqueSDLSurface(SDL_CreateRGBSurface(0, 8, 8, 32, 0, 0, 0, 0)));
+    EXPECT_EQ(0, pool.numPooledSurfaces());
+
+    pool.recycle(emptyUniqueSDLSurface());
+    EXPECT_EQ(0, pool.numPooledSurfaces());
+}
+
+TEST(SurfacePoolTest, maxPooledSurfaces)
+{
+    SurfacePool pool(16, 8, 32, 0, 0, 0, 0, 2);
+
+    UniqueSDLSurface s1(pool.take());
+    UniqueSDLSurface s2(pool.take());
+    UniqueSDLSurface s3(pool.take());
+    pool.recycle(move(s1));
+    pool.recycle(move(s2));
+    pool.recycle(move(s3));
+
+    EXPECT_EQ(3, pool.numCreatedSurfaces());
+    EXPECT_EQ(2, pool.numPooledSurfaces());
+}
@@ -1,5 +1,6 @@
 #include "capture/syntek_source.h"
 
+#include <chrono>
 #include <memory>
 #include <glog/logging.h>
 
@@ -9,7 +10,8 @@
 
 using namespace std;
 
-SyntekSource::SyntekSource()
+SyntekSource::SyntekSource() :
+    readySurface_(emptyUniqueSDLSurface())
 {
     width_ = 720;
     height_ = 480;
@@ -17,7 +19,7 @@ SyntekSource::SyntekSource()
 
     driver_ = SyntekDriver::open();
     if (driver_) {
-        currentPixelData_.reset(new int[height() * width()]);
+        initSurfacePool(32, 0, 0, 0, 0);
         ok_ = true;
     }
 }
@@ -31,9 +33,12 @@ bool SyntekSource::start()
                            const unsigned char* lower,
                            int bytesPerRow,
                            int numRowsPerBuffer) {
-        lock_guard<mutex> lock(mu_);
+        // Decode into a recycled surface directly. The surface is passed to the consumer as is.
+        UniqueSDLSurface surface(takeSurface());
+        CHECK_EQ(surface->pitch, width() * 4);
+        CHECK_EQ(SDL_LockSurface(surface.get()), 0);
+        Uint32* currentPixelData = static_cast<Uint32*>(surface->pixels);
 
-        // Copy to the current pixel data.
         int pos = 0;
         for (int y = 0; y < numRowsPerBuffer; ++y) {
             // For higher
@@ -41,9 +46,9 @@ bool SyntekSource::start()
                 int u = higher[0], y1 = higher[1], v = higher[2], y2 = higher[3];
                 int r, g, b;
                 convertUVY2RGBA(u, v, y1, &r, &g, &b);
-                currentPixelData_[pos++] = b + (g << 8) + (r << 16);
+                currentPixelData[pos++] = b + (g << 8) + (r << 16);
                 convertUVY2RGBA(u, v, y2, &r, &g, &b);
-                currentPixelData_[pos++] = b + (g << 8) + (r << 16);
+                currentPixelData[pos++] = b + (g << 8) + (r << 16);
                 higher += 4;
             }
             // For lower
@@ -51,13 +56,19 @@ bool SyntekSource::start()
                 int u = lower[0], y1 = lower[1], v = lower[2], y2 = lower[3];
                 int r, g, b;
                 convertUVY2RGBA(u, v, y1, &r, &g, &b);
-                currentPixelData_[pos++] = b + (g << 8) + (r << 16);
+                currentPixelData[pos++] = b + (g << 8) + (r << 16);
                 convertUVY2RGBA(u, v, y2, &r, &g, &b);
-                currentPixelData_[pos++] = b + (g << 8) + (r << 16);
+                currentPixelData[pos++] = b + (g << 8) + (r << 16);
                 lower += 4;
             }
         }
 
+        SDL_UnlockSurface(surface.get());
+
+        lock_guard<mutex> lock(mu_);
+        // When the previous frame has not been taken yet, it's replaced with the new one.
+        recycleFrame(move(readySurface_));
+        readySurface_ = move(surface);
         cond_.notify_one();
     };
 
@@ -71,17 +82,16 @@ bool SyntekSource::start()
 
 UniqueSDLSurface SyntekSource::getNextFrame()
 {
-    if (!currentPixelData_)
-        return makeUniqueSDLSurface(nullptr);
+    if (!ok())
+        return emptyUniqueSDLSurface();
 
-    SDL_Surface* surface = SDL_CreateRGBSurface(0, width(), height(), 32, 0, 0, 0, 0);
     unique_lock<mutex> lock(mu_);
-    cond_.wait(lock);
 
-    CHECK_EQ(SDL_LockSurface(surface), 0);
-    memmove(surface->pixels, currentPixelData_.get(), width() * height() * sizeof(int));
-    SDL_UnlockSurface(surface);
-    return makeUniqueSDLSurface(surface);
+    // Don't wait forever, so that the caller can stop.
+    if (!cond_.wait_for(lock, chrono::milliseconds(100), [this]() { return readySurface_.get() != nullptr; }))
+        return emptyUniqueSDLSurface();
+
+    return move(readySurface_);
 }
 
 void SyntekSource::runLoop()
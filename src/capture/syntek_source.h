@@ -32,7 +32,8 @@ private:
     std::condition_variable cond_;
 
     SyntekDriver* driver_;
-    std::unique_ptr<int[]> currentPixelData_;
+    // The latest frame not taken by getNextFrame() yet.
+    UniqueSDLSurface readySurface_;
 };
 
 #endif
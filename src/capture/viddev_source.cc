@@ -5,6 +5,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/select.h>
 #include <sys/stat.h>
@@ -104,6 +105,9 @@ void showCurrentAudio(int fd) {
 VidDevSource::VidDevSource(const char* dev)
   : dev_(dev) {
   init();
+  // The same format as the buffers. This document says rmask and bmask should be swapped, but hmm?
+  // http://linuxtv.org/downloads/v4l-dvb-apis/packed-rgb.html
+  initSurfacePool(16, 31 << 11, 63 << 5, 31, 0);
 }
 
 void VidDevSource::init() {
@@ -211,13 +215,6 @@ void VidDevSource::initBuffers() {
                                     PROT_READ | PROT_WRITE, /* recommended */
                                     MAP_SHARED,             /* recommended */
                                     fd_, buffer.m.offset);
-    // This document says rmask and bmask should be swapped, but hmm?
-    // http://linuxtv.org/downloads/v4l-dvb-apis/packed-rgb.html
-    buffers_[i].surface = SDL_CreateRGBSurfaceFrom(buffers_[i].start,
-                                                   width_, height_, 16,
-                                                   width_ * 2,
-                                                   31 << 11, 63 << 5, 31, 0);
-    assert(buffers_[i].surface);
 
     fprintf(stderr, " %lu:%p+%lu", i, buffers_[i].start, buffers_[i].length);
     if (MAP_FAILED == buffers_[i].start) {
@@ -290,10 +287,23 @@ UniqueSDLSurface VidDevSource::getNextFrame() {
   fprintf(stderr, "%d %d\n", cnt++, buffer.index);
 #endif
 
+  // The buffer is queued again soon, so copy it to a recycled surface.
+  // The pixel format is the same, so no conversion is necessary.
+  UniqueSDLSurface surface(takeSurface());
+  const int bytesPerRow = width_ * 2;
+  if (surface->pitch == bytesPerRow) {
+    memcpy(surface->pixels, buf.start, bytesPerRow * height_);
+  } else {
+    for (int y = 0; y < height_; ++y) {
+      memcpy(static_cast<char*>(surface->pixels) + y * surface->pitch,
+             buf.start + y * bytesPerRow, bytesPerRow);
+    }
+  }
+
   if (v4l2_ioctl(fd_, VIDIOC_QBUF, &buffer) < 0) {
     perror("VIDIOC_QBUF");
     exit(EXIT_FAILURE);
   }
 
-  return makeUniqueSDLSurface(buf.surface);
+  return surface;
 }
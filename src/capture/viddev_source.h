@@ -16,7 +16,6 @@ private:
     struct Buffer {
         char* start;
         size_t length;
-        SDL_Surface* surface;
     };
 
     void init();
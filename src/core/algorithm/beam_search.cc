@@ -0,0 +1,175 @@
+#include "core/algorithm/beam_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "base/wait_group.h"
+#include "core/algorithm/plan.h"
+#include "core/kumipuyo_seq.h"
+
+using namespace std;
+
+namespace {
+
+struct Node {
+    CoreField field;
+    vector<Decision> decisions;
+    double score;
+    int numChigiri;
+    int totalFrames;
+    uint64_t hash;
+};
+
+struct FiredRensa {
+    RensaResult rensaResult;
+    vector<Decision> decisions;
+};
+
+// FNV-1a over the puyos in the field. Only the cells under the heights are visited.
+uint64_t fieldHash(const CoreField& field)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (int x = 1; x <= CoreField::WIDTH; ++x) {
+        for (int y = 1; y <= field.height(x); ++y) {
+            h ^= static_cast<uint64_t>(field.color(x, y));
+            h *= 1099511628211ULL;
+        }
+        // Separates the columns.
+        h ^= 0xFF;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void expand(const Node& parent, const KumipuyoSeq& seq, const BeamSearch::EvaluationCallback& callback,
+            const Deadline& deadline, vector<Node>* children, FiredRensa* fired, int* numEvaluated)
+{
+    Plan::iterateAvailablePlans(parent.field, seq, 1, [&](const RefPlan& plan) {
+        if (plan.field().color(3, 12) != PuyoColor::EMPTY)
+            return;
+
+        vector<Decision> decisions(parent.decisions);
+        decisions.push_back(plan.decisions().back());
+
+        int numChigiri = parent.numChigiri + plan.numChigiri();
+        RefPlan accumulated(plan.field(), decisions, plan.rensaResult(), numChigiri,
+                            parent.totalFrames, plan.lastDropFrames());
+        double score = callback(accumulated);
+        ++*numEvaluated;
+
+        if (plan.isRensaPlan() && fired->rensaResult.score < plan.score()) {
+            fired->rensaResult = plan.rensaResult();
+            fired->decisions = decisions;
+        }
+
+        if (std::isinf(score) && score < 0)
+            return;
+
+        children->push_back(Node {
+            plan.field(), std::move(decisions), score, numChigiri,
+            parent.totalFrames + plan.lastDropFrames() + plan.rensaResult().frames,
+            fieldHash(plan.field())
+        });
+    }, deadline);
+}
+
+// Merges the same fields keeping the best score, and keeps the best |beamWidth| nodes.
+vector<Node> selectBeam(vector<vector<Node>>* childrenList, int beamWidth)
+{
+    vector<Node> nodes;
+    unordered_map<uint64_t, size_t> index;
+    for (auto& children : *childrenList) {
+        for (auto& child : children) {
+            auto it = index.find(child.hash);
+            if (it == index.end()) {
+                index.emplace(child.hash, nodes.size());
+                nodes.push_back(std::move(child));
+                continue;
+            }
+
+            Node& node = nodes[it->second];
+            // Hash collision. Keep the first one.
+            if (node.field != child.field)
+                continue;
+            if (node.score < child.score)
+                node = std::move(child);
+        }
+    }
+
+    auto better = [](const Node& lhs, const Node& rhs) { return lhs.score > rhs.score; };
+    if (static_cast<int>(nodes.size()) > beamWidth) {
+        nth_element(nodes.begin(), nodes.begin() + beamWidth, nodes.end(), better);
+        nodes.resize(beamWidth);
+    }
+    sort(nodes.begin(), nodes.end(), better);
+    return nodes;
+}
+
+} // anonymous namespace
+
+BeamSearch::BeamSearch(int beamWidth, Executor* executor) :
+    beamWidth_(beamWidth),
+    executor_(executor)
+{
+    CHECK_GT(beamWidth, 0);
+}
+
+BeamSearchResult BeamSearch::search(const CoreField& field, const KumipuyoSeq& kumipuyoSeq, int maxDepth,
+                                    const EvaluationCallback& callback, const Deadline& deadline) const
+{
+    BeamSearchResult result;
+
+    vector<Node> beam;
+    beam.push_back(Node { field, vector<Decision>(), 0.0, 0, 0, fieldHash(field) });
+
+    int depth = std::min(maxDepth, kumipuyoSeq.size());
+    for (int d = 0; d < depth; ++d) {
+        KumipuyoSeq seq { kumipuyoSeq.get(d) };
+
+        vector<vector<Node>> childrenList(beam.size());
+        vector<FiredRensa> firedList(beam.size());
+        vector<int> numEvaluatedList(beam.size());
+        if (executor_ && beam.size() > 1) {
+            WaitGroup wg;
+            wg.add(beam.size());
+            for (size_t i = 0; i < beam.size(); ++i) {
+                executor_->submit([&, i]() {
+                    expand(beam[i], seq, callback, deadline, &childrenList[i], &firedList[i], &numEvaluatedList[i]);
+                    wg.done();
+                });
+            }
+            wg.waitUntilDone();
+        } else {
+            for (size_t i = 0; i < beam.size(); ++i)
+                expand(beam[i], seq, callback, deadline, &childrenList[i], &firedList[i], &numEvaluatedList[i]);
+        }
+
+        for (size_t i = 0; i < beam.size(); ++i) {
+            result.numEvaluated += numEvaluatedList[i];
+            if (result.rensaResult.score < firedList[i].rensaResult.score) {
+                result.rensaResult = firedList[i].rensaResult;
+                result.rensaDecisions = std::move(firedList[i].decisions);
+            }
+        }
+
+        // The hand might not have been expanded completely.
+        if (deadline.hasPassed())
+            break;
+
+        vector<Node> nextBeam = selectBeam(&childrenList, beamWidth_);
+        if (nextBeam.empty())
+            break;
+
+        beam = std::move(nextBeam);
+        result.depth = d + 1;
+        result.decisions = beam.front().decisions;
+        result.score = beam.front().score;
+    }
+
+    return result;
+}
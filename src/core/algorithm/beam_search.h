@@ -0,0 +1,62 @@
+#ifndef CORE_ALGORITHM_BEAM_SEARCH_H_
+#define CORE_ALGORITHM_BEAM_SEARCH_H_
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "base/deadline.h"
+#include "base/noncopyable.h"
+#include "core/core_field.h"
+#include "core/decision.h"
+#include "core/rensa_result.h"
+
+class Executor;
+class KumipuyoSeq;
+class RefPlan;
+
+struct BeamSearchResult {
+    // The decisions to the best field in the deepest searched hand.
+    std::vector<Decision> decisions;
+    double score = -std::numeric_limits<double>::infinity();
+    // The number of hands searched completely.
+    int depth = 0;
+
+    // The rensa having the best score fired in the search, and the decisions to fire it.
+    // |rensaDecisions| is empty if no rensa has been fired.
+    RensaResult rensaResult;
+    std::vector<Decision> rensaDecisions;
+
+    int numEvaluated = 0;
+};
+
+// BeamSearch searches long plans with known kumipuyos (e.g. in endless mode).
+// Unlike Plan::iterateAvailablePlans(), only the best |beamWidth| fields are
+// expanded in each hand, so the number of evaluations grows linearly with depth.
+// The fields reached with different decisions are merged.
+class BeamSearch : noncopyable {
+public:
+    // The plan passed to the callback has all the decisions from the root.
+    // framesToIgnite() and numChigiri() are also accumulated from the root, but
+    // rensaResult() is the rensa fired with the last decision. Return -infinity
+    // to prune the plan. The callback is called from the threads of |executor|
+    // if it's specified.
+    typedef std::function<double (const RefPlan&)> EvaluationCallback;
+
+    // When |executor| is not nullptr, the fields in a hand are expanded in parallel.
+    // Doesn't take the ownership of |executor|.
+    explicit BeamSearch(int beamWidth, Executor* executor = nullptr);
+
+    // Searches at most |maxDepth| hands (and at most |kumipuyoSeq.size()| hands).
+    // When |deadline| has passed, returns the result of the last completed hand.
+    BeamSearchResult search(const CoreField&, const KumipuyoSeq&, int maxDepth,
+                            const EvaluationCallback&, const Deadline& deadline = Deadline()) const;
+
+    int beamWidth() const { return beamWidth_; }
+
+private:
+    int beamWidth_;
+    Executor* executor_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "core/algorithm/beam_search.h"
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "base/time_stamp_counter.h"
+#include "core/algorithm/plan.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq.h"
+#include "core/sequence_generator.h"
+
+using namespace std;
+
+namespace {
+
+double evaluate(const RefPlan& plan)
+{
+    double s = -plan.score();
+    for (int x = 1; x <= CoreField::WIDTH; ++x)
+        s -= plan.field().height(x) * plan.field().height(x);
+    return s;
+}
+
+void runSearch(int beamWidth, int depth, Executor* executor)
+{
+    TimeStampCounterData tsc;
+    BeamSearch beamSearch(beamWidth, executor);
+
+    for (int seed = 0; seed < 10; ++seed) {
+        KumipuyoSeq seq = generateRandomSequenceWithSeed(seed);
+        ScopedTimeStampCounter stsc(&tsc);
+        beamSearch.search(CoreField(), seq, depth, evaluate);
+    }
+
+    tsc.showStatistics();
+}
+
+}
+
+TEST(BeamSearchPerformanceTest, Width32Depth10)
+{
+    runSearch(32, 10, nullptr);
+}
+
+TEST(BeamSearchPerformanceTest, Width32Depth15)
+{
+    runSearch(32, 15, nullptr);
+}
+
+TEST(BeamSearchPerformanceTest, Width32Depth15Parallel)
+{
+    Executor executor(4);
+    executor.start();
+    runSearch(32, 15, &executor);
+}
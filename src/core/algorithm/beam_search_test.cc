@@ -0,0 +1,119 @@
+#include "core/algorithm/beam_search.h"
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "core/algorithm/plan.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq.h"
+
+using namespace std;
+
+namespace {
+
+double scoreOfFiredRensa(const RefPlan& plan)
+{
+    return plan.score() - plan.totalFrames() * 0.01;
+}
+
+}
+
+TEST(BeamSearchTest, findRensa)
+{
+    CoreField field("  YY  ");
+    KumipuyoSeq seq("RRRRYY");
+
+    // This 2-rensa should be found.
+    //   RR
+    // RRYYYY
+    // The beam is wide enough to keep all the fields.
+    BeamSearch beamSearch(512);
+    BeamSearchResult result = beamSearch.search(field, seq, 3, scoreOfFiredRensa);
+
+    EXPECT_EQ(3, result.depth);
+    EXPECT_EQ(3U, result.decisions.size());
+    EXPECT_LE(2, result.rensaResult.chains);
+    EXPECT_FALSE(result.rensaDecisions.empty());
+    EXPECT_LT(0, result.numEvaluated);
+}
+
+TEST(BeamSearchTest, sameAsGreedyWithDepth1)
+{
+    CoreField field(
+        "B     "
+        "BRRG  "
+        "RBBGG ");
+    KumipuyoSeq seq("GYRB");
+
+    double bestScore = -numeric_limits<double>::infinity();
+    Plan::iterateAvailablePlans(field, KumipuyoSeq { seq.get(0) }, 1, [&](const RefPlan& plan) {
+        bestScore = max(bestScore, scoreOfFiredRensa(plan));
+    });
+
+    BeamSearch beamSearch(1);
+    BeamSearchResult result = beamSearch.search(field, seq, 1, scoreOfFiredRensa);
+
+    EXPECT_EQ(1, result.depth);
+    EXPECT_EQ(bestScore, result.score);
+}
+
+TEST(BeamSearchTest, depthIsLimitedBySequence)
+{
+    BeamSearch beamSearch(4);
+    BeamSearchResult result = beamSearch.search(CoreField(), KumipuyoSeq("RRGG"), 10, scoreOfFiredRensa);
+
+    EXPECT_EQ(2, result.depth);
+    EXPECT_EQ(2U, result.decisions.size());
+}
+
+TEST(BeamSearchTest, prune)
+{
+    BeamSearch beamSearch(4);
+    BeamSearchResult result = beamSearch.search(CoreField(), KumipuyoSeq("RRGG"), 2, [](const RefPlan&) {
+        return -numeric_limits<double>::infinity();
+    });
+
+    EXPECT_EQ(0, result.depth);
+    EXPECT_TRUE(result.decisions.empty());
+}
+
+TEST(BeamSearchTest, deadline)
+{
+    BeamSearch beamSearch(4);
+    Deadline deadline = Deadline::fromNow(chrono::microseconds(0));
+    BeamSearchResult result = beamSearch.search(CoreField(), KumipuyoSeq("RRGGBBYY"), 4,
+                                                scoreOfFiredRensa, deadline);
+
+    EXPECT_EQ(0, result.depth);
+}
+
+TEST(BeamSearchTest, parallel)
+{
+    CoreField field(
+        "B     "
+        "BRRG  "
+        "RBBGG ");
+    KumipuyoSeq seq("GYRBYYGRBG");
+
+    // Makes the score depend on the shape so that ties are rare.
+    auto callback = [](const RefPlan& plan) {
+        double s = plan.score();
+        for (int x = 1; x <= CoreField::WIDTH; ++x)
+            s += plan.field().height(x) * x * 0.1;
+        return s;
+    };
+
+    BeamSearchResult expected = BeamSearch(16).search(field, seq, 5, callback);
+
+    Executor executor(4);
+    executor.start();
+    BeamSearchResult actual = BeamSearch(16, &executor).search(field, seq, 5, callback);
+    executor.stop();
+
+    EXPECT_EQ(expected.depth, actual.depth);
+    EXPECT_EQ(expected.decisions, actual.decisions);
+    EXPECT_EQ(expected.score, actual.score);
+    EXPECT_EQ(expected.numEvaluated, actual.numEvaluated);
+}
@@ -1,8 +1,14 @@
 #include "core/algorithm/plan.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <random>
 #include <sstream>
 
+#include <glog/logging.h>
+
 #include "core/constant.h"
 #include "core/kumipuyo_seq.h"
 #include "core/puyo_controller.h"
@@ -74,6 +80,7 @@ void iterateAvailablePlansInternal(const CoreField& field,
                                    int maxDepth,
                                    int currentNumChigiri,
                                    int totalFrames,
+                                   const Deadline* deadline,
                                    Callback callback)
 {
     const Kumipuyo* ptr;
@@ -98,6 +105,8 @@ void iterateAvailablePlansInternal(const CoreField& field,
 
         for (int j = 0; j < num_decisions; j++) {
             DCHECK(nextField == field);
+            if (deadline && deadline->hasPassed())
+                return;
 
             const Decision& decision = DECISIONS[j];
             if (!PuyoController::isReachable(field, decision))
@@ -129,7 +138,8 @@ void iterateAvailablePlansInternal(const CoreField& field,
                     callback(nextField, decisions, currentNumChigiri + isChigiri, totalFrames, dropFrames, false);
                 } else {
                     iterateAvailablePlansInternal(nextField, kumipuyoSeq, decisions, currentDepth + 1, maxDepth,
-                                                  currentNumChigiri + isChigiri, totalFrames + dropFrames, callback);
+                                                  currentNumChigiri + isChigiri, totalFrames + dropFrames,
+                                                  deadline, callback);
                 }
                 decisions.pop_back();
                 nextField.undoKumipuyo(decision);
@@ -143,6 +153,16 @@ void Plan::iterateAvailablePlans(const CoreField& field,
                                  const KumipuyoSeq& kumipuyoSeq,
                                  int maxDepth,
                                  const Plan::IterationCallback& callback)
+{
+    iterateAvailablePlans(field, kumipuyoSeq, maxDepth, callback, Deadline::infinite());
+}
+
+// static
+void Plan::iterateAvailablePlans(const CoreField& field,
+                                 const KumipuyoSeq& kumipuyoSeq,
+                                 int maxDepth,
+                                 const Plan::IterationCallback& callback,
+                                 const Deadline& deadline)
 {
     std::vector<Decision> decisions;
     decisions.reserve(maxDepth);
@@ -167,7 +187,8 @@ void Plan::iterateAvailablePlans(const CoreField& field,
         }
     };
 
-    iterateAvailablePlansInternal(field, kumipuyoSeq, decisions, 0, maxDepth, 0, 0, f);
+    iterateAvailablePlansInternal(field, kumipuyoSeq, decisions, 0, maxDepth, 0, 0,
+                                  deadline.isInfinite() ? nullptr : &deadline, f);
 }
 
 // static
@@ -178,5 +199,169 @@ void Plan::iterateAvailablePlansWithoutFiring(const CoreField& field,
 {
     std::vector<Decision> decisions;
     decisions.reserve(maxDepth);
-    iterateAvailablePlansInternal(field, kumipuyoSeq, decisions, 0, maxDepth, 0, 0, callback);
+    iterateAvailablePlansInternal(field, kumipuyoSeq, decisions, 0, maxDepth, 0, 0, nullptr, callback);
+}
+
+namespace {
+
+const double NO_PLAN_SCORE = -numeric_limits<double>::infinity();
+
+// Searches the expectimax tree. The nodes for known kumipuyos maximize the score,
+// and the nodes for unknown kumipuyos average the score over the samples.
+class ExpectedPlanSearcher {
+public:
+    ExpectedPlanSearcher(const KumipuyoSeq& kumipuyoSeq, int maxDepth,
+                         const Plan::SamplingStrategy& strategy,
+                         const Plan::EvaluationCallback& callback,
+                         const Deadline& deadline) :
+        kumipuyoSeq_(kumipuyoSeq),
+        maxDepth_(maxDepth),
+        strategy_(strategy),
+        callback_(callback),
+        deadline_(deadline),
+        samples_(maxDepth)
+    {
+        decisions_.reserve(maxDepth);
+
+        // Since the colors of a kumipuyo are chosen independently, a kumipuyo of 2 colors
+        // is twice as likely as one of 1 color. This is the same as
+        // TsumoPossibility::possibility(PuyoSet of the kumipuyo, 2), without its initialization.
+        double weights[10];
+        for (int i = 0; i < 10; ++i)
+            weights[i] = ALL_KUMIPUYO_KINDS[i].axis == ALL_KUMIPUYO_KINDS[i].child ? 1.0 / 16 : 2.0 / 16;
+
+        // The same kind is never sampled twice, since it would be evaluated again for nothing.
+        int numSamples = min(strategy.numSamples, 10);
+        mt19937 rng(strategy.seed);
+        for (int depth = kumipuyoSeq.size(); depth < maxDepth; ++depth) {
+            double rest[10];
+            copy(weights, weights + 10, rest);
+            for (int i = 0; i < numSamples; ++i) {
+                discrete_distribution<int> dist(rest, rest + 10);
+                int k = dist(rng);
+                samples_[depth].push_back(Sample { ALL_KUMIPUYO_KINDS[k], weights[k] });
+                rest[k] = 0;
+            }
+        }
+    }
+
+    // Returns the best score to drop |kumipuyo| on |field|.
+    double searchMax(const CoreField& field, const Kumipuyo& kumipuyo, int depth,
+                     int numChigiri, int totalFrames, Decision* bestDecision)
+    {
+        double best = NO_PLAN_SCORE;
+        CoreField nextField(field);
+
+        int numDecisions = (kumipuyo.axis == kumipuyo.child) ? 11 : 22;
+        for (int j = 0; j < numDecisions; ++j) {
+            if (deadline_.hasPassed())
+                break;
+
+            const Decision& decision = DECISIONS[j];
+            if (!PuyoController::isReachable(field, decision))
+                continue;
+            if (!nextField.dropKumipuyo(decision, kumipuyo))
+                continue;
+
+            bool isChigiri = field.isChigiriDecision(decision);
+            int dropFrames = field.framesToDropNext(decision);
+
+            double score = NO_PLAN_SCORE;
+            decisions_.push_back(decision);
+            if (nextField.rensaWillOccurWhenLastDecisionIs(decision)) {
+                CoreField cf(nextField);
+                CoreField::SimulationContext context(CoreField::SimulationContext::fromLastDecision(cf, decision));
+                RensaResult rensaResult = cf.simulateWithContext(&context);
+                if (cf.color(3, 12) == PuyoColor::EMPTY)
+                    score = callback_(RefPlan(cf, decisions_, rensaResult, numChigiri + isChigiri, totalFrames, dropFrames));
+            } else if (nextField.color(3, 12) == PuyoColor::EMPTY) {
+                if (depth + 1 == maxDepth_) {
+                    score = callback_(RefPlan(nextField, decisions_, RensaResult(),
+                                              numChigiri + isChigiri, totalFrames, dropFrames));
+                } else {
+                    score = searchNext(nextField, depth + 1, numChigiri + isChigiri, totalFrames + dropFrames, best);
+                }
+            }
+            decisions_.pop_back();
+            nextField.undoKumipuyo(decision);
+
+            if (best < score) {
+                best = score;
+                if (bestDecision)
+                    *bestDecision = decision;
+            }
+        }
+
+        return best;
+    }
+
+private:
+    // |alpha| is the best score of the siblings.
+    double searchNext(const CoreField& field, int depth, int numChigiri, int totalFrames, double alpha)
+    {
+        if (depth < kumipuyoSeq_.size())
+            return searchMax(field, kumipuyoSeq_.get(depth), depth, numChigiri, totalFrames, nullptr);
+
+        // The samples are distinct, so they are averaged with their possibilities.
+        double weightSum = 0.0;
+        double sum = 0.0;
+        double squareSum = 0.0;
+        int n = 0;
+        for (const Sample& sample : samples_[depth]) {
+            double score = searchMax(field, sample.kumipuyo, depth, numChigiri, totalFrames, nullptr);
+            // We will die with this kumipuyo.
+            if (score == NO_PLAN_SCORE)
+                return NO_PLAN_SCORE;
+
+            weightSum += sample.weight;
+            sum += sample.weight * score;
+            squareSum += sample.weight * score * score;
+            ++n;
+            if (n < strategy_.minSamples)
+                continue;
+
+            double average = sum / weightSum;
+            if (strategy_.cutoff && average + strategy_.cutoffMargin < alpha)
+                break;
+            if (strategy_.tolerance > 0) {
+                double variance = max(0.0, squareSum / weightSum - average * average);
+                if (sqrt(variance / n) < strategy_.tolerance)
+                    break;
+            }
+        }
+
+        return n > 0 ? sum / weightSum : NO_PLAN_SCORE;
+    }
+
+    struct Sample {
+        Kumipuyo kumipuyo;
+        // The possibility of |kumipuyo|.
+        double weight;
+    };
+
+    const KumipuyoSeq& kumipuyoSeq_;
+    const int maxDepth_;
+    const Plan::SamplingStrategy& strategy_;
+    const Plan::EvaluationCallback& callback_;
+    const Deadline& deadline_;
+    // |samples_[depth]| is the sampled kumipuyos for the unknown hand |depth|.
+    vector<vector<Sample>> samples_;
+    vector<Decision> decisions_;
+};
+
+} // anonymous namespace
+
+// static
+double Plan::searchExpectedBestPlan(const CoreField& field,
+                                    const KumipuyoSeq& kumipuyoSeq,
+                                    int maxDepth,
+                                    const SamplingStrategy& strategy,
+                                    const EvaluationCallback& callback,
+                                    Decision* bestFirstDecision,
+                                    const Deadline& deadline)
+{
+    CHECK_GE(kumipuyoSeq.size(), 1);
+
+    ExpectedPlanSearcher searcher(kumipuyoSeq, maxDepth, strategy, callback, deadline);
+    return searcher.searchMax(field, kumipuyoSeq.get(0), 0, 0, 0, bestFirstDecision);
 }
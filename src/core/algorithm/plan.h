@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "base/deadline.h"
 #include "base/noncopyable.h"
 #include "core/core_field.h"
 #include "core/decision.h"
@@ -26,11 +27,42 @@ public:
     typedef std::function<void (const RefPlan&)> IterationCallback;
     // if |kumipuyos.size()| < |depth|, we will add extra kumipuyo.
     static void iterateAvailablePlans(const CoreField&, const KumipuyoSeq&, int depth, const IterationCallback&);
+    // Same as above, but stops iterating when |deadline| has passed.
+    static void iterateAvailablePlans(const CoreField&, const KumipuyoSeq&, int depth, const IterationCallback&,
+                                      const Deadline& deadline);
 
     typedef std::function<void (const CoreField&, const std::vector<Decision>&,
                                 int numChigiri, int framesToIgnite, int lastDropFrames, bool shouldFire)> RensaIterationCallback;
     static void iterateAvailablePlansWithoutFiring(const CoreField&, const KumipuyoSeq&, int depth, const RensaIterationCallback&);
 
+    struct SamplingStrategy {
+        // The number of distinct kumipuyo kinds sampled for each unknown hand (at most 10).
+        int numSamples = 3;
+        // Sampling stops when the standard error of the average gets less than |tolerance|
+        // after |minSamples| samples. 0 means sampling all |numSamples|.
+        int minSamples = 2;
+        double tolerance = 0.0;
+        // When |cutoff| is true, sampling stops when the average is less than the best sibling
+        // by |cutoffMargin| after |minSamples| samples, since the plan won't be chosen.
+        // This is faster, but the averages of the cut plans are biased by the first samples.
+        bool cutoff = false;
+        double cutoffMargin = 0.0;
+        unsigned int seed = 1;
+    };
+
+    typedef std::function<double (const RefPlan&)> EvaluationCallback;
+    // Searches the plans with |depth| hands, and returns the best expected score.
+    // Unlike iterateAvailablePlans(), the kinds of the kumipuyos after |kumipuyoSeq| are
+    // sampled without replacement by their possibilities, and the best scores for
+    // the samples are averaged with the possibilities instead of maximized. The same
+    // samples are used for all the plans, so the plans are compared fairly.
+    // When |deadline| has passed, the best score so far is returned.
+    // |kumipuyoSeq| must have at least 1 kumipuyo. Returns -infinity if no plan is available.
+    static double searchExpectedBestPlan(const CoreField&, const KumipuyoSeq&, int depth,
+                                         const SamplingStrategy&, const EvaluationCallback&,
+                                         Decision* bestFirstDecision,
+                                         const Deadline& deadline = Deadline());
+
     const CoreField& field() const { return field_; }
 
     const Decision& firstDecision() const { return decisions_[0]; }
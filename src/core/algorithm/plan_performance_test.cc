@@ -98,3 +98,37 @@ TEST(PlanPerformanceTest, Filled24)
 
     tsc.showStatistics();
 }
+
+TEST(PlanPerformanceTest, Empty3WithUnknownKumipuyo)
+{
+    TimeStampCounterData tsc;
+
+    CoreField f;
+    KumipuyoSeq seq("RRGG");
+
+    // The 3rd kumipuyo is unknown. All the 10 kinds are enumerated.
+    for (int i = 0; i < 10; i++) {
+        ScopedTimeStampCounter stsc(&tsc);
+        Plan::iterateAvailablePlans(f, seq, 3, [](const RefPlan&){});
+    }
+
+    tsc.showStatistics();
+}
+
+TEST(PlanPerformanceTest, Empty3WithSampledKumipuyo)
+{
+    TimeStampCounterData tsc;
+
+    CoreField f;
+    KumipuyoSeq seq("RRGG");
+
+    // The 3rd kumipuyo is sampled.
+    Plan::SamplingStrategy strategy;
+    for (int i = 0; i < 10; i++) {
+        ScopedTimeStampCounter stsc(&tsc);
+        Decision decision;
+        Plan::searchExpectedBestPlan(f, seq, 3, strategy, [](const RefPlan&) { return 0.0; }, &decision);
+    }
+
+    tsc.showStatistics();
+}
@@ -72,3 +72,118 @@ TEST(Plan, numChigiri)
 
     EXPECT_TRUE(found);
 }
+
+TEST(Plan, iterateAvailablePlansWithDeadline)
+{
+    CoreField field;
+    KumipuyoSeq seq("RRBB");
+
+    int count = 0;
+    Plan::iterateAvailablePlans(field, seq, 2, [&count](const RefPlan&) { ++count; }, Deadline::infinite());
+    EXPECT_LT(0, count);
+
+    count = 0;
+    Deadline deadline(Deadline::Clock::now());
+    Plan::iterateAvailablePlans(field, seq, 2, [&count](const RefPlan&) { ++count; }, deadline);
+    EXPECT_EQ(0, count);
+}
+
+TEST(Plan, searchExpectedBestPlanWithKnownSequence)
+{
+    CoreField field("  YY  ");
+    KumipuyoSeq seq("RRRR");
+
+    // Without unknown kumipuyos, this should be the same as maximizing.
+    int maxScore = 0;
+    Plan::iterateAvailablePlans(field, seq, 2, [&maxScore](const RefPlan& plan) {
+        maxScore = std::max(maxScore, plan.score());
+    });
+
+    Decision decision;
+    double score = Plan::searchExpectedBestPlan(field, seq, 2, Plan::SamplingStrategy(),
+                                                [](const RefPlan& plan) { return plan.score(); }, &decision);
+    EXPECT_EQ(maxScore, score);
+    EXPECT_TRUE(decision.isValid());
+}
+
+TEST(Plan, searchExpectedBestPlanWithUnknownSequence)
+{
+    CoreField field("  YY  ");
+    KumipuyoSeq seq("RR");
+
+    // Maximizing over all the kumipuyos is optimistic. It assumes YY will come.
+    int maxScore = 0;
+    Plan::iterateAvailablePlans(field, seq, 2, [&maxScore](const RefPlan& plan) {
+        maxScore = std::max(maxScore, plan.score());
+    });
+
+    Plan::SamplingStrategy strategy;
+    strategy.numSamples = 8;
+    Decision decision;
+    int numEvaluated = 0;
+    double score = Plan::searchExpectedBestPlan(field, seq, 2, strategy, [&numEvaluated](const RefPlan& plan) {
+        ++numEvaluated;
+        return plan.score();
+    }, &decision);
+
+    EXPECT_LE(0, score);
+    EXPECT_GT(maxScore, score);
+    EXPECT_TRUE(decision.isValid());
+
+    // With the same seed, the result is the same.
+    Decision decision2;
+    EXPECT_EQ(score, Plan::searchExpectedBestPlan(field, seq, 2, strategy,
+                                                  [](const RefPlan& plan) { return plan.score(); }, &decision2));
+    EXPECT_EQ(decision, decision2);
+}
+
+TEST(Plan, searchExpectedBestPlanWithAllKinds)
+{
+    CoreField field("  YY  ");
+    KumipuyoSeq seq("RR");
+    auto evaluate = [](const RefPlan& plan) { return plan.score(); };
+
+    // The kinds are sampled without replacement, so sampling 10 kinds covers all the kinds,
+    // and the result is the exact expectation for any seed.
+    Plan::SamplingStrategy strategy;
+    strategy.numSamples = 10;
+    strategy.minSamples = 10;
+    strategy.seed = 1;
+    double score1 = Plan::searchExpectedBestPlan(field, seq, 2, strategy, evaluate, nullptr);
+    strategy.seed = 2;
+    double score2 = Plan::searchExpectedBestPlan(field, seq, 2, strategy, evaluate, nullptr);
+    EXPECT_NEAR(score1, score2, 1e-9);
+}
+
+TEST(Plan, searchExpectedBestPlanWithCutoff)
+{
+    CoreField field;
+    KumipuyoSeq seq("RR");
+
+    // The plan is better if the first kumipuyo is on the right.
+    auto evaluate = [](const RefPlan& plan) { return plan.decision(0).x; };
+
+    Plan::SamplingStrategy strategy;
+    strategy.numSamples = 8;
+    strategy.minSamples = 8;
+    strategy.cutoff = true;
+    int numEvaluated = 0;
+    Decision decision;
+    double score = Plan::searchExpectedBestPlan(field, seq, 2, strategy, [&](const RefPlan& plan) {
+        ++numEvaluated;
+        return evaluate(plan);
+    }, &decision);
+
+    strategy.minSamples = 1;
+    int numEvaluatedWithCutoff = 0;
+    Decision decisionWithCutoff;
+    double scoreWithCutoff = Plan::searchExpectedBestPlan(field, seq, 2, strategy, [&](const RefPlan& plan) {
+        ++numEvaluatedWithCutoff;
+        return evaluate(plan);
+    }, &decisionWithCutoff);
+
+    EXPECT_EQ(6, score);
+    EXPECT_EQ(score, scoreWithCutoff);
+    EXPECT_EQ(decision, decisionWithCutoff);
+    EXPECT_GT(numEvaluated, numEvaluatedWithCutoff);
+}
@@ -0,0 +1,107 @@
+#include "core/binary_frame.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace {
+// A frame larger than this is considered as broken.
+const size_t MAX_PAYLOAD_SIZE = 1 << 20;
+}
+
+namespace binary_frame {
+
+bool write(FILE* fp, const char* payload, size_t size)
+{
+    char header[HEADER_SIZE];
+    putInt32(putInt8(header, MAGIC), static_cast<int>(size));
+
+    if (fwrite(header, HEADER_SIZE, 1, fp) != 1)
+        return false;
+    if (size > 0 && fwrite(payload, size, 1, fp) != 1)
+        return false;
+    return fflush(fp) == 0;
+}
+
+bool read(FILE* fp, string* message, bool* binary)
+{
+    message->clear();
+
+    int c = getc(fp);
+    if (c == EOF)
+        return false;
+
+    if (c == MAGIC) {
+        *binary = true;
+
+        char sizeBuf[4];
+        if (fread(sizeBuf, sizeof(sizeBuf), 1, fp) != 1)
+            return false;
+        int size;
+        getInt32(sizeBuf, &size);
+        if (size < 0 || MAX_PAYLOAD_SIZE < static_cast<size_t>(size))
+            return false;
+
+        message->resize(size);
+        if (size > 0 && fread(&(*message)[0], size, 1, fp) != 1)
+            return false;
+        return true;
+    }
+
+    *binary = false;
+    message->push_back(static_cast<char>(c));
+    if (c == '\n') {
+        message->clear();
+        return true;
+    }
+
+    char buf[1000];
+    while (fgets(buf, sizeof(buf), fp)) {
+        size_t len = strlen(buf);
+        message->append(buf, len);
+        if (len > 0 && buf[len - 1] == '\n')
+            break;
+    }
+
+    if (!message->empty() && message->back() == '\n')
+        message->pop_back();
+    if (!message->empty() && message->back() == '\r')
+        message->pop_back();
+    return true;
+}
+
+ExtractResult extract(string* buffer, string* message, bool* binary)
+{
+    if (buffer->empty())
+        return ExtractResult::INCOMPLETE;
+
+    if ((*buffer)[0] == MAGIC) {
+        if (buffer->size() < HEADER_SIZE)
+            return ExtractResult::INCOMPLETE;
+
+        int size;
+        getInt32(buffer->data() + 1, &size);
+        if (size < 0 || MAX_PAYLOAD_SIZE < static_cast<size_t>(size))
+            return ExtractResult::BROKEN;
+        if (buffer->size() < HEADER_SIZE + size)
+            return ExtractResult::INCOMPLETE;
+
+        *binary = true;
+        message->assign(*buffer, HEADER_SIZE, size);
+        buffer->erase(0, HEADER_SIZE + size);
+        return ExtractResult::OK;
+    }
+
+    string::size_type pos = buffer->find('\n');
+    if (pos == string::npos)
+        return ExtractResult::INCOMPLETE;
+
+    *binary = false;
+    message->assign(*buffer, 0, pos);
+    buffer->erase(0, pos + 1);
+    if (!message->empty() && message->back() == '\r')
+        message->pop_back();
+    return ExtractResult::OK;
+}
+
+} // namespace binary_frame
@@ -0,0 +1,67 @@
+#ifndef CORE_BINARY_FRAME_H_
+#define CORE_BINARY_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// The server and clients talk either in text lines or in binary frames.
+// A binary frame is
+//   MAGIC (1 byte) | payload size (4 bytes, little endian) | payload
+// Since a text line never starts with MAGIC, a reader can tell them apart
+// by the first byte. So both formats can be mixed in one stream, and the
+// protocol can be switched without any synchronization.
+//
+// Negotiation:
+//   1. The server adds OFFER_TERM to text FrameRequests.
+//   2. A client that supports binary frames starts sending binary FrameResponses.
+//   3. When the server receives a binary FrameResponse, it starts sending
+//      binary FrameRequests.
+// Clients that don't know OFFER_TERM just ignore it, and the text format is used.
+namespace binary_frame {
+
+const char MAGIC = '\0';
+const size_t HEADER_SIZE = 5;
+// The second character is not used as a key of PlayerFrameRequest.
+const char OFFER_TERM[] = "BINARY=1";
+
+inline char* putInt8(char* p, int v) { *p = static_cast<char>(v); return p + 1; }
+inline char* putInt32(char* p, int v)
+{
+    uint32_t u = static_cast<uint32_t>(v);
+    p[0] = static_cast<char>(u & 0xFF);
+    p[1] = static_cast<char>((u >> 8) & 0xFF);
+    p[2] = static_cast<char>((u >> 16) & 0xFF);
+    p[3] = static_cast<char>((u >> 24) & 0xFF);
+    return p + 4;
+}
+
+inline const char* getInt8(const char* p, int* v) { *v = static_cast<int8_t>(*p); return p + 1; }
+inline const char* getInt32(const char* p, int* v)
+{
+    const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+    uint32_t u = q[0] | (q[1] << 8) | (q[2] << 16) | (static_cast<uint32_t>(q[3]) << 24);
+    *v = static_cast<int32_t>(u);
+    return p + 4;
+}
+
+// Writes a binary frame, and flushes |fp|.
+// Returns false if failed.
+bool write(FILE* fp, const char* payload, size_t size);
+
+// Reads a text line or a binary frame from |fp|. For a text line, the trailing
+// newline is removed, and |*binary| will be false.
+// Returns false on EOF or error.
+bool read(FILE* fp, std::string* message, bool* binary);
+
+enum class ExtractResult { OK, INCOMPLETE, BROKEN };
+
+// Takes a text line or a binary frame from the front of |buffer|, which has the bytes
+// read from a stream without blocking. The message is the same as read().
+// Returns INCOMPLETE if |buffer| doesn't have a whole message yet.
+ExtractResult extract(std::string* buffer, std::string* message, bool* binary);
+
+} // namespace binary_frame
+
+#endif
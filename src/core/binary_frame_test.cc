@@ -0,0 +1,89 @@
+#include "core/binary_frame.h"
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(BinaryFrameTest, readMixedMessages)
+{
+    FILE* fp = tmpfile();
+    ASSERT_TRUE(fp);
+
+    fprintf(fp, "ID=1 X=3 R=0\r\n");
+    EXPECT_TRUE(binary_frame::write(fp, "a\0b", 3));
+    fprintf(fp, "\n");
+    EXPECT_TRUE(binary_frame::write(fp, "", 0));
+    rewind(fp);
+
+    string message;
+    bool binary;
+
+    EXPECT_TRUE(binary_frame::read(fp, &message, &binary));
+    EXPECT_FALSE(binary);
+    EXPECT_EQ("ID=1 X=3 R=0", message);
+
+    EXPECT_TRUE(binary_frame::read(fp, &message, &binary));
+    EXPECT_TRUE(binary);
+    EXPECT_EQ(string("a\0b", 3), message);
+
+    EXPECT_TRUE(binary_frame::read(fp, &message, &binary));
+    EXPECT_FALSE(binary);
+    EXPECT_EQ("", message);
+
+    EXPECT_TRUE(binary_frame::read(fp, &message, &binary));
+    EXPECT_TRUE(binary);
+    EXPECT_EQ("", message);
+
+    EXPECT_FALSE(binary_frame::read(fp, &message, &binary));
+
+    fclose(fp);
+}
+
+TEST(BinaryFrameTest, extract)
+{
+    char header[binary_frame::HEADER_SIZE];
+    binary_frame::putInt32(binary_frame::putInt8(header, binary_frame::MAGIC), 3);
+
+    string message;
+    bool binary;
+
+    // A message might be split anywhere.
+    string buffer = "ID=1 X=3 R=0\r\n" + string(header, 2);
+    EXPECT_EQ(binary_frame::ExtractResult::OK, binary_frame::extract(&buffer, &message, &binary));
+    EXPECT_FALSE(binary);
+    EXPECT_EQ("ID=1 X=3 R=0", message);
+    EXPECT_EQ(binary_frame::ExtractResult::INCOMPLETE, binary_frame::extract(&buffer, &message, &binary));
+
+    buffer += string(header + 2, sizeof(header) - 2) + string("a\0", 2);
+    EXPECT_EQ(binary_frame::ExtractResult::INCOMPLETE, binary_frame::extract(&buffer, &message, &binary));
+
+    buffer += "b\nID=2";
+    EXPECT_EQ(binary_frame::ExtractResult::OK, binary_frame::extract(&buffer, &message, &binary));
+    EXPECT_TRUE(binary);
+    EXPECT_EQ(string("a\0b", 3), message);
+
+    EXPECT_EQ(binary_frame::ExtractResult::OK, binary_frame::extract(&buffer, &message, &binary));
+    EXPECT_FALSE(binary);
+    EXPECT_EQ("", message);
+
+    EXPECT_EQ(binary_frame::ExtractResult::INCOMPLETE, binary_frame::extract(&buffer, &message, &binary));
+    EXPECT_EQ("ID=2", buffer);
+
+    binary_frame::putInt32(header + 1, -1);
+    buffer = string(header, sizeof(header));
+    EXPECT_EQ(binary_frame::ExtractResult::BROKEN, binary_frame::extract(&buffer, &message, &binary));
+}
+
+TEST(BinaryFrameTest, int32)
+{
+    char buf[4];
+    int v;
+
+    binary_frame::getInt32(binary_frame::putInt32(buf, -123456) - 4, &v);
+    EXPECT_EQ(-123456, v);
+    binary_frame::getInt32(binary_frame::putInt32(buf, 0x7FFFFFFF) - 4, &v);
+    EXPECT_EQ(0x7FFFFFFF, v);
+}
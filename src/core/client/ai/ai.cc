@@ -1,10 +1,14 @@
 #include "core/client/ai/ai.h"
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <chrono>
+#include <vector>
 
 #include "base/base.h"
+#include "core/client/ai/ponderer.h"
 #include "core/constant.h"
 #include "core/core_field.h"
 #include "core/decision.h"
@@ -19,6 +23,29 @@
 
 using namespace std;
 
+DEFINE_int32(think_budget_ms, 300, "time budget to think a hand [ms]");
+DEFINE_int32(fast_think_budget_ms, 30, "time budget to think a hand immediately [ms]");
+DEFINE_int32(ponder_budget_ms, 1000, "time budget to ponder a possible hand [ms]");
+
+namespace {
+
+// Possible NEXT2 to ponder. Since the colors of a kumipuyo are chosen independently,
+// kumipuyos of 2 colors are twice as likely as ones of 1 color. So they come first.
+const Kumipuyo PONDER_CANDIDATES[] = {
+    Kumipuyo(PuyoColor::RED, PuyoColor::BLUE),
+    Kumipuyo(PuyoColor::RED, PuyoColor::YELLOW),
+    Kumipuyo(PuyoColor::RED, PuyoColor::GREEN),
+    Kumipuyo(PuyoColor::BLUE, PuyoColor::YELLOW),
+    Kumipuyo(PuyoColor::BLUE, PuyoColor::GREEN),
+    Kumipuyo(PuyoColor::YELLOW, PuyoColor::GREEN),
+    Kumipuyo(PuyoColor::RED, PuyoColor::RED),
+    Kumipuyo(PuyoColor::BLUE, PuyoColor::BLUE),
+    Kumipuyo(PuyoColor::YELLOW, PuyoColor::YELLOW),
+    Kumipuyo(PuyoColor::GREEN, PuyoColor::GREEN),
+};
+
+}
+
 struct DecisionSending {
     void clear()
     {
@@ -47,7 +74,9 @@ AI::AI(const string& name) :
     rethinkRequested_(false),
     enemyDecisionRequestFrameId_(0),
     behaviorDefensive_(false),
-    behaviorRethinkAfterOpponentRensa_(false)
+    behaviorRethinkAfterOpponentRensa_(false),
+    behaviorPonder_(false),
+    inRunLoop_(false)
 {
 }
 
@@ -61,11 +90,19 @@ AI::~AI()
 // think(). However, it does, now.
 void AI::runLoop()
 {
+    inRunLoop_ = true;
+
     DecisionSending next1;
 
     // nextThinkFrameId is frameId in which the decision of think() is sent.
     int nextThinkFrameId = 0;
 
+    if (behaviorPonder_ && !ponderer_) {
+        ponderer_.reset(new Ponderer([this](const PonderState& s, const Deadline& deadline) {
+            return thinkWithDeadline(s.frameId, s.field, s.seq, s.me, s.enemy, false, deadline);
+        }));
+    }
+
     while (true) {
         google::FlushLogFiles(google::INFO);
 
@@ -85,11 +122,15 @@ void AI::runLoop()
         }
 
         if (frameRequest.hasGameEnd()) {
+            if (ponderer_)
+                ponderer_->clear();
             gameHasEnded(frameRequest);
         }
         // Before starting a new game, we need to think the first hand.
         // TODO(mayah): Maybe game server should send some information that we should initialize.
         if (frameRequest.shouldInitialize()) {
+            if (ponderer_)
+                ponderer_->clear();
             next1.clear();
             nextThinkFrameId = 0;
             gameWillBegin(frameRequest);
@@ -131,8 +172,16 @@ void AI::runLoop()
             CHECK_EQ(kumipuyoSeq.get(2), seq.get(1));
 
             next1.fieldBeforeThink = me_.field;
-            next1.dropDecision = think(nextThinkFrameId, me_.field, seq,
-                                       myPlayerState(), enemyPlayerState(), false);
+            DropDecision pondered;
+            if (stopPondering(seq, &pondered)) {
+                LOG(INFO) << "use the pondered decision";
+                next1.dropDecision = pondered;
+            } else {
+                next1.dropDecision = thinkWithDeadline(nextThinkFrameId, me_.field, seq,
+                                                       myPlayerState(), enemyPlayerState(), false,
+                                                       makeThinkDeadline(false));
+            }
+            startPondering(nextThinkFrameId, me_.field, seq, next1.dropDecision.decision());
 
             next1.kumipuyo = kumipuyoSeq.get(1);
             next1.ready = true;
@@ -157,13 +206,16 @@ void AI::runLoop()
             VLOG(1) << "REQUEST_AGAIN";
             DCHECK(!frameRequest.myPlayerFrameRequest().event.decisionRequest)
                 << "decisionRequestAgain should not come with decisionRequest.";
-            DropDecision dropDecision = think(frameRequest.frameId,
-                                              frameRequest.myPlayerFrameRequest().field,
-                                              frameRequest.myPlayerFrameRequest().kumipuyoSeq,
-                                              myPlayerState(),
-                                              enemyPlayerState(),
-                                              true);
-            connector_.send(FrameResponse(frameRequest.frameId, dropDecision.decision(), dropDecision.message()));
+            if (ponderer_)
+                ponderer_->stop();
+            DropDecision dropDecision = thinkWithDeadline(frameRequest.frameId,
+                                                          frameRequest.myPlayerFrameRequest().field,
+                                                          frameRequest.myPlayerFrameRequest().kumipuyoSeq,
+                                                          myPlayerState(),
+                                                          enemyPlayerState(),
+                                                          true,
+                                                          makeThinkDeadline(true));
+            sendDropDecision(frameRequest.frameId, dropDecision);
             continue;
         }
 
@@ -193,7 +245,12 @@ void AI::runLoop()
             CHECK_EQ(kumipuyoSeq.get(0), seq.get(0));
             CHECK_EQ(kumipuyoSeq.get(1), seq.get(1));
 
-            next1.dropDecision = think(frameRequest.frameId, me_.field, seq, myPlayerState(), enemyPlayerState(), true);
+            if (ponderer_)
+                ponderer_->stop();
+            next1.dropDecision = thinkWithDeadline(frameRequest.frameId, me_.field, seq,
+                                                   myPlayerState(), enemyPlayerState(), true,
+                                                   makeThinkDeadline(true));
+            startPondering(frameRequest.frameId, me_.field, seq, next1.dropDecision.decision());
             next1.kumipuyo = kumipuyoSeq.get(0);
             next1.ready = true;
             next1.needsRethink = false;
@@ -201,7 +258,7 @@ void AI::runLoop()
         }
 
         // Send
-        connector_.send(FrameResponse(frameRequest.frameId, next1.dropDecision.decision(), next1.dropDecision.message()));
+        sendDropDecision(frameRequest.frameId, next1.dropDecision);
         nextThinkFrameId =
             frameRequest.frameId +
             next1.fieldBeforeThink.framesToDropNext(next1.dropDecision.decision()) +
@@ -217,9 +274,69 @@ void AI::runLoop()
         next1.clear();
     }
 
+    if (ponderer_)
+        ponderer_->clear();
+    inRunLoop_ = false;
     LOG(INFO) << "will exit run loop";
 }
 
+void AI::sendDropDecision(int frameId, const DropDecision& dropDecision)
+{
+    connector_.send(FrameResponse(frameId, dropDecision.decision()));
+
+    string message = dropDecision.message();
+    if (!message.empty())
+        connector_.send(FrameResponse(frameId, Decision(), message));
+}
+
+void AI::startPondering(int frameId, const CoreField& field, const KumipuyoSeq& seq, const Decision& decision)
+{
+    if (!ponderer_ || seq.size() < 2 || !decision.isValid())
+        return;
+
+    CoreField fieldAfterDrop(field);
+    if (!fieldAfterDrop.dropKumipuyo(decision, seq.get(0)))
+        return;
+    fieldAfterDrop.simulate();
+
+    PonderState state;
+    state.frameId = frameId + field.framesToDropNext(decision) + FRAMES_PREPARING_NEXT;
+    state.field = fieldAfterDrop;
+    state.me = me_;
+    state.me.field = fieldAfterDrop;
+    state.enemy = enemy_;
+
+    vector<PonderState> states;
+    if (seq.size() >= 3) {
+        // NEXT2 is known.
+        state.seq = KumipuyoSeq { seq.get(1), seq.get(2) };
+        states.push_back(state);
+    } else {
+        for (const Kumipuyo& kumipuyo : PONDER_CANDIDATES) {
+            state.seq = KumipuyoSeq { seq.get(1), kumipuyo };
+            states.push_back(state);
+        }
+    }
+
+    ponderer_->start(std::move(states), chrono::milliseconds(FLAGS_ponder_budget_ms));
+}
+
+bool AI::stopPondering(const KumipuyoSeq& seq, DropDecision* decision)
+{
+    if (!ponderer_)
+        return false;
+
+    ponderer_->stop();
+    return ponderer_->find(me_.field, seq, me_, enemy_, decision);
+}
+
+DropDecision AI::thinkWithDeadline(int frameId, const CoreField& field, const KumipuyoSeq& kumipuyoSeq,
+                                   const PlayerState& me, const PlayerState& enemy, bool fast,
+                                   const Deadline&) const
+{
+    return think(frameId, field, kumipuyoSeq, me, enemy, fast);
+}
+
 void AI::gaze(int frameId, const CoreField&, const KumipuyoSeq&)
 {
     UNUSED_VARIABLE(frameId);
@@ -429,12 +546,23 @@ void AI::enemyNext2Appeared(const FrameRequest& frameRequest)
 
     // When enemy_.hand == 0, rememberedSequence(0) contains PuyoColor::EMPTY.
     // So, don't gaze at that time.
-    if (enemy_.hand > 0)
+    if (enemy_.hand > 0) {
         gaze(enemyDecisionRequestFrameId_, enemy_.field, rememberedSequence(enemy_.hand));
+        // The pondered decisions were thought with the previous gaze.
+        if (ponderer_)
+            ponderer_->clear();
+    }
 
     onEnemyNext2Appeared(frameRequest);
 }
 
+// static
+Deadline AI::makeThinkDeadline(bool fast)
+{
+    int ms = fast ? FLAGS_fast_think_budget_ms : FLAGS_think_budget_ms;
+    return Deadline::fromNow(chrono::milliseconds(ms));
+}
+
 // static
 bool AI::isFieldInconsistent(const PlainField& f, const PlainField& provided)
 {
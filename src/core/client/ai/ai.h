@@ -1,8 +1,10 @@
 #ifndef CORE_CLIENT_AI_H_
 #define CORE_CLIENT_AI_H_
 
+#include <memory>
 #include <string>
 
+#include "base/deadline.h"
 #include "core/client/ai/drop_decision.h"
 #include "core/client/ai/player_state.h"
 #include "core/client/connector/client_connector.h"
@@ -10,6 +12,7 @@
 
 class CoreField;
 class PlainField;
+class Ponderer;
 struct FrameRequest;
 
 // AI is a utility class of AI.
@@ -38,6 +41,15 @@ protected:
     virtual DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
                                const PlayerState& me, const PlayerState& enemy, bool fast) const = 0;
 
+    // |thinkWithDeadline| is called instead of think() from runLoop().
+    // The decision should be returned by |deadline|, which is --fast_think_budget_ms
+    // after the call if |fast| is true, and --think_budget_ms otherwise.
+    // Override this to use the time budget fully, e.g. with iterative deepening.
+    // By default, this just calls think().
+    virtual DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                           const PlayerState& me, const PlayerState& enemy, bool fast,
+                                           const Deadline&) const;
+
     // gaze will be called when AI should gaze the enemy's field.
     // |frameId| is the frameId where the enemy has started moving his puyo.
     // His moving puyo is the front puyo of the KumipuyoSeq.
@@ -51,6 +63,9 @@ protected:
     void setBehaviorDefensive(bool flag) { behaviorDefensive_ = flag; }
     // Set AI's behavior. If true, you can rethink next decision when the enemy has started his rensa.
     void setBehaviorRethinkAfterOpponentRensa(bool flag) { behaviorRethinkAfterOpponentRensa_ = flag; }
+    // Set AI's behavior. If true, the next hand is thought in advance on a background thread
+    // while AI is idle, for each possible NEXT2. So thinkWithDeadline() must be thread-safe.
+    void setBehaviorPonder(bool flag) { behaviorPonder_ = flag; }
 
     // These callbacks will be called from the corresponding method.
     // i.e. onXXX() will be called from XXX().
@@ -96,6 +111,11 @@ protected:
     const PlayerState& myPlayerState() const { return me_; }
     const PlayerState& enemyPlayerState() const { return enemy_; }
 
+    // Returns true while runLoop() is driving this AI, i.e. the callbacks are called against
+    // the real time. Otherwise, e.g. in Endless or Solver, the callbacks are called one by one,
+    // so the results should not depend on timing.
+    bool isInRunLoop() const { return inRunLoop_; }
+
 protected:
     PlayerState* mutableMyPlayerState() { return &me_; }
     PlayerState* mutableEnemyPlayerState() { return &enemy_; }
@@ -105,11 +125,22 @@ private:
     friend class Endless;
     friend class Solver;
 
+    static Deadline makeThinkDeadline(bool fast);
+
     static bool isFieldInconsistent(const PlainField& ours, const PlainField& provided);
     static void mergeField(CoreField* ours, const PlainField& provided);
 
     KumipuyoSeq rememberedSequence(int indexFrom) const;
 
+    // Sends the decision, and then its message in another response without a decision,
+    // so that making the message doesn't delay the decision.
+    void sendDropDecision(int frameId, const DropDecision&);
+
+    // Starts pondering the next hand, assuming |decision| is taken for the first kumipuyo in |seq|.
+    void startPondering(int frameId, const CoreField& field, const KumipuyoSeq& seq, const Decision& decision);
+    // Stops pondering if pondering. Returns true if |seq| on the current field has been pondered.
+    bool stopPondering(const KumipuyoSeq& seq, DropDecision*);
+
     std::string name_;
     ClientConnector connector_;
 
@@ -121,6 +152,11 @@ private:
 
     bool behaviorDefensive_;
     bool behaviorRethinkAfterOpponentRensa_;
+    bool behaviorPonder_;
+
+    bool inRunLoop_;
+
+    std::unique_ptr<Ponderer> ponderer_;
 };
 
 #endif
@@ -1,12 +1,15 @@
 #ifndef CLIENT_CONNECTION_DROP_DECISION_H_
 #define CLIENT_CONNECTION_DROP_DECISION_H_
 
+#include <functional>
 #include <string>
 
 #include "core/decision.h"
 
 class DropDecision {
 public:
+    typedef std::function<std::string ()> MessageMaker;
+
     explicit DropDecision(const Decision& decision = Decision(),
                           std::string message = std::string()) :
         decision_(decision),
@@ -14,12 +17,30 @@ public:
     {
     }
 
+    // The message is made by |messageMaker| when message() is called first.
+    // This is useful when making a message is costly, since most of decisions
+    // (e.g. the pondered ones) are thrown away without sending their messages.
+    DropDecision(const Decision& decision, MessageMaker messageMaker) :
+        decision_(decision),
+        messageMaker_(std::move(messageMaker))
+    {
+    }
+
     const Decision& decision() const { return decision_; }
-    const std::string message() const { return message_; }
+    // Not thread-safe when the message is made lazily.
+    const std::string message() const
+    {
+        if (messageMaker_) {
+            message_ = messageMaker_();
+            messageMaker_ = nullptr;
+        }
+        return message_;
+    }
 
 private:
     Decision decision_;
-    std::string message_;
+    mutable std::string message_;
+    mutable MessageMaker messageMaker_;
 };
 
 #endif
@@ -0,0 +1,126 @@
+#include "core/client/ai/ponderer.h"
+
+using namespace std;
+
+Ponderer::Ponderer(ThinkCallback callback) :
+    callback_(std::move(callback)),
+    budget_(0),
+    cancelled_(false)
+{
+    th_ = thread([this]() {
+        runLoop();
+    });
+}
+
+Ponderer::~Ponderer()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        shouldStop_ = true;
+        cancelled_ = true;
+    }
+    condVar_.notify_all();
+    th_.join();
+}
+
+void Ponderer::start(vector<PonderState> states, chrono::milliseconds budget)
+{
+    stop();
+
+    {
+        lock_guard<mutex> lock(mu_);
+        results_.clear();
+        queue_.assign(states.begin(), states.end());
+        budget_ = budget;
+        cancelled_ = false;
+    }
+    condVar_.notify_all();
+}
+
+void Ponderer::stop()
+{
+    unique_lock<mutex> lock(mu_);
+    queue_.clear();
+    cancelled_ = true;
+    condVar_.wait(lock, [this]() { return !busy_; });
+}
+
+void Ponderer::clear()
+{
+    stop();
+
+    lock_guard<mutex> lock(mu_);
+    results_.clear();
+}
+
+bool Ponderer::find(const CoreField& field, const KumipuyoSeq& seq, const PlayerState& me, const PlayerState& enemy,
+                    DropDecision* decision) const
+{
+    lock_guard<mutex> lock(mu_);
+    for (const auto& result : results_) {
+        if (matches(result.first, field, seq, me, enemy)) {
+            *decision = result.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int Ponderer::numResults() const
+{
+    lock_guard<mutex> lock(mu_);
+    return static_cast<int>(results_.size());
+}
+
+// static
+bool Ponderer::matches(const PonderState& state, const CoreField& field, const KumipuyoSeq& seq,
+                       const PlayerState& me, const PlayerState& enemy)
+{
+    if (seq.size() < 2 || state.seq.size() < 2)
+        return false;
+    if (state.seq.get(0) != seq.get(0) || state.seq.get(1) != seq.get(1))
+        return false;
+    if (state.field != field)
+        return false;
+    // The enemy field is what think() attacks and defends against.
+    if (state.enemy.field != enemy.field)
+        return false;
+
+    // Ojama and the enemy's rensa change the decision.
+    return state.me.fixedOjama == me.fixedOjama &&
+        state.me.pendingOjama == me.pendingOjama &&
+        state.me.hasZenkeshi == me.hasZenkeshi &&
+        state.enemy.hasZenkeshi == enemy.hasZenkeshi &&
+        state.enemy.isRensaOngoing == enemy.isRensaOngoing;
+}
+
+void Ponderer::runLoop()
+{
+    while (true) {
+        PonderState state;
+        Deadline deadline;
+        {
+            unique_lock<mutex> lock(mu_);
+            condVar_.wait(lock, [this]() { return shouldStop_ || !queue_.empty(); });
+            if (shouldStop_)
+                return;
+
+            state = queue_.front();
+            queue_.pop_front();
+            busy_ = true;
+            deadline = Deadline::fromNow(budget_).withCancelFlag(&cancelled_);
+        }
+
+        DropDecision decision = callback_(state, deadline);
+
+        {
+            lock_guard<mutex> lock(mu_);
+            // A cancelled decision is not reliable.
+            if (!cancelled_)
+                results_.emplace_back(std::move(state), decision);
+            busy_ = false;
+        }
+        condVar_.notify_all();
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef CORE_CLIENT_AI_PONDERER_H_
+#define CORE_CLIENT_AI_PONDERER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/deadline.h"
+#include "base/noncopyable.h"
+#include "core/client/ai/drop_decision.h"
+#include "core/client/ai/player_state.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq.h"
+
+// A speculative state to think in advance.
+struct PonderState {
+    int frameId = 0;
+    CoreField field;
+    KumipuyoSeq seq;
+    PlayerState me;
+    PlayerState enemy;
+};
+
+// Ponderer thinks speculative states on a background thread while the AI is idle,
+// and keeps the decisions. When the real state comes, the AI can use the decision
+// if it has been pondered.
+class Ponderer : noncopyable {
+public:
+    typedef std::function<DropDecision (const PonderState&, const Deadline&)> ThinkCallback;
+
+    // |callback| is called on the background thread.
+    explicit Ponderer(ThinkCallback callback);
+    ~Ponderer();
+
+    // Cancels the current pondering, and starts pondering |states| in order.
+    // Each state is given |budget|. The previous results are removed.
+    void start(std::vector<PonderState> states, std::chrono::milliseconds budget);
+    // Cancels the current pondering, and waits until the callback returns.
+    // The results are kept.
+    void stop();
+    // stop(), and removes all the results.
+    void clear();
+
+    // Returns true if the state has been pondered. The first 2 kumipuyos of |seq| are compared,
+    // and so are both fields.
+    bool find(const CoreField&, const KumipuyoSeq&, const PlayerState& me, const PlayerState& enemy,
+              DropDecision*) const;
+
+    int numResults() const;
+
+private:
+    static bool matches(const PonderState&, const CoreField&, const KumipuyoSeq&,
+                        const PlayerState& me, const PlayerState& enemy);
+
+    void runLoop();
+
+    ThinkCallback callback_;
+
+    mutable std::mutex mu_;
+    std::condition_variable condVar_;
+    std::deque<PonderState> queue_;
+    std::chrono::milliseconds budget_;
+    std::vector<std::pair<PonderState, DropDecision>> results_;
+    bool busy_ = false;
+    bool shouldStop_ = false;
+    std::atomic<bool> cancelled_;
+
+    std::thread th_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "core/client/ai/ponderer.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/core_field.h"
+#include "core/decision.h"
+#include "core/kumipuyo_seq.h"
+
+using namespace std;
+
+namespace {
+
+PonderState makeState(const KumipuyoSeq& seq)
+{
+    PonderState state;
+    state.field = CoreField("  RR  ");
+    state.seq = seq;
+    return state;
+}
+
+void waitForResults(const Ponderer& ponderer, int n)
+{
+    while (ponderer.numResults() < n)
+        this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+}
+
+TEST(PondererTest, find)
+{
+    Ponderer ponderer([](const PonderState& state, const Deadline&) {
+        return DropDecision(Decision(state.seq.get(1) == Kumipuyo(PuyoColor::RED, PuyoColor::BLUE) ? 1 : 6, 0));
+    });
+
+    ponderer.start(vector<PonderState> { makeState(KumipuyoSeq("YYRB")), makeState(KumipuyoSeq("YYGG")) },
+                   chrono::milliseconds(100));
+    waitForResults(ponderer, 2);
+
+    CoreField field("  RR  ");
+    PlayerState me, enemy;
+    DropDecision decision;
+    EXPECT_TRUE(ponderer.find(field, KumipuyoSeq("YYRB"), me, enemy, &decision));
+    EXPECT_EQ(Decision(1, 0), decision.decision());
+    EXPECT_TRUE(ponderer.find(field, KumipuyoSeq("YYGG"), me, enemy, &decision));
+    EXPECT_EQ(Decision(6, 0), decision.decision());
+
+    // Not pondered.
+    EXPECT_FALSE(ponderer.find(field, KumipuyoSeq("YYBB"), me, enemy, &decision));
+    EXPECT_FALSE(ponderer.find(CoreField(), KumipuyoSeq("YYRB"), me, enemy, &decision));
+    me.fixedOjama = 6;
+    EXPECT_FALSE(ponderer.find(field, KumipuyoSeq("YYRB"), me, enemy, &decision));
+
+    ponderer.clear();
+    EXPECT_EQ(0, ponderer.numResults());
+}
+
+TEST(PondererTest, findWithDifferentEnemyField)
+{
+    Ponderer ponderer([](const PonderState&, const Deadline&) {
+        return DropDecision(Decision(1, 0));
+    });
+
+    ponderer.start(vector<PonderState> { makeState(KumipuyoSeq("YYRB")) }, chrono::milliseconds(100));
+    waitForResults(ponderer, 1);
+
+    CoreField field("  RR  ");
+    PlayerState me, enemy;
+    DropDecision decision;
+    EXPECT_TRUE(ponderer.find(field, KumipuyoSeq("YYRB"), me, enemy, &decision));
+
+    // The enemy has put a kumipuyo after pondering.
+    enemy.field = CoreField("  GG  ");
+    EXPECT_FALSE(ponderer.find(field, KumipuyoSeq("YYRB"), me, enemy, &decision));
+}
+
+TEST(PondererTest, stop)
+{
+    Ponderer ponderer([](const PonderState&, const Deadline& deadline) {
+        while (!deadline.hasPassed())
+            this_thread::sleep_for(chrono::milliseconds(1));
+        return DropDecision(Decision(3, 0));
+    });
+
+    auto begin = chrono::steady_clock::now();
+    ponderer.start(vector<PonderState> { makeState(KumipuyoSeq("YYRB")) }, chrono::milliseconds(10000));
+    this_thread::sleep_for(chrono::milliseconds(10));
+    ponderer.stop();
+
+    EXPECT_GT(chrono::seconds(5), chrono::steady_clock::now() - begin);
+    // A cancelled result is not kept.
+    EXPECT_EQ(0, ponderer.numResults());
+}
+
+TEST(PondererTest, budget)
+{
+    Ponderer ponderer([](const PonderState&, const Deadline& deadline) {
+        while (!deadline.hasPassed())
+            this_thread::sleep_for(chrono::milliseconds(1));
+        return DropDecision(Decision(3, 0));
+    });
+
+    ponderer.start(vector<PonderState> { makeState(KumipuyoSeq("YYRB")), makeState(KumipuyoSeq("YYGG")) },
+                   chrono::milliseconds(5));
+    waitForResults(ponderer, 2);
+    EXPECT_EQ(2, ponderer.numResults());
+}
@@ -1,38 +1,96 @@
 #include "core/client/connector/client_connector.h"
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
+#include "core/binary_frame.h"
 #include "core/frame_request.h"
 #include "core/frame_response.h"
+#include "core/shared_memory_channel.h"
 
 using namespace std;
 
+DEFINE_bool(accept_binary_protocol, true, "accept the binary protocol when the server offers it");
+
+ClientConnector::ClientConnector()
+{
+    const char* env = getenv(SharedMemoryChannel::ENV_NAME);
+    if (!env)
+        return;
+
+    SharedMemoryChannel::Handles handles;
+    CHECK(SharedMemoryChannel::Handles::parse(env, &handles)) << "broken " << SharedMemoryChannel::ENV_NAME << ": " << env;
+    // The server never writes to stdin, so it's read only to notice the server's death.
+    channel_.reset(new SharedMemoryChannel(handles, SharedMemoryChannel::Side::CLIENT, STDIN_FILENO));
+
+    // Don't pass the handles to our child processes (e.g. kantoku).
+    unsetenv(SharedMemoryChannel::ENV_NAME);
+}
+
+ClientConnector::~ClientConnector()
+{
+}
+
 bool ClientConnector::receive(FrameRequest* frameRequest)
 {
     if (closed_)
         return false;
 
-    std::string line;
+    if (channel_) {
+        if (!channel_->receive(&buffer_)) {
+            closed_ = true;
+            return false;
+        }
+        *frameRequest = FrameRequest::parseBinary(buffer_.data(), buffer_.size(), &lastBinaryRequest_);
+        lastBinaryRequest_ = *frameRequest;
+        return true;
+    }
+
+    bool binary;
     while (true) {
-        if (!std::getline(std::cin, line)) {
+        if (!binary_frame::read(stdin, &buffer_, &binary)) {
             closed_ = true;
             return false;
         }
 
-        if (line != "")
+        if (binary || buffer_ != "")
             break;
     }
 
-    LOG(INFO) << line;
-    *frameRequest = FrameRequest::parse(line);
+    if (binary) {
+        *frameRequest = FrameRequest::parseBinary(buffer_.data(), buffer_.size(), &lastBinaryRequest_);
+        lastBinaryRequest_ = *frameRequest;
+        return true;
+    }
+
+    LOG(INFO) << buffer_;
+    if (!binary_ && FLAGS_accept_binary_protocol && buffer_.find(binary_frame::OFFER_TERM) != string::npos)
+        binary_ = true;
+    *frameRequest = FrameRequest::parse(buffer_);
     return true;
 }
 
 void ClientConnector::send(const FrameResponse& resp)
 {
+    if (channel_) {
+        string s = resp.toBinary();
+        channel_->send(s.data(), s.size());
+        return;
+    }
+
+    if (binary_) {
+        string s = resp.toBinary();
+        binary_frame::write(stdout, s.data(), s.size());
+        return;
+    }
+
     string s = resp.toString();
     cout << s << endl;
     LOG(INFO) << s;
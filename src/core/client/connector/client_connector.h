@@ -1,11 +1,23 @@
 #ifndef CLIENT_CONNECTION_CLIENT_CONNECTOR_H_
 #define CLIENT_CONNECTION_CLIENT_CONNECTOR_H_
 
-struct FrameRequest;
+#include <memory>
+#include <string>
+
+#include "core/frame_request.h"
+
+class SharedMemoryChannel;
+
 struct FrameResponse;
 
+// ClientConnector talks to the server via stdin and stdout. When the server has
+// passed a shared memory (see SharedMemoryConnector), messages are passed via
+// SharedMemoryChannel, and stdin and stdout are not used.
 class ClientConnector {
 public:
+    ClientConnector();
+    ~ClientConnector();
+
     // Returns true if receive suceeded.
     bool receive(FrameRequest* request);
     void send(const FrameResponse&);
@@ -14,6 +26,12 @@ public:
 
 private:
     bool closed_ = false;
+    // True after the binary protocol has been accepted. See core/binary_frame.h.
+    bool binary_ = false;
+    std::string buffer_;
+    // The base of the delta format.
+    FrameRequest lastBinaryRequest_;
+    std::unique_ptr<SharedMemoryChannel> channel_;
 };
 
 #endif
@@ -2,10 +2,12 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <sstream>
 
+#include "core/binary_frame.h"
 #include "core/field_pretty_printer.h"
 #include "core/kumipuyo.h"
 #include "core/plain_field.h"
@@ -102,6 +104,120 @@ static GameResult parseEnd(const char* value)
     return GameResult::PLAYING;
 }
 
+static int formatEventBits(const UserEvent& event)
+{
+    return (event.wnextAppeared        ? 1 << 0 : 0) |
+           (event.grounded             ? 1 << 1 : 0) |
+           (event.decisionRequest      ? 1 << 2 : 0) |
+           (event.decisionRequestAgain ? 1 << 3 : 0) |
+           (event.chainFinished        ? 1 << 4 : 0) |
+           (event.ojamaDropped         ? 1 << 5 : 0) |
+           (event.puyoErased           ? 1 << 6 : 0);
+}
+
+static UserEvent parseEventBits(int bits)
+{
+    UserEvent event;
+    event.wnextAppeared        = bits & (1 << 0);
+    event.grounded             = bits & (1 << 1);
+    event.decisionRequest      = bits & (1 << 2);
+    event.decisionRequestAgain = bits & (1 << 3);
+    event.chainFinished        = bits & (1 << 4);
+    event.ojamaDropped         = bits & (1 << 5);
+    event.puyoErased           = bits & (1 << 6);
+    return event;
+}
+
+// Same as END= in the text format. Other results are sent as a draw.
+static int formatEnd(GameResult gameResult)
+{
+    switch (gameResult) {
+    case GameResult::PLAYING:
+        return 2;
+    case GameResult::P1_WIN:
+        return 1;
+    case GameResult::P2_WIN:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+// The first byte of the binary format.
+const char BINARY_KIND_FULL = 'F';
+const char BINARY_KIND_DELTA = 'D';
+
+// In the delta format, each player has these bits to show which items are included.
+enum DeltaBit {
+    DELTA_FIELD = 1 << 0,
+    DELTA_KUMIPUYO_SEQ = 1 << 1,
+    DELTA_EVENT = 1 << 2,
+    DELTA_KUMIPUYO_POS = 1 << 3,
+    DELTA_OJAMA = 1 << 4,
+    DELTA_SCORE = 1 << 5,
+};
+
+// When more cells than this have changed, the full format is used instead.
+// This keeps the delta format smaller than the full format.
+const int MAX_DELTA_CELLS = 32;
+
+static int cellIndex(int x, int y) { return (y - 1) * 6 + (x - 1); }
+
+static char* putKumipuyoSeq(char* p, const KumipuyoSeq& seq)
+{
+    int numKumipuyos = std::min(seq.size(), 3);
+    p = binary_frame::putInt8(p, numKumipuyos);
+    for (int i = 0; i < 3; ++i) {
+        Kumipuyo kp = i < numKumipuyos ? seq.get(i) : Kumipuyo();
+        p = binary_frame::putInt8(p, ordinal(kp.axis));
+        p = binary_frame::putInt8(p, ordinal(kp.child));
+    }
+    return p;
+}
+
+static const char* getKumipuyoSeq(const char* p, KumipuyoSeq* seq)
+{
+    int numKumipuyos;
+    p = binary_frame::getInt8(p, &numKumipuyos);
+    seq->clear();
+    for (int i = 0; i < 3; ++i) {
+        int axis, child;
+        p = binary_frame::getInt8(p, &axis);
+        p = binary_frame::getInt8(p, &child);
+        if (i < numKumipuyos)
+            seq->add(Kumipuyo(static_cast<PuyoColor>(axis), static_cast<PuyoColor>(child)));
+    }
+    return p;
+}
+
+static char* putKumipuyoPos(char* p, const KumipuyoPos& pos)
+{
+    p = binary_frame::putInt8(p, pos.axisX());
+    p = binary_frame::putInt8(p, pos.axisY());
+    return binary_frame::putInt8(p, pos.r);
+}
+
+static const char* getKumipuyoPos(const char* p, KumipuyoPos* pos)
+{
+    p = binary_frame::getInt8(p, &pos->x);
+    p = binary_frame::getInt8(p, &pos->y);
+    return binary_frame::getInt8(p, &pos->r);
+}
+
+static int countChangedCells(const PlainField& lhs, const PlainField& rhs)
+{
+    int count = 0;
+    for (int y = 1; y <= 12; ++y) {
+        for (int x = 1; x <= 6; ++x) {
+            if (lhs.get(x, y) != rhs.get(x, y))
+                ++count;
+        }
+    }
+    return count;
+}
+
+const size_t FrameRequest::BINARY_SIZE;
+
 // static
 FrameRequest FrameRequest::parse(const std::string& line)
 {
@@ -156,6 +272,123 @@ FrameRequest FrameRequest::parse(const std::string& line)
     return req;
 }
 
+// static
+FrameRequest FrameRequest::parseBinary(const char* data, size_t size, const FrameRequest* base)
+{
+    if (size > 0 && data[0] == BINARY_KIND_FULL && size == BINARY_SIZE)
+        return parseBinaryFull(data + 1);
+    if (size > 0 && data[0] == BINARY_KIND_DELTA && base && base->isValid())
+        return parseBinaryDelta(data + 1, size - 1, *base);
+
+    LOG(WARNING) << "Unexpected binary FrameRequest: size=" << size;
+    return FrameRequest();
+}
+
+// static
+FrameRequest FrameRequest::parseBinaryFull(const char* p)
+{
+    FrameRequest req;
+
+    int end;
+    p = binary_frame::getInt32(p, &req.frameId);
+    p = binary_frame::getInt8(p, &end);
+    req.gameResult = fromRequestEnd(end);
+
+    for (int pi = 0; pi < NUM_PLAYERS; ++pi) {
+        PlayerFrameRequest& pReq = req.playerFrameRequest[pi];
+
+        PlainField field;
+        for (int y = 1; y <= 12; ++y) {
+            for (int x = 1; x <= 6; ++x) {
+                int c;
+                p = binary_frame::getInt8(p, &c);
+                field.unsafeSet(x, y, static_cast<PuyoColor>(c));
+            }
+        }
+        pReq.field = CoreField(field);
+
+        int eventBits;
+        p = getKumipuyoSeq(p, &pReq.kumipuyoSeq);
+        p = binary_frame::getInt8(p, &eventBits);
+        pReq.event = parseEventBits(eventBits);
+        p = getKumipuyoPos(p, &pReq.kumipuyoPos);
+        p = binary_frame::getInt32(p, &pReq.ojama);
+        p = binary_frame::getInt32(p, &pReq.score);
+    }
+
+    return req;
+}
+
+// static
+FrameRequest FrameRequest::parseBinaryDelta(const char* p, size_t size, const FrameRequest& base)
+{
+    const char* end = p + size;
+    FrameRequest req = base;
+
+    if (end - p < 5)
+        return FrameRequest();
+
+    int gameEnd;
+    p = binary_frame::getInt32(p, &req.frameId);
+    p = binary_frame::getInt8(p, &gameEnd);
+    req.gameResult = fromRequestEnd(gameEnd);
+
+    for (int pi = 0; pi < NUM_PLAYERS; ++pi) {
+        PlayerFrameRequest& pReq = req.playerFrameRequest[pi];
+
+        int bits;
+        if (end - p < 1)
+            return FrameRequest();
+        p = binary_frame::getInt8(p, &bits);
+
+        int expectedSize = ((bits & DELTA_KUMIPUYO_SEQ) ? 7 : 0) + ((bits & DELTA_EVENT) ? 1 : 0) +
+            ((bits & DELTA_KUMIPUYO_POS) ? 3 : 0) + ((bits & DELTA_OJAMA) ? 4 : 0) + ((bits & DELTA_SCORE) ? 4 : 0);
+
+        if (bits & DELTA_FIELD) {
+            int numCells;
+            if (end - p < 1)
+                return FrameRequest();
+            p = binary_frame::getInt8(p, &numCells);
+            if (numCells < 0 || end - p < numCells * 2)
+                return FrameRequest();
+            for (int i = 0; i < numCells; ++i) {
+                int index, c;
+                p = binary_frame::getInt8(p, &index);
+                p = binary_frame::getInt8(p, &c);
+                if (index < 0 || 6 * 12 <= index)
+                    return FrameRequest();
+                pReq.field.unsafeSet(index % 6 + 1, index / 6 + 1, static_cast<PuyoColor>(c));
+            }
+            for (int x = 1; x <= 6; ++x)
+                pReq.field.recalcHeightOn(x);
+        }
+
+        if (end - p < expectedSize)
+            return FrameRequest();
+
+        if (bits & DELTA_KUMIPUYO_SEQ)
+            p = getKumipuyoSeq(p, &pReq.kumipuyoSeq);
+        if (bits & DELTA_EVENT) {
+            int eventBits;
+            p = binary_frame::getInt8(p, &eventBits);
+            pReq.event = parseEventBits(eventBits);
+        } else {
+            pReq.event = UserEvent();
+        }
+        if (bits & DELTA_KUMIPUYO_POS)
+            p = getKumipuyoPos(p, &pReq.kumipuyoPos);
+        if (bits & DELTA_OJAMA)
+            p = binary_frame::getInt32(p, &pReq.ojama);
+        if (bits & DELTA_SCORE)
+            p = binary_frame::getInt32(p, &pReq.score);
+    }
+
+    if (p != end)
+        return FrameRequest();
+
+    return req;
+}
+
 string FrameRequest::toDebugString() const
 {
     stringstream ss;
@@ -221,3 +454,83 @@ string FrameRequest::toString() const
        << win;
     return ss.str();
 }
+
+// Layout of the full format (all integers are little endian):
+//   'F' (1) | frameId (4) | END (1, 2 if playing)
+//   and for each player (me, then enemy):
+//     field (6x12, 1 byte per puyo, y = 1..12, x = 1..6)
+//     the number of kumipuyos (1) | kumipuyos (3 pairs of axis and child, 1 byte each)
+//     event bits (1) | kumipuyo x, y and r (1 each) | ojama (4) | score (4)
+//
+// Layout of the delta format:
+//   'D' (1) | frameId (4) | END (1, 2 if playing)
+//   and for each player (me, then enemy):
+//     DeltaBit (1)
+//     and the items whose bit is set, in the same layout as the full format, except
+//     the field is the number of changed cells (1) | (cell index (1) | puyo (1)) * n.
+//   Events are not carried over from |base|; an event is cleared when DELTA_EVENT is not set.
+size_t FrameRequest::toBinary(char* buf, const FrameRequest* base) const
+{
+    bool delta = base && base->isValid();
+    for (int pi = 0; delta && pi < NUM_PLAYERS; ++pi) {
+        if (countChangedCells(playerFrameRequest[pi].field, base->playerFrameRequest[pi].field) > MAX_DELTA_CELLS)
+            delta = false;
+    }
+
+    char* p = buf;
+    p = binary_frame::putInt8(p, delta ? BINARY_KIND_DELTA : BINARY_KIND_FULL);
+    p = binary_frame::putInt32(p, frameId);
+    p = binary_frame::putInt8(p, formatEnd(gameResult));
+
+    for (int pi = 0; pi < NUM_PLAYERS; ++pi) {
+        const PlayerFrameRequest& pReq = playerFrameRequest[pi];
+        if (!delta) {
+            for (int y = 1; y <= 12; ++y) {
+                for (int x = 1; x <= 6; ++x)
+                    p = binary_frame::putInt8(p, ordinal(pReq.field.get(x, y)));
+            }
+            p = putKumipuyoSeq(p, pReq.kumipuyoSeq);
+            p = binary_frame::putInt8(p, formatEventBits(pReq.event));
+            p = putKumipuyoPos(p, pReq.kumipuyoPos);
+            p = binary_frame::putInt32(p, pReq.ojama);
+            p = binary_frame::putInt32(p, pReq.score);
+            continue;
+        }
+
+        const PlayerFrameRequest& baseReq = base->playerFrameRequest[pi];
+        int numCells = countChangedCells(pReq.field, baseReq.field);
+        int bits = (numCells > 0 ? DELTA_FIELD : 0) |
+            (pReq.kumipuyoSeq != baseReq.kumipuyoSeq ? DELTA_KUMIPUYO_SEQ : 0) |
+            (pReq.event.hasEventState() ? DELTA_EVENT : 0) |
+            (pReq.kumipuyoPos != baseReq.kumipuyoPos ? DELTA_KUMIPUYO_POS : 0) |
+            (pReq.ojama != baseReq.ojama ? DELTA_OJAMA : 0) |
+            (pReq.score != baseReq.score ? DELTA_SCORE : 0);
+
+        p = binary_frame::putInt8(p, bits);
+        if (bits & DELTA_FIELD) {
+            p = binary_frame::putInt8(p, numCells);
+            for (int y = 1; y <= 12; ++y) {
+                for (int x = 1; x <= 6; ++x) {
+                    if (pReq.field.get(x, y) == baseReq.field.get(x, y))
+                        continue;
+                    p = binary_frame::putInt8(p, cellIndex(x, y));
+                    p = binary_frame::putInt8(p, ordinal(pReq.field.get(x, y)));
+                }
+            }
+        }
+        if (bits & DELTA_KUMIPUYO_SEQ)
+            p = putKumipuyoSeq(p, pReq.kumipuyoSeq);
+        if (bits & DELTA_EVENT)
+            p = binary_frame::putInt8(p, formatEventBits(pReq.event));
+        if (bits & DELTA_KUMIPUYO_POS)
+            p = putKumipuyoPos(p, pReq.kumipuyoPos);
+        if (bits & DELTA_OJAMA)
+            p = binary_frame::putInt32(p, pReq.ojama);
+        if (bits & DELTA_SCORE)
+            p = binary_frame::putInt32(p, pReq.score);
+    }
+
+    size_t size = p - buf;
+    DCHECK(delta ? size <= BINARY_SIZE : size == BINARY_SIZE) << size;
+    return size;
+}
@@ -1,6 +1,7 @@
 #ifndef CORE_FRAME_REQUEST_H_
 #define CORE_FRAME_REQUEST_H_
 
+#include <cstddef>
 #include <string>
 
 #include "core/core_field.h"
@@ -21,8 +22,16 @@ struct PlayerFrameRequest {
 
 struct FrameRequest {
     static FrameRequest parse(const std::string& line);
+    // Parses the binary format. |base| is the previous FrameRequest parsed from the same
+    // stream, and it's necessary to parse the delta format.
+    // When |data| is broken, an invalid FrameRequest will be returned.
+    static FrameRequest parseBinary(const char* data, size_t size, const FrameRequest* base = nullptr);
 
     std::string toString() const;
+    // Writes the binary format to |buf|, and returns its size. |buf| should have BINARY_SIZE bytes.
+    // When |base| is given, only the difference from |base| might be written (the delta format).
+    // See frame_request.cc for the layout.
+    size_t toBinary(char* buf, const FrameRequest* base = nullptr) const;
     std::string toDebugString() const;
 
     bool isValid() const { return frameId != -1; }
@@ -32,9 +41,16 @@ struct FrameRequest {
     const PlayerFrameRequest& myPlayerFrameRequest() const { return playerFrameRequest[0]; }
     const PlayerFrameRequest& enemyPlayerFrameRequest() const { return playerFrameRequest[1]; }
 
+    // The size of the full binary format. The delta format is not larger than this.
+    static const size_t BINARY_SIZE = 1 + 4 + 1 + NUM_PLAYERS * (6 * 12 + 1 + 3 * 2 + 1 + 3 + 4 + 4);
+
     int frameId = -1;
     GameResult gameResult = GameResult::PLAYING;
     PlayerFrameRequest playerFrameRequest[NUM_PLAYERS];
+
+private:
+    static FrameRequest parseBinaryFull(const char* data);
+    static FrameRequest parseBinaryDelta(const char* data, size_t size, const FrameRequest& base);
 };
 
 #endif
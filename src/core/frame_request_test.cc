@@ -14,3 +14,65 @@ TEST(FrameRequestTest, parse)
     EXPECT_TRUE(request.isValid());
     EXPECT_FALSE(request.hasGameEnd());
 }
+
+TEST(FrameRequestTest, toBinaryAndParseBinary)
+{
+    FrameRequest expected = FrameRequest::parse(
+        "ID=10 YF=000000000000000000000000000000000000000000000000000000000000000444455556 "
+        "OF=000000000000000000000000000000000000000000000000000000000000000000000017 "
+        "YP=445566 OP=4567 YE=W-D---E OE=-G---O- YX=3 YY=12 YR=1 OX=4 OY=11 OR=2 "
+        "YO=3 OO=42 YS=1200 OS=70 END=-1");
+
+    char buf[FrameRequest::BINARY_SIZE];
+    size_t size = expected.toBinary(buf);
+    EXPECT_EQ(FrameRequest::BINARY_SIZE, size);
+    FrameRequest actual = FrameRequest::parseBinary(buf, size);
+
+    EXPECT_EQ(expected.toString(), actual.toString());
+    EXPECT_EQ(GameResult::P2_WIN, actual.gameResult);
+    EXPECT_EQ(2, actual.enemyPlayerFrameRequest().kumipuyoSeq.size());
+}
+
+TEST(FrameRequestTest, parseBinaryWithWrongSize)
+{
+    char buf[FrameRequest::BINARY_SIZE];
+    size_t size = FrameRequest().toBinary(buf);
+
+    EXPECT_FALSE(FrameRequest::parseBinary(buf, size - 1).isValid());
+}
+
+TEST(FrameRequestTest, toBinaryDelta)
+{
+    FrameRequest base = FrameRequest::parse(
+        "ID=10 YF=000000000000000000000000000000000000000000000000000000000000000444455556 "
+        "OF=000000000000000000000000000000000000000000000000000000000000000000000017 "
+        "YP=445566 OP=4567 YE=W-D---E OE=-G---O- YX=3 YY=12 YR=1 OX=4 OY=11 OR=2 "
+        "YO=3 OO=42 YS=1200 OS=70");
+
+    char buf[FrameRequest::BINARY_SIZE];
+
+    // Only frameId has changed.
+    FrameRequest req = FrameRequest::parse(
+        "ID=11 YF=000000000000000000000000000000000000000000000000000000000000000444455556 "
+        "OF=000000000000000000000000000000000000000000000000000000000000000000000017 "
+        "YP=445566 OP=4567 YE=------- OE=------- YX=3 YY=12 YR=1 OX=4 OY=11 OR=2 "
+        "YO=3 OO=42 YS=1200 OS=70");
+    size_t size = req.toBinary(buf, &base);
+    EXPECT_EQ(8U, size);
+    EXPECT_EQ(req.toString(), FrameRequest::parseBinary(buf, size, &base).toString());
+
+    // Some cells, NEXT, events and score have changed.
+    req = FrameRequest::parse(
+        "ID=12 YF=000000000000000000000000000000000000000000000000000000000000450444455556 "
+        "OF=000000000000000000000000000000000000000000000000000000000000000000000017 "
+        "YP=556677 OP=4567 YE=-G----- OE=------- YX=3 YY=12 YR=1 OX=4 OY=11 OR=2 "
+        "YO=3 OO=42 YS=1240 OS=70 END=1");
+    size = req.toBinary(buf, &base);
+    EXPECT_GT(FrameRequest::BINARY_SIZE, size);
+    FrameRequest actual = FrameRequest::parseBinary(buf, size, &base);
+    EXPECT_EQ(req.toString(), actual.toString());
+    EXPECT_EQ(2, actual.myPlayerFrameRequest().field.height(2));
+
+    // Delta format cannot be parsed without base.
+    EXPECT_FALSE(FrameRequest::parseBinary(buf, size).isValid());
+}
@@ -1,8 +1,11 @@
 #include "core/frame_response.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <sstream>
 
+#include "core/binary_frame.h"
+
 using namespace std;
 
 static string unescapeMessage(string str)
@@ -53,6 +56,36 @@ FrameResponse FrameResponse::parse(const string& str)
     return data;
 }
 
+// static
+FrameResponse FrameResponse::parseBinary(const char* data, size_t size)
+{
+    FrameResponse response;
+
+    const char* p = data;
+    const char* end = data + size;
+    if (end - p < 10)
+        return response;
+
+    int frameId, msgSize, mawashiAreaSize;
+    p = binary_frame::getInt32(p, &frameId);
+    p = binary_frame::getInt8(p, &response.decision.x);
+    p = binary_frame::getInt8(p, &response.decision.r);
+
+    p = binary_frame::getInt32(p, &msgSize);
+    if (msgSize < 0 || end - p < msgSize + 4)
+        return FrameResponse();
+    response.msg.assign(p, msgSize);
+    p += msgSize;
+
+    p = binary_frame::getInt32(p, &mawashiAreaSize);
+    if (mawashiAreaSize < 0 || end - p < mawashiAreaSize)
+        return FrameResponse();
+    response.mawashiArea.assign(p, mawashiAreaSize);
+
+    response.frameId = frameId;
+    return response;
+}
+
 bool FrameResponse::isValid() const
 {
     return decision.isValid();
@@ -72,3 +105,23 @@ std::string FrameResponse::toString() const
 
     return ss.str();
 }
+
+// Layout (all integers are little endian):
+//   frameId (4) | decision x (1) | decision r (1)
+//   | message size (4) | message | mawashi area size (4) | mawashi area
+// Unlike the text format, the message is not escaped.
+std::string FrameResponse::toBinary() const
+{
+    std::string s(4 + 1 + 1 + 4 + msg.size() + 4 + mawashiArea.size(), '\0');
+
+    char* p = &s[0];
+    p = binary_frame::putInt32(p, frameId);
+    p = binary_frame::putInt8(p, decision.x);
+    p = binary_frame::putInt8(p, decision.r);
+    p = binary_frame::putInt32(p, msg.size());
+    p = std::copy(msg.begin(), msg.end(), p);
+    p = binary_frame::putInt32(p, mawashiArea.size());
+    std::copy(mawashiArea.begin(), mawashiArea.end(), p);
+
+    return s;
+}
@@ -1,6 +1,7 @@
 #ifndef CORE_FRAME_RESPONSE_H_
 #define CORE_FRAME_RESPONSE_H_
 
+#include <cstddef>
 #include <string>
 
 #include "core/decision.h"
@@ -8,6 +9,9 @@
 
 struct FrameResponse {
     static FrameResponse parse(const std::string&);
+    // Parses the binary format. When |data| is broken, an invalid FrameResponse
+    // will be returned.
+    static FrameResponse parseBinary(const char* data, size_t size);
 
     FrameResponse() {}
     explicit FrameResponse(int frameId,
@@ -17,6 +21,8 @@ struct FrameResponse {
 
     bool isValid() const;
     std::string toString() const;
+    // Returns the binary format. See frame_response.cc for the layout.
+    std::string toBinary() const;
 
     int frameId = -1;
     Decision decision;
@@ -33,3 +33,24 @@ TEST(FrameResponseTest, toStringAndParse)
     EXPECT_EQ(expected.decision, actual.decision);
     EXPECT_EQ(expected.msg, actual.msg);
 }
+
+TEST(FrameResponseTest, toBinaryAndParseBinary)
+{
+    FrameResponse expected;
+    expected.frameId = 100;
+    expected.decision = Decision(3, 0);
+    expected.msg = "message with space";
+    expected.mawashiArea = "123";
+
+    string binary = expected.toBinary();
+    FrameResponse actual = FrameResponse::parseBinary(binary.data(), binary.size());
+
+    EXPECT_TRUE(actual.isValid());
+    EXPECT_EQ(expected.frameId, actual.frameId);
+    EXPECT_EQ(expected.decision, actual.decision);
+    EXPECT_EQ(expected.msg, actual.msg);
+    EXPECT_EQ(expected.mawashiArea, actual.mawashiArea);
+
+    FrameResponse broken = FrameResponse::parseBinary(binary.data(), binary.size() - 1);
+    EXPECT_EQ(-1, broken.frameId);
+}
@@ -0,0 +1,133 @@
+#include "core/server/async_game_state_observer.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include "core/server/game_state.h"
+
+using namespace std;
+
+AsyncGameStateObserver::AsyncGameStateObserver(GameStateObserver* observer, Delivery delivery,
+                                               size_t maxQueuedEvents) :
+    observer_(observer),
+    delivery_(delivery),
+    maxQueuedEvents_(maxQueuedEvents)
+{
+    CHECK(observer_) << "observer should not be nullptr.";
+    CHECK_GT(maxQueuedEvents_, 0U);
+}
+
+AsyncGameStateObserver::~AsyncGameStateObserver()
+{
+    stop();
+}
+
+bool AsyncGameStateObserver::start()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        shouldStop_ = false;
+    }
+    th_ = thread([this]() {
+        this->runLoop();
+    });
+    return true;
+}
+
+void AsyncGameStateObserver::stop()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        shouldStop_ = true;
+    }
+    notEmpty_.notify_all();
+
+    if (th_.joinable())
+        th_.join();
+}
+
+void AsyncGameStateObserver::newGameWillStart()
+{
+    push(Event { Event::Type::NEW_GAME, nullptr, GameResult::PLAYING });
+}
+
+void AsyncGameStateObserver::onUpdate(const GameState& gameState)
+{
+    // The snapshot is made out of the lock.
+    shared_ptr<const GameState> snapshot = make_shared<const GameState>(gameState);
+    push(Event { Event::Type::UPDATE, move(snapshot), GameResult::PLAYING });
+}
+
+void AsyncGameStateObserver::gameHasDone(GameResult gameResult)
+{
+    push(Event { Event::Type::GAME_DONE, nullptr, gameResult });
+}
+
+int AsyncGameStateObserver::numDroppedUpdates() const
+{
+    lock_guard<mutex> lock(mu_);
+    return numDroppedUpdates_;
+}
+
+void AsyncGameStateObserver::push(Event event)
+{
+    unique_lock<mutex> lock(mu_);
+
+    if (delivery_ == Delivery::LATEST_ONLY && event.type == Event::Type::UPDATE) {
+        // The update not delivered yet is no longer needed.
+        if (!queue_.empty() && queue_.back().type == Event::Type::UPDATE) {
+            queue_.back().gameState = move(event.gameState);
+            ++numDroppedUpdates_;
+            return;
+        }
+
+        // The queue is full of the other events. Drop the oldest update instead of waiting.
+        // When there is no update in the queue, drop the new one.
+        if (queue_.size() >= maxQueuedEvents_) {
+            auto it = find_if(queue_.begin(), queue_.end(), [](const Event& e) {
+                return e.type == Event::Type::UPDATE;
+            });
+            ++numDroppedUpdates_;
+            if (it == queue_.end())
+                return;
+            queue_.erase(it);
+        }
+    }
+
+    notFull_.wait(lock, [this]() { return queue_.size() < maxQueuedEvents_; });
+    queue_.push_back(move(event));
+    lock.unlock();
+
+    notEmpty_.notify_one();
+}
+
+void AsyncGameStateObserver::runLoop()
+{
+    while (true) {
+        Event event;
+        {
+            unique_lock<mutex> lock(mu_);
+            notEmpty_.wait(lock, [this]() { return shouldStop_ || !queue_.empty(); });
+            // The remaining events are delivered before stopping.
+            if (queue_.empty())
+                return;
+
+            event = move(queue_.front());
+            queue_.pop_front();
+        }
+        notFull_.notify_all();
+
+        switch (event.type) {
+        case Event::Type::NEW_GAME:
+            observer_->newGameWillStart();
+            break;
+        case Event::Type::UPDATE:
+            observer_->onUpdate(*event.gameState);
+            break;
+        case Event::Type::GAME_DONE:
+            observer_->gameHasDone(event.gameResult);
+            break;
+        }
+    }
+}
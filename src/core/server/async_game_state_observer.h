@@ -0,0 +1,76 @@
+#ifndef CORE_SERVER_ASYNC_GAME_STATE_OBSERVER_H_
+#define CORE_SERVER_ASYNC_GAME_STATE_OBSERVER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "base/noncopyable.h"
+#include "core/game_result.h"
+#include "core/server/game_state_observer.h"
+
+// AsyncGameStateObserver notifies |observer| on its own thread, so that a slow observer
+// doesn't stall the game loop. Each GameState is copied once into an immutable snapshot,
+// which is shared by reference count until it's delivered.
+//
+// newGameWillStart() and gameHasDone() are always delivered in order with the updates.
+// How the updates are delivered depends on the Delivery:
+//   LATEST_ONLY: When the observer cannot keep up, the updates not delivered yet are
+//                replaced with the latest one. onUpdate() never waits. For renderers.
+//   LOSSLESS:    All the updates are delivered. onUpdate() waits while the queue is full.
+//                For recorders.
+class AsyncGameStateObserver : public GameStateObserver, noncopyable {
+public:
+    enum class Delivery {
+        LATEST_ONLY,
+        LOSSLESS,
+    };
+
+    static const size_t DEFAULT_MAX_QUEUED_EVENTS = 64;
+
+    // Doesn't take the ownership of |observer|.
+    AsyncGameStateObserver(GameStateObserver* observer, Delivery,
+                           size_t maxQueuedEvents = DEFAULT_MAX_QUEUED_EVENTS);
+    virtual ~AsyncGameStateObserver() override;
+
+    bool start();
+    // Delivers all the queued events, and stops the thread.
+    void stop();
+
+    virtual void newGameWillStart() override;
+    virtual void onUpdate(const GameState&) override;
+    virtual void gameHasDone(GameResult) override;
+
+    // The number of the updates replaced with a later one in LATEST_ONLY.
+    int numDroppedUpdates() const;
+
+private:
+    struct Event {
+        enum class Type { NEW_GAME, UPDATE, GAME_DONE };
+
+        Type type;
+        std::shared_ptr<const GameState> gameState;
+        GameResult gameResult;
+    };
+
+    void push(Event);
+    void runLoop();
+
+    GameStateObserver* observer_;
+    const Delivery delivery_;
+    const size_t maxQueuedEvents_;
+
+    std::thread th_;
+
+    mutable std::mutex mu_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<Event> queue_;
+    bool shouldStop_ = false;
+    int numDroppedUpdates_ = 0;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "core/server/async_game_state_observer.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/server/game_state.h"
+
+using namespace std;
+
+namespace {
+
+// Records the notifications. When blocked, onUpdate() waits until unblock() is called.
+class RecordingObserver : public GameStateObserver {
+public:
+    virtual void newGameWillStart() override { record("new"); }
+    virtual void onUpdate(const GameState& gameState) override
+    {
+        unique_lock<mutex> lock(mu_);
+        events_.push_back(to_string(gameState.frameId()));
+        ++numUpdatesEntered_;
+        condVar_.notify_all();
+        condVar_.wait(lock, [this]() { return !blocked_; });
+    }
+    virtual void gameHasDone(GameResult) override { record("done"); }
+
+    void block()
+    {
+        lock_guard<mutex> lock(mu_);
+        blocked_ = true;
+    }
+
+    void unblock()
+    {
+        lock_guard<mutex> lock(mu_);
+        blocked_ = false;
+        condVar_.notify_all();
+    }
+
+    void waitUntilUpdatesEntered(int n)
+    {
+        unique_lock<mutex> lock(mu_);
+        condVar_.wait(lock, [this, n]() { return numUpdatesEntered_ >= n; });
+    }
+
+    vector<string> events()
+    {
+        lock_guard<mutex> lock(mu_);
+        return events_;
+    }
+
+private:
+    void record(const string& s)
+    {
+        lock_guard<mutex> lock(mu_);
+        events_.push_back(s);
+    }
+
+    mutex mu_;
+    condition_variable condVar_;
+    vector<string> events_;
+    int numUpdatesEntered_ = 0;
+    bool blocked_ = false;
+};
+
+}
+
+TEST(AsyncGameStateObserverTest, losslessDeliversAllInOrder)
+{
+    RecordingObserver observer;
+    // A small queue so that onUpdate() waits for the observer.
+    AsyncGameStateObserver async(&observer, AsyncGameStateObserver::Delivery::LOSSLESS, 2);
+    async.start();
+
+    vector<string> expected { "new" };
+    async.newGameWillStart();
+    for (int i = 1; i <= 100; ++i) {
+        async.onUpdate(GameState(i));
+        expected.push_back(to_string(i));
+    }
+    async.gameHasDone(GameResult::DRAW);
+    expected.push_back("done");
+
+    async.stop();
+
+    EXPECT_EQ(expected, observer.events());
+    EXPECT_EQ(0, async.numDroppedUpdates());
+}
+
+TEST(AsyncGameStateObserverTest, latestOnlyDropsIntermediateUpdates)
+{
+    RecordingObserver observer;
+    AsyncGameStateObserver async(&observer, AsyncGameStateObserver::Delivery::LATEST_ONLY);
+    async.start();
+
+    observer.block();
+    async.onUpdate(GameState(1));
+    observer.waitUntilUpdatesEntered(1);
+
+    // The observer is still drawing the frame 1.
+    for (int i = 2; i <= 10; ++i)
+        async.onUpdate(GameState(i));
+
+    observer.unblock();
+    async.stop();
+
+    EXPECT_EQ((vector<string> { "1", "10" }), observer.events());
+    EXPECT_EQ(8, async.numDroppedUpdates());
+}
+
+TEST(AsyncGameStateObserverTest, latestOnlyKeepsGameEvents)
+{
+    RecordingObserver observer;
+    AsyncGameStateObserver async(&observer, AsyncGameStateObserver::Delivery::LATEST_ONLY);
+    async.start();
+
+    observer.block();
+    async.onUpdate(GameState(1));
+    observer.waitUntilUpdatesEntered(1);
+
+    async.onUpdate(GameState(2));
+    async.gameHasDone(GameResult::P1_WIN);
+    async.newGameWillStart();
+    async.onUpdate(GameState(3));
+    async.onUpdate(GameState(4));
+
+    observer.unblock();
+    async.stop();
+
+    EXPECT_EQ((vector<string> { "1", "2", "done", "new", "4" }), observer.events());
+    EXPECT_EQ(1, async.numDroppedUpdates());
+}
+
+TEST(AsyncGameStateObserverTest, latestOnlyDoesNotWaitWhenFullOfGameEvents)
+{
+    RecordingObserver observer;
+    AsyncGameStateObserver async(&observer, AsyncGameStateObserver::Delivery::LATEST_ONLY, 2);
+    async.start();
+
+    observer.block();
+    async.onUpdate(GameState(1));
+    observer.waitUntilUpdatesEntered(1);
+
+    // The queue is full without any update.
+    async.gameHasDone(GameResult::P1_WIN);
+    async.newGameWillStart();
+    // This should not wait for the observer.
+    async.onUpdate(GameState(2));
+    EXPECT_EQ(1, async.numDroppedUpdates());
+
+    observer.unblock();
+    async.stop();
+
+    EXPECT_EQ((vector<string> { "1", "done", "new" }), observer.events());
+}
@@ -5,6 +5,7 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -13,32 +14,17 @@
 
 #include "core/server/connector/human_connector.h"
 #include "core/server/connector/pipe_connector.h"
+#include "core/server/connector/shared_memory_connector.h"
+#include "core/shared_memory_channel.h"
 
 using namespace std;
 
-// static
-unique_ptr<Connector> Connector::create(int playerId, const string& programName)
+// Starts |programName| as a child process. Its stdin and stdout are connected to
+// |*writerFd| and |*readerFd|. When |handles| is not nullptr, it's passed to
+// the child process with SharedMemoryChannel::ENV_NAME.
+static void startProgram(int playerId, const string& programName, const SharedMemoryChannel::Handles* handles,
+                         int* writerFd, int* readerFd)
 {
-    if (programName == "-")
-        return unique_ptr<Connector>(new HumanConnector());
-
-    if (programName.find("fifo:") == 0) {
-        string::size_type colon = programName.find(":", 5);
-        string uplink_fifo = programName.substr(5, colon - 5);
-        string downlink_fifo = programName.substr(colon + 1);
-        CHECK(mkfifo(uplink_fifo.c_str(), 0777) == 0);
-        CHECK(chmod(uplink_fifo.c_str(), 0777) == 0);
-        CHECK(mkfifo(downlink_fifo.c_str(), 0777) == 0);
-        CHECK(chmod(downlink_fifo.c_str(), 0777) == 0);
-        int uplink_fd = open(uplink_fifo.c_str(), O_RDONLY);
-        CHECK(uplink_fd >= 0);
-        int downlink_fd = open(downlink_fifo.c_str(), O_WRONLY);
-        CHECK(downlink_fd >= 0);
-
-        unique_ptr<Connector> connector(new PipeConnector(downlink_fd, uplink_fd));
-        return connector;
-    }
-
     // File descriptors.
     int fd_field_status[2];
     int fd_command[2];
@@ -63,12 +49,12 @@ unique_ptr<Connector> Connector::create(int playerId, const string& programName)
         // Server.
         LOG(INFO) << "Created a child process (pid = " << pid << ")";
 
-        unique_ptr<Connector> connector(new PipeConnector(fd_field_status[1], fd_command[0]));
+        *writerFd = fd_field_status[1];
+        *readerFd = fd_command[0];
         close(fd_field_status[0]);
         close(fd_command[1]);
         close(fd_cpu_error[1]);
-
-        return connector;
+        return;
     }
 
     // Client.
@@ -89,6 +75,9 @@ unique_ptr<Connector> Connector::create(int playerId, const string& programName)
     close(fd_cpu_error[0]);
     close(fd_cpu_error[1]);
 
+    if (handles)
+        CHECK(setenv(SharedMemoryChannel::ENV_NAME, handles->toString().c_str(), 1) == 0);
+
     char filename[] = "Player1";
     filename[6] += playerId; // TODO(mayah): What's this !!
 
@@ -96,5 +85,44 @@ unique_ptr<Connector> Connector::create(int playerId, const string& programName)
         PLOG(FATAL) << "Failed to start a child process. ";
 
     LOG(FATAL) << "should not be reached.";
-    return unique_ptr<Connector>();
+}
+
+// static
+unique_ptr<Connector> Connector::create(int playerId, const string& programName)
+{
+    if (programName == "-")
+        return unique_ptr<Connector>(new HumanConnector());
+
+    if (programName.find("fifo:") == 0) {
+        string::size_type colon = programName.find(":", 5);
+        string uplink_fifo = programName.substr(5, colon - 5);
+        string downlink_fifo = programName.substr(colon + 1);
+        CHECK(mkfifo(uplink_fifo.c_str(), 0777) == 0);
+        CHECK(chmod(uplink_fifo.c_str(), 0777) == 0);
+        CHECK(mkfifo(downlink_fifo.c_str(), 0777) == 0);
+        CHECK(chmod(downlink_fifo.c_str(), 0777) == 0);
+        int uplink_fd = open(uplink_fifo.c_str(), O_RDONLY);
+        CHECK(uplink_fd >= 0);
+        int downlink_fd = open(downlink_fifo.c_str(), O_WRONLY);
+        CHECK(downlink_fd >= 0);
+
+        unique_ptr<Connector> connector(new PipeConnector(downlink_fd, uplink_fd));
+        return connector;
+    }
+
+    if (programName.find("shm:") == 0) {
+        SharedMemoryChannel::Handles handles;
+        if (SharedMemoryChannel::createHandles(&handles)) {
+            int writerFd, readerFd;
+            startProgram(playerId, programName.substr(4), &handles, &writerFd, &readerFd);
+            return unique_ptr<Connector>(new SharedMemoryConnector(handles, writerFd, readerFd));
+        }
+
+        LOG(WARNING) << "Failed to create a shared memory. Use pipes instead.";
+        return create(playerId, programName.substr(4));
+    }
+
+    int writerFd, readerFd;
+    startProgram(playerId, programName, nullptr, &writerFd, &readerFd);
+    return unique_ptr<Connector>(new PipeConnector(writerFd, readerFd));
 }
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/noncopyable.h"
 
@@ -16,7 +17,11 @@ public:
     virtual ~Connector() {}
 
     virtual void send(const FrameRequest&) = 0;
+    // Blocks until a response comes.
     virtual bool receive(FrameResponse*) = 0;
+    // Appends the responses which have completely come, without blocking.
+    // Returns false if the connection has been closed. Valid only when pollable() == true.
+    virtual bool receiveAvailable(std::vector<FrameResponse>*) = 0;
     virtual bool isHuman() const = 0;
 
     virtual bool isClosed() const = 0;
@@ -9,6 +9,8 @@ struct FrameResponse;
 
 class ConnectorManager {
 public:
+    virtual ~ConnectorManager() {}
+
     // Receives decision and messages from clients.
     // Returns false when disconnected.
     virtual bool receive(int frameId, std::vector<FrameResponse> data[2]) = 0;
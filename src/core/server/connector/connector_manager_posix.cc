@@ -13,6 +13,7 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "base/trace.h"
 #include "core/constant.h"
 #include "core/frame_response.h"
 #include "core/server/connector/connector.h"
@@ -115,6 +116,10 @@ bool ConnectorManagerPosix::receive(int frameId, vector<FrameResponse> cfr[NUM_P
                     if (response.frameId == frameId) {
                         received_data_for_this_frame[playerIds[i]] = true;
                     }
+                } else if (connector(playerIds[i])->isClosed()) {
+                    // e.g. SharedMemoryConnector notices the death of the client in receive().
+                    LOG(ERROR) << "[P" << playerIds[i] << "] Closed the connection.";
+                    died = true;
                 }
             } else if ((pollfds[i].revents & POLLERR) ||
                        (pollfds[i].revents & POLLHUP) ||
@@ -141,7 +146,7 @@ bool ConnectorManagerPosix::receive(int frameId, vector<FrameResponse> cfr[NUM_P
     }
 
     int usec = getUsecFromStart(tv_start);
-    LOG(INFO) << "Frame " << frameId  << " took " << usec << " [us]";
+    trace::record(trace::Event::FRAME_RECEIVED, frameId, usec);
 
     return !died;
 }
@@ -0,0 +1,308 @@
+#include "core/server/connector/epoll_connector_hub.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/frame_response.h"
+#include "core/player.h"
+#include "core/server/connector/connector.h"
+#include "core/server/connector/connector_manager.h"
+
+using namespace std;
+
+DECLARE_bool(realtime);
+DECLARE_bool(no_timeout);
+
+namespace {
+// The key of wakeUpFd_ in epoll.
+const uint64_t WAKE_UP_KEY = 0;
+const int MAX_EVENTS = 64;
+}
+
+// Game is a ConnectorManager for one game. All the members except connectors_
+// are guarded by hub_->mu_.
+class EpollConnectorHub::Game : public ConnectorManager {
+public:
+    Game(EpollConnectorHub* hub, unique_ptr<Connector> p1, unique_ptr<Connector> p2, int timeoutUsec) :
+        hub_(hub),
+        connectors_ { move(p1), move(p2) },
+        timeout_(chrono::microseconds(timeoutUsec))
+    {
+    }
+
+    virtual ~Game()
+    {
+        unique_lock<mutex> lock(hub_->mu_);
+        hub_->removeGame(this, &lock);
+    }
+
+    virtual bool receive(int frameId, vector<FrameResponse> cfr[NUM_PLAYERS]) override;
+    virtual Connector* connector(int i) override { return connectors_[i].get(); }
+    virtual void setWaitTimeout(bool flag) override { waitTimeout_ = flag; }
+
+private:
+    friend class EpollConnectorHub;
+
+    bool isCompleted(Clock::time_point now) const
+    {
+        if (died_ || now >= deadline_)
+            return true;
+        // If a realtime game flag is not set, do not wait for timeout, and
+        // continue the game as soon as possible.
+        if (!FLAGS_realtime && received_[0] && received_[1])
+            return true;
+        return false;
+    }
+
+    EpollConnectorHub* hub_;
+    unique_ptr<Connector> connectors_[NUM_PLAYERS];
+    Clock::duration timeout_;
+    uint64_t keys_[NUM_PLAYERS] {};
+    bool waitTimeout_ = true;
+
+    bool waiting_ = false;
+    int frameId_ = -1;
+    Clock::time_point deadline_;
+    bool received_[NUM_PLAYERS] {};
+    bool died_ = false;
+    // Responses received since the last receive().
+    vector<FrameResponse> responses_[NUM_PLAYERS];
+    condition_variable condVar_;
+};
+
+bool EpollConnectorHub::Game::receive(int frameId, vector<FrameResponse> cfr[NUM_PLAYERS])
+{
+    unique_lock<mutex> lock(hub_->mu_);
+    if (hub_->shouldStop_)
+        return false;
+
+    Clock::time_point now = Clock::now();
+    frameId_ = frameId;
+    for (int i = 0; i < NUM_PLAYERS; ++i) {
+        received_[i] = any_of(responses_[i].begin(), responses_[i].end(), [frameId](const FrameResponse& r) {
+            return r.frameId == frameId;
+        });
+    }
+    if (!waitTimeout_)
+        deadline_ = now;
+    else if (FLAGS_no_timeout)
+        deadline_ = Clock::time_point::max();
+    else
+        deadline_ = now + timeout_;
+
+    if (!isCompleted(now)) {
+        waiting_ = true;
+        hub_->wakeUp();
+        condVar_.wait(lock, [this]() { return !waiting_; });
+    }
+
+    for (int i = 0; i < NUM_PLAYERS; ++i) {
+        cfr[i].clear();
+        cfr[i].swap(responses_[i]);
+    }
+
+    return !died_;
+}
+
+EpollConnectorHub::EpollConnectorHub()
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    PCHECK(epollFd_ >= 0) << "failed to create epoll";
+    wakeUpFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    PCHECK(wakeUpFd_ >= 0) << "failed to create eventfd";
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_UP_KEY;
+    PCHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeUpFd_, &ev) == 0);
+}
+
+EpollConnectorHub::~EpollConnectorHub()
+{
+    stop();
+    DCHECK(games_.empty()) << "ConnectorManager should be destructed before the hub";
+
+    close(wakeUpFd_);
+    close(epollFd_);
+}
+
+unique_ptr<ConnectorManager> EpollConnectorHub::addGame(unique_ptr<Connector> p1, unique_ptr<Connector> p2,
+                                                        int timeoutUsec)
+{
+    CHECK(p1->pollable() && p2->pollable()) << "EpollConnectorHub supports only pollable connectors";
+
+    Game* game = new Game(this, move(p1), move(p2), timeoutUsec);
+
+    lock_guard<mutex> lock(mu_);
+    games_.push_back(game);
+    for (int pi = 0; pi < NUM_PLAYERS; ++pi) {
+        uint64_t key = nextKey_++;
+        game->keys_[pi] = key;
+        entries_[key] = Entry { game, pi };
+
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = key;
+        PCHECK(epoll_ctl(epollFd_, EPOLL_CTL_ADD, game->connector(pi)->readerFd(), &ev) == 0);
+    }
+
+    return unique_ptr<ConnectorManager>(game);
+}
+
+bool EpollConnectorHub::start()
+{
+    shouldStop_ = false;
+    th_ = thread([this]() {
+        this->runLoop();
+    });
+    return true;
+}
+
+void EpollConnectorHub::stop()
+{
+    shouldStop_ = true;
+    wakeUp();
+    if (th_.joinable())
+        th_.join();
+}
+
+void EpollConnectorHub::wakeUp()
+{
+    uint64_t one = 1;
+    if (write(wakeUpFd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        PLOG(ERROR) << "failed to wake up the hub";
+}
+
+void EpollConnectorHub::removeGame(Game* game, unique_lock<mutex>* lock)
+{
+    // The connectors might be being read.
+    readingDone_.wait(*lock, [this]() { return !reading_; });
+
+    for (int pi = 0; pi < NUM_PLAYERS; ++pi) {
+        if (entries_.erase(game->keys_[pi]) > 0)
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, game->connector(pi)->readerFd(), nullptr);
+    }
+    games_.erase(remove(games_.begin(), games_.end(), game), games_.end());
+}
+
+void EpollConnectorHub::runLoop()
+{
+    epoll_event events[MAX_EVENTS];
+    vector<Reading> readings;
+
+    while (!shouldStop_) {
+        int timeoutMs;
+        {
+            lock_guard<mutex> lock(mu_);
+            timeoutMs = nextTimeoutMs(Clock::now());
+        }
+
+        int n = epoll_wait(epollFd_, events, MAX_EVENTS, timeoutMs);
+        if (n < 0 && errno != EINTR) {
+            PLOG(ERROR) << "epoll_wait failed";
+            break;
+        }
+
+        readings.clear();
+        {
+            lock_guard<mutex> lock(mu_);
+            for (int i = 0; i < n; ++i) {
+                uint64_t key = events[i].data.u64;
+                if (key == WAKE_UP_KEY) {
+                    uint64_t value;
+                    if (read(wakeUpFd_, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                        PLOG(ERROR) << "failed to read eventfd";
+                    continue;
+                }
+                // A game might have been removed after epoll_wait returned its events.
+                auto it = entries_.find(key);
+                if (it != entries_.end())
+                    readings.push_back(Reading { key, it->second, true, vector<FrameResponse>() });
+            }
+            reading_ = !readings.empty();
+        }
+
+        // Reading doesn't block, but it's done out of the lock, so that the games
+        // can start waiting for the next frame meanwhile.
+        for (Reading& reading : readings) {
+            Connector* connector = reading.entry.game->connector(reading.entry.playerId);
+            reading.alive = connector->receiveAvailable(&reading.responses);
+        }
+
+        lock_guard<mutex> lock(mu_);
+        if (reading_) {
+            reading_ = false;
+            readingDone_.notify_all();
+        }
+        for (const Reading& reading : readings)
+            handleReading(reading);
+
+        completeGames(Clock::now());
+    }
+
+    // Don't leave games waiting forever.
+    lock_guard<mutex> lock(mu_);
+    for (Game* game : games_) {
+        game->waiting_ = false;
+        game->condVar_.notify_all();
+    }
+}
+
+void EpollConnectorHub::handleReading(const Reading& reading)
+{
+    Game* game = reading.entry.game;
+    int pi = reading.entry.playerId;
+
+    for (const FrameResponse& response : reading.responses) {
+        if (response.frameId == game->frameId_)
+            game->received_[pi] = true;
+        game->responses_[pi].push_back(response);
+    }
+
+    if (!reading.alive) {
+        LOG(ERROR) << "[P" << pi << "] Closed the connection.";
+        Connector* connector = game->connector(pi);
+        connector->setClosed(true);
+        game->died_ = true;
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, connector->readerFd(), nullptr);
+        entries_.erase(reading.key);
+    }
+}
+
+int EpollConnectorHub::nextTimeoutMs(Clock::time_point now) const
+{
+    Clock::time_point deadline = Clock::time_point::max();
+    for (const Game* game : games_) {
+        if (game->waiting_)
+            deadline = min(deadline, game->deadline_);
+    }
+
+    if (deadline == Clock::time_point::max())
+        return -1;
+    if (deadline <= now)
+        return 0;
+
+    auto ms = chrono::duration_cast<chrono::milliseconds>(deadline - now + chrono::microseconds(999)).count();
+    return static_cast<int>(min<decltype(ms)>(ms, numeric_limits<int>::max()));
+}
+
+void EpollConnectorHub::completeGames(Clock::time_point now)
+{
+    for (Game* game : games_) {
+        if (game->waiting_ && game->isCompleted(now)) {
+            game->waiting_ = false;
+            game->condVar_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef CORE_SERVER_CONNECTOR_EPOLL_CONNECTOR_HUB_H_
+#define CORE_SERVER_CONNECTOR_EPOLL_CONNECTOR_HUB_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "core/constant.h"
+#include "core/frame_response.h"
+
+class Connector;
+class ConnectorManager;
+
+// EpollConnectorHub multiplexes the connectors of many concurrent games on one
+// epoll instance. Each game gets a ConnectorManager from addGame(), and its
+// receive() blocks until the hub has collected the responses for the frame,
+// or the game's deadline has passed.
+// Deadlines use the monotonic clock. Only pollable connectors are supported.
+// The connectors are read with Connector::receiveAvailable() out of the lock, so
+// a client sending a partial message never stalls the other games.
+class EpollConnectorHub : noncopyable {
+public:
+    static const int DEFAULT_TIMEOUT_USEC = 1000000 / FPS;
+
+    EpollConnectorHub();
+    ~EpollConnectorHub();
+
+    // Adds a game. |timeoutUsec| is the time to wait for the responses in each frame.
+    // The returned ConnectorManager must be destructed before the hub.
+    std::unique_ptr<ConnectorManager> addGame(std::unique_ptr<Connector> p1, std::unique_ptr<Connector> p2,
+                                              int timeoutUsec = DEFAULT_TIMEOUT_USEC);
+
+    bool start();
+    void stop();
+
+private:
+    class Game;
+    friend class Game;
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        Game* game;
+        int playerId;
+    };
+
+    // A connector to read in an iteration of runLoop().
+    struct Reading {
+        uint64_t key;
+        Entry entry;
+        bool alive;
+        std::vector<FrameResponse> responses;
+    };
+
+    void runLoop();
+    void wakeUp();
+
+    // Called from Game with |mu_| locked. Waits while the connectors are being read.
+    void removeGame(Game*, std::unique_lock<std::mutex>*);
+
+    void handleReading(const Reading&);
+    // Returns the timeout for epoll_wait [ms].
+    int nextTimeoutMs(Clock::time_point now) const;
+    void completeGames(Clock::time_point now);
+
+    int epollFd_;
+    // eventfd to wake up epoll_wait when a game starts waiting.
+    int wakeUpFd_;
+
+    std::thread th_;
+    std::atomic<bool> shouldStop_ { false };
+
+    std::mutex mu_;
+    // True while the connectors are being read without |mu_|. Games are not removed then.
+    bool reading_ = false;
+    std::condition_variable readingDone_;
+    std::vector<Game*> games_;
+    // Keys are passed to epoll. A key is looked up every time, since a game
+    // might have been removed after epoll_wait returned its events.
+    std::map<uint64_t, Entry> entries_;
+    uint64_t nextKey_ = 1;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "core/server/connector/epoll_connector_hub.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include "core/frame_response.h"
+#include "core/server/connector/connector_manager.h"
+#include "core/server/connector/pipe_connector.h"
+
+using namespace std;
+
+DECLARE_bool(realtime);
+DECLARE_bool(offer_binary_protocol);
+
+// Pipes between a PipeConnector and a fake client.
+class FakeClient {
+public:
+    FakeClient()
+    {
+        CHECK_EQ(0, pipe(toClient_));
+        CHECK_EQ(0, pipe(toServer_));
+    }
+
+    ~FakeClient()
+    {
+        close(toClient_[0]);
+        if (toServer_[1] >= 0)
+            close(toServer_[1]);
+    }
+
+    unique_ptr<Connector> makeConnector() { return unique_ptr<Connector>(new PipeConnector(toClient_[1], toServer_[0])); }
+
+    void respond(const string& line) { write(line + "\n"); }
+
+    void write(const string& s)
+    {
+        CHECK_EQ(static_cast<ssize_t>(s.size()), ::write(toServer_[1], s.data(), s.size()));
+    }
+
+    void disconnect()
+    {
+        close(toServer_[1]);
+        toServer_[1] = -1;
+    }
+
+private:
+    int toClient_[2];
+    int toServer_[2];
+};
+
+class EpollConnectorHubTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        FLAGS_offer_binary_protocol = false;
+        hub_.start();
+    }
+
+    void TearDown() override
+    {
+        managers_.clear();
+        hub_.stop();
+        FLAGS_realtime = true;
+        FLAGS_offer_binary_protocol = true;
+    }
+
+    void addGames(int timeoutUsec)
+    {
+        for (int i = 0; i < 2; ++i)
+            managers_.push_back(hub_.addGame(clients_[i][0].makeConnector(), clients_[i][1].makeConnector(), timeoutUsec));
+    }
+
+    FakeClient clients_[2][2];
+    EpollConnectorHub hub_;
+    vector<unique_ptr<ConnectorManager>> managers_;
+};
+
+TEST_F(EpollConnectorHubTest, realtime)
+{
+    addGames(20000);
+
+    clients_[0][0].respond("ID=1 X=3 R=0");
+    clients_[0][1].respond("ID=1");
+    clients_[1][1].respond("ID=1 X=1 R=1");
+
+    for (int i = 0; i < 2; ++i) {
+        auto start = chrono::steady_clock::now();
+        vector<FrameResponse> data[2];
+        EXPECT_TRUE(managers_[i]->receive(1, data));
+        // Waits until the deadline.
+        EXPECT_LE(chrono::milliseconds(20), chrono::steady_clock::now() - start);
+
+        if (i == 0) {
+            ASSERT_EQ(1U, data[0].size());
+            EXPECT_EQ(Decision(3, 0), data[0][0].decision);
+            EXPECT_EQ(1U, data[1].size());
+        } else {
+            EXPECT_EQ(0U, data[0].size());
+            ASSERT_EQ(1U, data[1].size());
+            EXPECT_EQ(Decision(1, 1), data[1][0].decision);
+        }
+    }
+}
+
+TEST_F(EpollConnectorHubTest, notRealtime)
+{
+    FLAGS_realtime = false;
+    // receive() should return as soon as the responses have come, long before the deadline.
+    addGames(60 * 1000000);
+
+    clients_[1][0].respond("ID=1");
+    clients_[1][1].respond("ID=1");
+
+    vector<FrameResponse> data[2];
+    EXPECT_TRUE(managers_[1]->receive(1, data));
+    EXPECT_EQ(1U, data[0].size());
+    EXPECT_EQ(1U, data[1].size());
+}
+
+TEST_F(EpollConnectorHubTest, multipleResponsesAtOnce)
+{
+    FLAGS_realtime = false;
+    addGames(60 * 1000000);
+
+    // Both responses are read at once. The second one should not be left unread.
+    clients_[0][0].respond("ID=1\nID=2");
+    clients_[0][1].respond("ID=2");
+
+    vector<FrameResponse> data[2];
+    EXPECT_TRUE(managers_[0]->receive(2, data));
+    ASSERT_EQ(2U, data[0].size());
+    EXPECT_EQ(1, data[0][0].frameId);
+    EXPECT_EQ(2, data[0][1].frameId);
+    EXPECT_EQ(1U, data[1].size());
+}
+
+TEST_F(EpollConnectorHubTest, partialResponseDoesNotStallOtherGames)
+{
+    FLAGS_realtime = false;
+    addGames(60 * 1000000);
+
+    // The client of the game 0 has sent only a part of its response.
+    clients_[0][0].write("ID=1 X=");
+    clients_[0][1].respond("ID=1");
+    clients_[1][0].respond("ID=1");
+    clients_[1][1].respond("ID=1");
+
+    vector<FrameResponse> data[2];
+    EXPECT_TRUE(managers_[1]->receive(1, data));
+    EXPECT_EQ(1U, data[0].size());
+    EXPECT_EQ(1U, data[1].size());
+
+    clients_[0][0].respond("3 R=0");
+    EXPECT_TRUE(managers_[0]->receive(1, data));
+    ASSERT_EQ(1U, data[0].size());
+    EXPECT_EQ(Decision(3, 0), data[0][0].decision);
+    EXPECT_EQ(1U, data[1].size());
+}
+
+TEST_F(EpollConnectorHubTest, disconnected)
+{
+    addGames(20000);
+    clients_[0][1].disconnect();
+
+    vector<FrameResponse> data[2];
+    EXPECT_FALSE(managers_[0]->receive(1, data));
+    EXPECT_FALSE(managers_[0]->connector(0)->isClosed());
+    EXPECT_TRUE(managers_[0]->connector(1)->isClosed());
+
+    // The other game is not affected.
+    EXPECT_TRUE(managers_[1]->receive(1, data));
+}
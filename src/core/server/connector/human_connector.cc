@@ -26,6 +26,12 @@ bool HumanConnector::receive(FrameResponse* response)
     return true;
 }
 
+bool HumanConnector::receiveAvailable(vector<FrameResponse>*)
+{
+    CHECK(false) << "HumanConnector is not pollable.";
+    return false;
+}
+
 void HumanConnector::setClosed(bool)
 {
     CHECK(false) << "HumanConnector does not have closed flag.";
@@ -16,6 +16,7 @@ public:
 
     virtual void send(const FrameRequest&) override;
     virtual bool receive(FrameResponse*) override;
+    virtual bool receiveAvailable(std::vector<FrameResponse>*) override;
 
     virtual bool isHuman() const override { return true; }
     // HumanConnector is always alive.
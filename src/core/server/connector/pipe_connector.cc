@@ -1,34 +1,58 @@
 #include "core/server/connector/pipe_connector.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <cerrno>
 #include <cstddef>
 #include <cstring>
 
+#include "base/trace.h"
+#include "core/binary_frame.h"
 #include "core/frame_request.h"
 #include "core/frame_response.h"
 
 using namespace std;
 
+DEFINE_bool(offer_binary_protocol, true, "offer the binary protocol to clients. See core/binary_frame.h");
+DEFINE_bool(delta_frame_request, true, "send only the difference from the previous FrameRequest in the binary protocol");
+
 PipeConnector::PipeConnector(int writerFd, int readerFd) :
     writerFd_(writerFd),
     readerFd_(readerFd)
 {
     writer_ = fdopen(writerFd_, "w");
-    reader_ = fdopen(readerFd_, "r");
-
     CHECK(writer_);
-    CHECK(reader_);
+
+    int flags = fcntl(readerFd_, F_GETFL);
+    PCHECK(flags >= 0 && fcntl(readerFd_, F_SETFL, flags | O_NONBLOCK) == 0);
 }
 
 PipeConnector::~PipeConnector()
 {
     fclose(writer_);
-    fclose(reader_);
+    close(readerFd_);
 }
 
 void PipeConnector::send(const FrameRequest& req)
 {
+    if (binary_) {
+        char buf[FrameRequest::BINARY_SIZE];
+        size_t size = req.toBinary(buf, FLAGS_delta_frame_request ? &lastBinaryRequest_ : nullptr);
+        binary_frame::write(writer_, buf, size);
+        lastBinaryRequest_ = req;
+        return;
+    }
+
+    if (FLAGS_offer_binary_protocol) {
+        writeString(req.toString() + binary_frame::OFFER_TERM);
+        return;
+    }
+
     writeString(req.toString());
 }
 
@@ -36,30 +60,87 @@ void PipeConnector::writeString(const string& message)
 {
     fprintf(writer_, "%s\n", message.c_str());
     fflush(writer_);
-    LOG(INFO) << message;
+    trace::record(trace::Event::MESSAGE_SENT, writerFd_, message);
 }
 
 bool PipeConnector::receive(FrameResponse* response)
 {
-    char buf[1000];
-    char* ptr = fgets(buf, 999, reader_);
-    if (!ptr)
-        return false;
-
-    size_t len = strlen(ptr);
-    if (len == 0)
-        return false;
+    while (!extractResponse(response)) {
+        if (closed_)
+            return false;
+        if (readAvailable())
+            continue;
+        if (closed_)
+            return false;
 
-    if (ptr[len-1] == '\n') {
-        ptr[--len] = '\0';
+        pollfd pfd { readerFd_, POLLIN, 0 };
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            return false;
     }
-    if (len == 0)
-        return false;
-    if (ptr[len-1] == '\r') {
-        ptr[--len] = '\0';
+    return true;
+}
+
+bool PipeConnector::receiveAvailable(vector<FrameResponse>* responses)
+{
+    bool alive = readAvailable() || !closed_;
+
+    FrameResponse response;
+    while (extractResponse(&response))
+        responses->push_back(response);
+    return alive;
+}
+
+bool PipeConnector::readAvailable()
+{
+    bool hasRead = false;
+    char buf[4096];
+    while (true) {
+        ssize_t n = read(readerFd_, buf, sizeof(buf));
+        if (n > 0) {
+            readBuffer_.append(buf, n);
+            hasRead = true;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && errno == EAGAIN)
+            return hasRead;
+
+        // EOF or error.
+        closed_ = true;
+        return hasRead;
     }
+}
 
-    LOG(INFO) << buf;
-    *response = FrameResponse::parse(buf);
-    return true;
+bool PipeConnector::extractResponse(FrameResponse* response)
+{
+    while (true) {
+        bool binary;
+        switch (binary_frame::extract(&readBuffer_, &buffer_, &binary)) {
+        case binary_frame::ExtractResult::INCOMPLETE:
+            return false;
+        case binary_frame::ExtractResult::BROKEN:
+            LOG(ERROR) << "received a broken binary frame";
+            readBuffer_.clear();
+            closed_ = true;
+            return false;
+        case binary_frame::ExtractResult::OK:
+            break;
+        }
+
+        if (binary) {
+            // The client has accepted the binary protocol.
+            binary_ = true;
+            *response = FrameResponse::parseBinary(buffer_.data(), buffer_.size());
+            return true;
+        }
+
+        // An empty line is ignored.
+        if (buffer_.empty())
+            continue;
+
+        trace::record(trace::Event::MESSAGE_RECEIVED, readerFd_, buffer_);
+        *response = FrameResponse::parse(buffer_);
+        return true;
+    }
 }
@@ -1,12 +1,14 @@
 #ifndef CORE_SERVER_CONNECTOR_PIPE_CONNECTOR_H_
 #define CORE_SERVER_CONNECTOR_PIPE_CONNECTOR_H_
 
+#include <atomic>
 #include <cstdio>
 #include <string>
+#include <vector>
 
+#include "core/frame_request.h"
 #include "core/server/connector/connector.h"
 
-struct FrameRequest;
 struct FrameResponse;
 
 class PipeConnector : public Connector {
@@ -16,6 +18,7 @@ public:
 
     virtual void send(const FrameRequest&) override;
     virtual bool receive(FrameResponse*) override;
+    virtual bool receiveAvailable(std::vector<FrameResponse>*) override;
 
     virtual bool isHuman() const override { return false; }
     virtual bool isClosed() const override { return closed_; }
@@ -25,13 +28,26 @@ public:
 
 private:
     void writeString(const std::string&);
-
-    bool closed_ = false;
+    // Reads the bytes available into |readBuffer_|. Returns false on EOF or error.
+    bool readAvailable();
+    // Takes a response from |readBuffer_|. Returns false if it doesn't have a whole one.
+    bool extractResponse(FrameResponse*);
+
+    // This is atomic, since the connection might be closed from a different thread.
+    std::atomic<bool> closed_ { false };
+    // True after the client has accepted the binary protocol.
+    // This is atomic, since send() and receive() might be called from different threads.
+    std::atomic<bool> binary_ { false };
+    // The bytes read from |readerFd_|, which might end with an incomplete message.
+    // |readerFd_| is read directly, so that poll() never misses a buffered message.
+    std::string readBuffer_;
+    std::string buffer_;
+    // The base of the delta format. Invalid until the first binary FrameRequest is sent.
+    FrameRequest lastBinaryRequest_;
 
     int writerFd_;
     int readerFd_;
     FILE* writer_;
-    FILE* reader_;
 };
 
 #endif
@@ -0,0 +1,60 @@
+#include "core/server/connector/shared_memory_connector.h"
+
+#include <unistd.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "core/frame_response.h"
+
+using namespace std;
+
+DECLARE_bool(delta_frame_request);
+
+SharedMemoryConnector::SharedMemoryConnector(const SharedMemoryChannel::Handles& handles, int writerFd, int readerFd) :
+    writerFd_(writerFd),
+    readerFd_(readerFd),
+    channel_(handles, SharedMemoryChannel::Side::SERVER, readerFd)
+{
+}
+
+SharedMemoryConnector::~SharedMemoryConnector()
+{
+    close(writerFd_);
+    close(readerFd_);
+}
+
+void SharedMemoryConnector::send(const FrameRequest& req)
+{
+    char buf[FrameRequest::BINARY_SIZE];
+    size_t size = req.toBinary(buf, FLAGS_delta_frame_request ? &lastRequest_ : nullptr);
+    if (!channel_.send(buf, size))
+        LOG(ERROR) << "failed to send a FrameRequest";
+    lastRequest_ = req;
+}
+
+bool SharedMemoryConnector::receive(FrameResponse* response)
+{
+    if (!channel_.receive(&buffer_)) {
+        closed_ = true;
+        return false;
+    }
+
+    *response = FrameResponse::parseBinary(buffer_.data(), buffer_.size());
+    return true;
+}
+
+bool SharedMemoryConnector::receiveAvailable(vector<FrameResponse>* responses)
+{
+    bool received = false;
+    while (channel_.tryReceive(&buffer_)) {
+        responses->push_back(FrameResponse::parseBinary(buffer_.data(), buffer_.size()));
+        received = true;
+    }
+
+    if (!received && channel_.isPeerClosed()) {
+        closed_ = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef CORE_SERVER_CONNECTOR_SHARED_MEMORY_CONNECTOR_H_
+#define CORE_SERVER_CONNECTOR_SHARED_MEMORY_CONNECTOR_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "core/frame_request.h"
+#include "core/server/connector/connector.h"
+#include "core/shared_memory_channel.h"
+
+struct FrameResponse;
+
+// SharedMemoryConnector talks to a client on the same host via SharedMemoryChannel.
+// Messages are always in the binary format. The client should use ClientConnector,
+// which uses SharedMemoryChannel when SharedMemoryChannel::ENV_NAME is set.
+class SharedMemoryConnector : public Connector {
+public:
+    // Takes the ownership of the file descriptors. |writerFd| and |readerFd| are
+    // the pipes to the stdin and from the stdout of the client. They are used only
+    // to notice the death of the other side.
+    SharedMemoryConnector(const SharedMemoryChannel::Handles&, int writerFd, int readerFd);
+    virtual ~SharedMemoryConnector();
+
+    virtual void send(const FrameRequest&) override;
+    virtual bool receive(FrameResponse*) override;
+    virtual bool receiveAvailable(std::vector<FrameResponse>*) override;
+
+    virtual bool isHuman() const override { return false; }
+    virtual bool isClosed() const override { return closed_; }
+    virtual void setClosed(bool flag) override { closed_ = flag; }
+    virtual bool pollable() const override { return true; }
+    virtual int readerFd() const override { return channel_.readerFd(); }
+
+private:
+    // This is atomic, since the connection might be closed from a different thread.
+    std::atomic<bool> closed_ { false };
+
+    int writerFd_;
+    int readerFd_;
+    SharedMemoryChannel channel_;
+    std::string buffer_;
+    // The base of the delta format.
+    FrameRequest lastRequest_;
+};
+
+#endif
@@ -0,0 +1,381 @@
+#include "core/shared_memory_channel.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <glog/logging.h>
+
+using namespace std;
+
+namespace {
+
+// Must be a power of 2.
+const uint32_t RING_SIZE = 256 * 1024;
+
+const int SERVER_INDEX = 0;
+const int CLIENT_INDEX = 1;
+
+void notify(int fd)
+{
+    uint64_t one = 1;
+    while (write(fd, &one, sizeof(one)) < 0) {
+        if (errno == EINTR)
+            continue;
+        // EAGAIN means the counter is already huge, so the receiver will wake up anyway.
+        if (errno != EAGAIN)
+            PLOG(ERROR) << "failed to notify eventfd";
+        return;
+    }
+}
+
+// Clears the notifications. eventfds are non-blocking, so this doesn't block.
+void drain(int fd)
+{
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) < 0 && errno == EINTR) {}
+}
+
+void setCloseOnExec(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if (flags >= 0)
+        fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+}
+
+}
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic int should be lock-free to be shared between processes");
+
+const char SharedMemoryChannel::ENV_NAME[] = "PUYOAI_SHARED_MEMORY_FDS";
+
+// |head| is written only by the consumer, and |tail| is written only by the producer.
+// They are increased monotonically, and wrap around at 2^32.
+// A message is its size (4 bytes) followed by its payload. It might wrap around the buffer.
+//
+// |consumerWaiting| is set by the consumer before it waits, and taken by the producer
+// who notifies it. |producerWaiting| is the same for the opposite. The flags and
+// the positions are sequentially consistent, so that a notification is never lost:
+// either the waiter sees the new position, or the notifier sees the flag.
+struct SharedMemoryChannel::Ring {
+    void write(uint32_t pos, const char* data, size_t size)
+    {
+        uint32_t offset = pos & (RING_SIZE - 1);
+        size_t n = min<size_t>(size, RING_SIZE - offset);
+        memcpy(buffer + offset, data, n);
+        memcpy(buffer, data + n, size - n);
+    }
+
+    void read(uint32_t pos, char* data, size_t size) const
+    {
+        uint32_t offset = pos & (RING_SIZE - 1);
+        size_t n = min<size_t>(size, RING_SIZE - offset);
+        memcpy(data, buffer + offset, n);
+        memcpy(data + n, buffer, size - n);
+    }
+
+    bool empty() const { return head.load() == tail.load(); }
+    bool hasSpace(size_t size) const { return RING_SIZE - (tail.load() - head.load()) >= size + 4; }
+
+    // Returns false if there is not enough space.
+    bool push(const char* data, size_t size)
+    {
+        uint32_t t = tail.load(memory_order_relaxed);
+        uint32_t h = head.load(memory_order_acquire);
+        if (RING_SIZE - (t - h) < size + 4)
+            return false;
+
+        uint32_t size32 = static_cast<uint32_t>(size);
+        write(t, reinterpret_cast<const char*>(&size32), 4);
+        write(t + 4, data, size);
+        tail.store(t + 4 + size32);
+        return true;
+    }
+
+    // Returns false if there is no message.
+    bool pop(string* message)
+    {
+        uint32_t h = head.load(memory_order_relaxed);
+        uint32_t t = tail.load(memory_order_acquire);
+        if (t == h)
+            return false;
+
+        uint32_t size32;
+        read(h, reinterpret_cast<char*>(&size32), 4);
+        message->resize(size32);
+        if (size32 > 0)
+            read(h + 4, &(*message)[0], size32);
+        head.store(h + 4 + size32);
+        return true;
+    }
+
+    alignas(64) atomic<uint32_t> head;
+    atomic<uint32_t> producerWaiting;
+    alignas(64) atomic<uint32_t> tail;
+    atomic<uint32_t> consumerWaiting;
+    alignas(64) char buffer[RING_SIZE];
+};
+
+struct SharedMemoryChannel::Region {
+    Ring serverToClient;
+    Ring clientToServer;
+};
+
+// static
+bool SharedMemoryChannel::Handles::parse(const string& s, Handles* handles)
+{
+    return sscanf(s.c_str(), "%d,%d,%d,%d,%d", &handles->sharedMemoryFd,
+                  &handles->dataFds[0], &handles->dataFds[1],
+                  &handles->spaceFds[0], &handles->spaceFds[1]) == 5;
+}
+
+string SharedMemoryChannel::Handles::toString() const
+{
+    char buf[80];
+    snprintf(buf, sizeof(buf), "%d,%d,%d,%d,%d", sharedMemoryFd, dataFds[0], dataFds[1], spaceFds[0], spaceFds[1]);
+    return buf;
+}
+
+#ifdef __linux__
+
+// static
+bool SharedMemoryChannel::createHandles(Handles* handles)
+{
+    // The file descriptors will be passed to a client with exec(), so they are not CLOEXEC.
+    int fd = memfd_create("puyoai", 0);
+    if (fd < 0) {
+        PLOG(ERROR) << "failed to create a shared memory";
+        return false;
+    }
+
+    // ftruncate() fills the memory with 0, so the rings are empty.
+    if (ftruncate(fd, sizeof(Region)) < 0) {
+        PLOG(ERROR) << "failed to resize a shared memory";
+        close(fd);
+        return false;
+    }
+
+    Handles result;
+    result.sharedMemoryFd = fd;
+    int* eventFds[] = { &result.dataFds[0], &result.dataFds[1], &result.spaceFds[0], &result.spaceFds[1] };
+    for (int* eventFd : eventFds) {
+        *eventFd = eventfd(0, EFD_NONBLOCK);
+        if (*eventFd < 0) {
+            PLOG(ERROR) << "failed to create eventfd";
+            for (int* p : eventFds) {
+                if (*p >= 0)
+                    close(*p);
+            }
+            close(fd);
+            return false;
+        }
+    }
+
+    *handles = result;
+    return true;
+}
+
+SharedMemoryChannel::SharedMemoryChannel(const Handles& handles, Side side, int peerFd) :
+    handles_(handles),
+    peerFd_(peerFd)
+{
+    void* p = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, handles.sharedMemoryFd, 0);
+    PCHECK(p != MAP_FAILED) << "failed to map a shared memory";
+    // The mapping is kept after the file descriptor is closed.
+    close(handles_.sharedMemoryFd);
+    handles_.sharedMemoryFd = -1;
+
+    // Don't pass the handles to other processes started later.
+    for (int i = 0; i < 2; ++i) {
+        setCloseOnExec(handles_.dataFds[i]);
+        setCloseOnExec(handles_.spaceFds[i]);
+    }
+
+    int self = side == Side::SERVER ? SERVER_INDEX : CLIENT_INDEX;
+    int peer = side == Side::SERVER ? CLIENT_INDEX : SERVER_INDEX;
+
+    region_ = static_cast<Region*>(p);
+    if (side == Side::SERVER) {
+        sendRing_ = &region_->serverToClient;
+        receiveRing_ = &region_->clientToServer;
+    } else {
+        sendRing_ = &region_->clientToServer;
+        receiveRing_ = &region_->serverToClient;
+    }
+    sendDataFd_ = handles_.dataFds[peer];
+    sendSpaceFd_ = handles_.spaceFds[peer];
+    receiveDataFd_ = handles_.dataFds[self];
+    receiveSpaceFd_ = handles_.spaceFds[self];
+
+    pollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    PCHECK(pollFd_ >= 0) << "failed to create epoll";
+    int fds[] = { receiveDataFd_, peerFd_ };
+    for (int fd : fds) {
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        PCHECK(epoll_ctl(pollFd_, EPOLL_CTL_ADD, fd, &ev) == 0);
+    }
+
+    // The peer might have sent messages already.
+    armDataNotification();
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+    close(pollFd_);
+    for (int i = 0; i < 2; ++i) {
+        close(handles_.dataFds[i]);
+        close(handles_.spaceFds[i]);
+    }
+    munmap(region_, sizeof(Region));
+}
+
+#else
+
+// static
+bool SharedMemoryChannel::createHandles(Handles*)
+{
+    LOG(ERROR) << "SharedMemoryChannel is supported only on Linux";
+    return false;
+}
+
+SharedMemoryChannel::SharedMemoryChannel(const Handles&, Side, int)
+{
+    LOG(FATAL) << "SharedMemoryChannel is supported only on Linux";
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+}
+
+#endif
+
+bool SharedMemoryChannel::send(const char* data, size_t size)
+{
+    CHECK_LE(size + 4, RING_SIZE);
+
+    while (!sendRing_->push(data, size)) {
+        // Like a pipe, wait until the receiver consumes messages.
+        sendRing_->producerWaiting.store(1);
+        if (sendRing_->hasSpace(size)) {
+            sendRing_->producerWaiting.store(0);
+            continue;
+        }
+        bool ok = waitFor(sendSpaceFd_);
+        sendRing_->producerWaiting.store(0);
+        drain(sendSpaceFd_);
+        if (!ok)
+            return false;
+    }
+
+    if (sendRing_->consumerWaiting.exchange(0))
+        notify(sendDataFd_);
+    return true;
+}
+
+bool SharedMemoryChannel::receive(string* message)
+{
+    while (true) {
+        if (tryReceive(message))
+            return true;
+        if (!waitFor(receiveDataFd_))
+            return false;
+    }
+}
+
+bool SharedMemoryChannel::tryReceive(string* message)
+{
+    if (!receiveRing_->pop(message)) {
+        // Nothing has come. The stale notification, if any, is cleared.
+        armDataNotification();
+        if (!receiveRing_->pop(message))
+            return false;
+    }
+
+    if (receiveRing_->producerWaiting.exchange(0))
+        notify(receiveSpaceFd_);
+    if (receiveRing_->empty())
+        armDataNotification();
+    return true;
+}
+
+bool SharedMemoryChannel::isPeerClosed()
+{
+    pollfd pfd { peerFd_, POLLIN, 0 };
+    while (poll(&pfd, 1, 0) > 0) {
+        if (pfd.revents & POLLIN) {
+            if (!discardPeerOutput())
+                return true;
+            continue;
+        }
+        return (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+    }
+    return false;
+}
+
+void SharedMemoryChannel::armDataNotification()
+{
+    drain(receiveDataFd_);
+    receiveRing_->consumerWaiting.store(1);
+
+    // A message pushed before the flag is set is not notified by the sender.
+    // Notify it by ourselves, so that readerFd() stays readable.
+    if (!receiveRing_->empty() && receiveRing_->consumerWaiting.exchange(0))
+        notify(receiveDataFd_);
+}
+
+bool SharedMemoryChannel::waitFor(int fd)
+{
+    pollfd pfds[] = { { fd, POLLIN, 0 }, { peerFd_, POLLIN, 0 } };
+    while (true) {
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            PLOG(ERROR) << "failed to poll";
+            return false;
+        }
+
+        if (pfds[0].revents & POLLIN)
+            return true;
+
+        if (pfds[1].revents & POLLIN) {
+            if (!discardPeerOutput())
+                return false;
+            continue;
+        }
+
+        if (pfds[1].revents & (POLLERR | POLLHUP | POLLNVAL))
+            return false;
+    }
+}
+
+bool SharedMemoryChannel::discardPeerOutput()
+{
+    // Nothing should be written to the pipe.
+    char buf[1024];
+    while (true) {
+        ssize_t n = ::read(peerFd_, buf, sizeof(buf));
+        if (n > 0) {
+            LOG(WARNING) << "discarded " << n << " bytes written to the pipe by the peer";
+            return true;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        return false;
+    }
+}
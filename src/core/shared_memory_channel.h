@@ -0,0 +1,86 @@
+#ifndef CORE_SHARED_MEMORY_CHANNEL_H_
+#define CORE_SHARED_MEMORY_CHANNEL_H_
+
+#include <cstddef>
+#include <string>
+
+#include "base/noncopyable.h"
+
+// SharedMemoryChannel passes messages between the server and a client running
+// on the same host. The shared memory has two lock-free single-producer/single-consumer
+// rings, one for each direction.
+//
+// A receiver waits on an eventfd, which is notified only when the receiver is
+// actually waiting. So a message sent to a busy receiver costs no syscall.
+// A sender blocks on another eventfd while the ring is full.
+// stdin and stdout are not used to pass messages. The pipe from the peer is watched
+// only to notice its death, and anything written to it is discarded.
+//
+// eventfd is available only on Linux. On other platforms, createHandles() fails.
+class SharedMemoryChannel : noncopyable {
+public:
+    enum class Side { SERVER, CLIENT };
+
+    // The file descriptors shared by the server and a client.
+    struct Handles {
+        // Parses the string made by toString().
+        static bool parse(const std::string&, Handles*);
+        std::string toString() const;
+
+        int sharedMemoryFd = -1;
+        // eventfds to notify that a message has been pushed, and that a message has
+        // been popped. Indexed by the side which receives the messages.
+        int dataFds[2] { -1, -1 };
+        int spaceFds[2] { -1, -1 };
+    };
+
+    // The environment variable to pass Handles to a client.
+    static const char ENV_NAME[];
+
+    // Creates the handles for a channel. They are inherited by child processes.
+    // Returns false if failed.
+    static bool createHandles(Handles*);
+
+    // Takes the ownership of |handles|, but not of |peerFd|. |peerFd| is the reader
+    // of the pipe from the peer, which is used to notice the peer's death.
+    SharedMemoryChannel(const Handles& handles, Side, int peerFd);
+    ~SharedMemoryChannel();
+
+    // Blocks while the ring is full. Returns false if the peer has closed the connection.
+    bool send(const char* data, size_t size);
+    // Blocks until a message comes. Returns false if the peer has closed the connection.
+    bool receive(std::string* message);
+    // Doesn't block. Returns false if no message has come.
+    bool tryReceive(std::string* message);
+    // Doesn't block. Returns true if the peer has closed the connection.
+    bool isPeerClosed();
+
+    // Readable when a message has come or the peer has closed the connection.
+    int readerFd() const { return pollFd_; }
+
+private:
+    struct Ring;
+    struct Region;
+
+    // Makes the sender notify the next message. Called when the ring has become empty.
+    void armDataNotification();
+    // Waits until |fd| is notified. Returns false if the peer has closed the connection.
+    bool waitFor(int fd);
+    // Discards what the peer has written to the pipe. Returns false if the peer has
+    // closed the connection.
+    bool discardPeerOutput();
+
+    Handles handles_;
+    Region* region_;
+    Ring* sendRing_;
+    Ring* receiveRing_;
+    int sendDataFd_;
+    int sendSpaceFd_;
+    int receiveDataFd_;
+    int receiveSpaceFd_;
+    int peerFd_;
+    // epoll of receiveDataFd_ and peerFd_.
+    int pollFd_ = -1;
+};
+
+#endif
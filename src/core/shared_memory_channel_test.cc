@@ -0,0 +1,152 @@
+#include "core/shared_memory_channel.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+bool isReadable(int fd)
+{
+    pollfd pfd { fd, POLLIN, 0 };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+}
+
+class SharedMemoryChannelTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        SharedMemoryChannel::Handles handles;
+        ASSERT_TRUE(SharedMemoryChannel::createHandles(&handles));
+
+        // In the real use, these are stdin and stdout of the client. Only their hang-up matters.
+        ASSERT_EQ(0, pipe(toClient_));
+        ASSERT_EQ(0, pipe(toServer_));
+
+        // Each side takes the ownership of its own copy of the handles.
+        SharedMemoryChannel::Handles clientHandles;
+        clientHandles.sharedMemoryFd = dup(handles.sharedMemoryFd);
+        for (int i = 0; i < 2; ++i) {
+            clientHandles.dataFds[i] = dup(handles.dataFds[i]);
+            clientHandles.spaceFds[i] = dup(handles.spaceFds[i]);
+        }
+
+        server_.reset(new SharedMemoryChannel(handles, SharedMemoryChannel::Side::SERVER, toServer_[0]));
+        client_.reset(new SharedMemoryChannel(clientHandles, SharedMemoryChannel::Side::CLIENT, toClient_[0]));
+    }
+
+    void TearDown() override
+    {
+        server_.reset();
+        client_.reset();
+        for (int fd : { toClient_[0], toClient_[1], toServer_[0], toServer_[1] }) {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    void closeClientStdout()
+    {
+        close(toServer_[1]);
+        toServer_[1] = -1;
+    }
+
+    int toClient_[2];
+    int toServer_[2];
+    unique_ptr<SharedMemoryChannel> server_;
+    unique_ptr<SharedMemoryChannel> client_;
+};
+
+TEST_F(SharedMemoryChannelTest, sendAndReceive)
+{
+    string message;
+
+    EXPECT_TRUE(server_->send("request1", 8));
+    EXPECT_TRUE(server_->send("", 0));
+    EXPECT_TRUE(client_->receive(&message));
+    EXPECT_EQ("request1", message);
+    EXPECT_TRUE(client_->receive(&message));
+    EXPECT_EQ("", message);
+
+    EXPECT_TRUE(client_->send("response", 8));
+    EXPECT_TRUE(server_->receive(&message));
+    EXPECT_EQ("response", message);
+
+    // Messages wrap around the ring.
+    string large(100000, 'x');
+    for (int i = 0; i < 10; ++i) {
+        large[0] = 'a' + i;
+        EXPECT_TRUE(server_->send(large.data(), large.size()));
+        EXPECT_TRUE(client_->receive(&message));
+        EXPECT_EQ(large, message);
+    }
+}
+
+TEST_F(SharedMemoryChannelTest, readerFdIsReadableWhileMessagesRemain)
+{
+    string message;
+    EXPECT_FALSE(isReadable(server_->readerFd()));
+
+    EXPECT_TRUE(client_->send("1", 1));
+    EXPECT_TRUE(client_->send("2", 1));
+    EXPECT_TRUE(isReadable(server_->readerFd()));
+
+    EXPECT_TRUE(server_->receive(&message));
+    EXPECT_EQ("1", message);
+    EXPECT_TRUE(isReadable(server_->readerFd()));
+
+    EXPECT_TRUE(server_->receive(&message));
+    EXPECT_EQ("2", message);
+    EXPECT_FALSE(isReadable(server_->readerFd()));
+}
+
+TEST_F(SharedMemoryChannelTest, sendBlocksWhileFull)
+{
+    // 3 messages don't fit in the ring, so the sender waits for the receiver.
+    const int N = 10;
+    string large(100000, 'x');
+    thread sender([&]() {
+        for (int i = 0; i < N; ++i) {
+            large[0] = 'a' + i;
+            EXPECT_TRUE(server_->send(large.data(), large.size()));
+        }
+    });
+
+    string message;
+    for (int i = 0; i < N; ++i) {
+        ASSERT_TRUE(client_->receive(&message));
+        EXPECT_EQ(static_cast<char>('a' + i), message[0]);
+        EXPECT_EQ(large.size(), message.size());
+    }
+    sender.join();
+}
+
+TEST_F(SharedMemoryChannelTest, writesToPipeAreDiscarded)
+{
+    string message;
+    EXPECT_EQ(6, write(toServer_[1], "stray\n", 6));
+    EXPECT_TRUE(client_->send("response", 8));
+
+    EXPECT_TRUE(server_->receive(&message));
+    EXPECT_EQ("response", message);
+}
+
+TEST_F(SharedMemoryChannelTest, peerClosed)
+{
+    string message;
+    EXPECT_TRUE(client_->send("last", 4));
+    closeClientStdout();
+
+    // The messages sent before the death are still delivered.
+    EXPECT_TRUE(server_->receive(&message));
+    EXPECT_EQ("last", message);
+    EXPECT_FALSE(server_->receive(&message));
+}
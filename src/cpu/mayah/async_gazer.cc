@@ -0,0 +1,105 @@
+#include "async_gazer.h"
+
+#include "base/phase_profiler.h"
+
+using namespace std;
+
+namespace {
+
+const int PHASE_GAZE = PhaseProfiler::registerPhase("mayah.gaze");
+
+}
+
+AsyncGazer::AsyncGazer() :
+    result_(Gazer().gazeResult())
+{
+    th_ = thread([this]() {
+        runLoop();
+    });
+}
+
+AsyncGazer::~AsyncGazer()
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        shouldStop_ = true;
+    }
+    condVar_.notify_all();
+    th_.join();
+}
+
+void AsyncGazer::initialize(int frameIdGameWillBegin)
+{
+    Gazer gazer;
+    gazer.initialize(frameIdGameWillBegin);
+
+    lock_guard<mutex> lock(mu_);
+    hasRequest_ = false;
+    ++generation_;
+    numGazed_ = 0;
+    result_ = gazer.gazeResult();
+}
+
+void AsyncGazer::gaze(int frameId, const CoreField& field, const KumipuyoSeq& seq)
+{
+    {
+        lock_guard<mutex> lock(mu_);
+        request_.frameId = frameId;
+        request_.field = field;
+        request_.seq = seq;
+        request_.generation = generation_;
+        hasRequest_ = true;
+    }
+    condVar_.notify_all();
+}
+
+void AsyncGazer::waitUntilIdle()
+{
+    unique_lock<mutex> lock(mu_);
+    condVar_.wait(lock, [this]() { return !hasRequest_ && !busy_; });
+}
+
+GazeResult AsyncGazer::gazeResult() const
+{
+    lock_guard<mutex> lock(mu_);
+    return result_;
+}
+
+int AsyncGazer::numGazed() const
+{
+    lock_guard<mutex> lock(mu_);
+    return numGazed_;
+}
+
+void AsyncGazer::runLoop()
+{
+    while (true) {
+        Request request;
+        {
+            unique_lock<mutex> lock(mu_);
+            condVar_.wait(lock, [this]() { return shouldStop_ || hasRequest_; });
+            if (shouldStop_)
+                return;
+            request = request_;
+            hasRequest_ = false;
+            busy_ = true;
+        }
+
+        // Gazer::gaze() overwrites all the state, so |gazer_| needn't be initialized.
+        {
+            ScopedPhaseTimer phaseTimer(PHASE_GAZE);
+            gazer_.gaze(request.frameId, request.field, request.seq);
+        }
+        GazeResult result = gazer_.gazeResult();
+
+        {
+            lock_guard<mutex> lock(mu_);
+            if (request.generation == generation_) {
+                result_ = std::move(result);
+                ++numGazed_;
+            }
+            busy_ = false;
+        }
+        condVar_.notify_all();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef CPU_MAYAH_ASYNC_GAZER_H_
+#define CPU_MAYAH_ASYNC_GAZER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "base/noncopyable.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq.h"
+
+#include "gazer.h"
+
+// AsyncGazer runs Gazer on a background thread, so that gazing doesn't consume
+// the time budget of think() even when they happen in the same frame.
+//
+// Only the latest request is gazed; the pending older one is skipped.
+// gazeResult() returns the latest finished result, which might be older than the
+// latest request. Since the frames in GazeResult are relative to the frame gazed at,
+// an older result is still valid for the newer frames.
+class AsyncGazer : noncopyable {
+public:
+    AsyncGazer();
+    ~AsyncGazer();
+
+    // Resets the result. The pending and running requests are discarded.
+    void initialize(int frameIdGameWillBegin);
+
+    // Requests to gaze. This returns immediately.
+    void gaze(int frameId, const CoreField&, const KumipuyoSeq&);
+    // Waits until all the requests are gazed.
+    void waitUntilIdle();
+
+    GazeResult gazeResult() const;
+    // The number of the results installed since initialize().
+    int numGazed() const;
+
+private:
+    struct Request {
+        int frameId;
+        CoreField field;
+        KumipuyoSeq seq;
+        int generation;
+    };
+
+    void runLoop();
+
+    mutable std::mutex mu_;
+    std::condition_variable condVar_;
+    Request request_;
+    bool hasRequest_ = false;
+    bool busy_ = false;
+    bool shouldStop_ = false;
+    // Incremented by initialize(). The results of the older generation are discarded.
+    int generation_ = 0;
+    int numGazed_ = 0;
+    GazeResult result_;
+
+    // Used only on the background thread.
+    Gazer gazer_;
+
+    std::thread th_;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "async_gazer.h"
+
+#include <gtest/gtest.h>
+
+#include "core/algorithm/puyo_possibility.h"
+#include "core/kumipuyo_seq.h"
+
+using namespace std;
+
+class AsyncGazerTest : public testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        TsumoPossibility::initialize();
+    }
+};
+
+TEST_F(AsyncGazerTest, sameAsGazer)
+{
+    CoreField f(
+        "BRBG  "
+        "BBRBBB"
+        "RRYGGG");
+    KumipuyoSeq seq("BYRRGG");
+
+    Gazer gazer;
+    gazer.initialize(100);
+    gazer.gaze(100, f, seq);
+
+    AsyncGazer asyncGazer;
+    asyncGazer.initialize(100);
+    asyncGazer.gaze(100, f, seq);
+    asyncGazer.waitUntilIdle();
+
+    EXPECT_EQ(1, asyncGazer.numGazed());
+    EXPECT_EQ(gazer.gazeResult().toRensaInfoString(), asyncGazer.gazeResult().toRensaInfoString());
+    EXPECT_EQ(gazer.gazeResult().estimateMaxScore(300, PlayerState()),
+              asyncGazer.gazeResult().estimateMaxScore(300, PlayerState()));
+}
+
+TEST_F(AsyncGazerTest, latestRequestWins)
+{
+    CoreField f(
+        "BRBG  "
+        "BBRBBB"
+        "RRYGGG");
+    KumipuyoSeq seq("BYRRGG");
+
+    AsyncGazer asyncGazer;
+    asyncGazer.initialize(100);
+    for (int frameId = 100; frameId < 110; ++frameId)
+        asyncGazer.gaze(frameId, f, seq);
+    asyncGazer.waitUntilIdle();
+
+    // Some requests might be skipped, but the last one must be gazed.
+    EXPECT_LE(1, asyncGazer.numGazed());
+    EXPECT_GE(10, asyncGazer.numGazed());
+    EXPECT_EQ(109, asyncGazer.gazeResult().frameIdGazedAt());
+}
+
+TEST_F(AsyncGazerTest, initialize)
+{
+    CoreField f(
+        "BRBG  "
+        "BBRBBB"
+        "RRYGGG");
+    KumipuyoSeq seq("BYRRGG");
+
+    AsyncGazer asyncGazer;
+    asyncGazer.initialize(100);
+    asyncGazer.gaze(150, f, seq);
+    asyncGazer.initialize(200);
+    asyncGazer.waitUntilIdle();
+
+    // The request before initialize() is discarded.
+    EXPECT_EQ(0, asyncGazer.numGazed());
+    EXPECT_EQ(200, asyncGazer.gazeResult().frameIdGazedAt());
+}
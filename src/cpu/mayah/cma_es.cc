@@ -0,0 +1,281 @@
+#include "cma_es.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include <glog/logging.h>
+
+using namespace std;
+
+namespace {
+
+const char CHECKPOINT_HEADER[] = "cmaes-checkpoint-1";
+
+void writeVector(ostream& os, const char* name, const vector<double>& vs)
+{
+    os << name;
+    for (double v : vs)
+        os << ' ' << v;
+    os << '\n';
+}
+
+bool readVector(istream& is, const char* name, size_t size, vector<double>* vs)
+{
+    string key;
+    if (!(is >> key) || key != name)
+        return false;
+
+    vs->resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        if (!(is >> (*vs)[i]))
+            return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool readValue(istream& is, const char* name, T* value)
+{
+    string key;
+    return (is >> key) && key == name && (is >> *value);
+}
+
+}
+
+CMAES::CMAES(const vector<double>& initialMean, const vector<double>& initialStddevs,
+             int lambda, unsigned int seed) :
+    lambda_(lambda),
+    seed_(seed),
+    mean_(initialMean),
+    c_(initialMean.size()),
+    pc_(initialMean.size()),
+    ps_(initialMean.size()),
+    best_(initialMean),
+    bestFitness_(-numeric_limits<double>::infinity())
+{
+    CHECK(!initialMean.empty());
+    CHECK_EQ(initialMean.size(), initialStddevs.size());
+
+    for (size_t i = 0; i < initialStddevs.size(); ++i)
+        c_[i] = initialStddevs[i] * initialStddevs[i];
+
+    if (lambda_ <= 0)
+        lambda_ = 4 + static_cast<int>(3 * log(static_cast<double>(initialMean.size())));
+    CHECK_GE(lambda_, 2);
+
+    initializeConstants();
+}
+
+void CMAES::initializeConstants()
+{
+    const double n = dimension();
+    const int mu = lambda_ / 2;
+
+    weights_.resize(mu);
+    for (int i = 0; i < mu; ++i)
+        weights_[i] = log(mu + 0.5) - log(i + 1.0);
+    double sum = accumulate(weights_.begin(), weights_.end(), 0.0);
+    double sumSquare = 0;
+    for (double& w : weights_) {
+        w /= sum;
+        sumSquare += w * w;
+    }
+    mueff_ = 1.0 / sumSquare;
+
+    cc_ = 4.0 / (n + 4.0);
+    cs_ = (mueff_ + 2.0) / (n + mueff_ + 5.0);
+    double c1 = 2.0 / ((n + 1.3) * (n + 1.3) + mueff_);
+    double cmu = 2.0 * (mueff_ - 2.0 + 1.0 / mueff_) / ((n + 2.0) * (n + 2.0) + mueff_);
+    // The learning rates can be (n + 2) / 3 times larger for the separable version.
+    c1_ = c1 * (n + 2.0) / 3.0;
+    cmu_ = min(1.0 - c1_, cmu * (n + 2.0) / 3.0);
+    damps_ = 1.0 + 2.0 * max(0.0, sqrt((mueff_ - 1.0) / (n + 1.0)) - 1.0) + cs_;
+    chiN_ = sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+}
+
+vector<vector<double>> CMAES::ask() const
+{
+    seed_seq seq { seed_, static_cast<unsigned int>(generation_) };
+    mt19937 mt(seq);
+    normal_distribution<> dist(0.0, 1.0);
+
+    vector<vector<double>> population(lambda_, vector<double>(dimension()));
+    for (auto& x : population) {
+        for (int i = 0; i < dimension(); ++i)
+            x[i] = mean_[i] + sigma_ * sqrt(c_[i]) * dist(mt);
+    }
+    return population;
+}
+
+void CMAES::tell(const vector<vector<double>>& population, const vector<double>& fitness)
+{
+    CHECK_EQ(static_cast<size_t>(lambda_), population.size());
+    CHECK_EQ(static_cast<size_t>(lambda_), fitness.size());
+
+    const int n = dimension();
+
+    vector<int> order(lambda_);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&fitness](int lhs, int rhs) { return fitness[lhs] > fitness[rhs]; });
+
+    if (bestFitness_ < fitness[order[0]]) {
+        bestFitness_ = fitness[order[0]];
+        best_ = population[order[0]];
+    }
+
+    // y_k = (x_k - m) / sigma for the selected points.
+    vector<vector<double>> ys(mu(), vector<double>(n));
+    vector<double> yw(n);
+    for (int k = 0; k < mu(); ++k) {
+        const vector<double>& x = population[order[k]];
+        for (int i = 0; i < n; ++i) {
+            ys[k][i] = (x[i] - mean_[i]) / sigma_;
+            yw[i] += weights_[k] * ys[k][i];
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+        mean_[i] += sigma_ * yw[i];
+
+    double psNormSquare = 0;
+    for (int i = 0; i < n; ++i) {
+        ps_[i] = (1 - cs_) * ps_[i] + sqrt(cs_ * (2 - cs_) * mueff_) * yw[i] / sqrt(c_[i]);
+        psNormSquare += ps_[i] * ps_[i];
+    }
+    double psNorm = sqrt(psNormSquare);
+
+    double hsigThreshold = (1.4 + 2.0 / (n + 1.0)) * chiN_;
+    bool hsig = psNorm / sqrt(1 - pow(1 - cs_, 2.0 * (generation_ + 1))) < hsigThreshold;
+
+    for (int i = 0; i < n; ++i) {
+        pc_[i] = (1 - cc_) * pc_[i] + (hsig ? sqrt(cc_ * (2 - cc_) * mueff_) * yw[i] : 0.0);
+
+        double rankMu = 0;
+        for (int k = 0; k < mu(); ++k)
+            rankMu += weights_[k] * ys[k][i] * ys[k][i];
+
+        double rankOne = pc_[i] * pc_[i] + (hsig ? 0.0 : cc_ * (2 - cc_) * c_[i]);
+        c_[i] = (1 - c1_ - cmu_) * c_[i] + c1_ * rankOne + cmu_ * rankMu;
+    }
+
+    sigma_ *= exp((cs_ / damps_) * (psNorm / chiN_ - 1));
+    ++generation_;
+}
+
+vector<double> CMAES::stddevs() const
+{
+    vector<double> result(dimension());
+    for (int i = 0; i < dimension(); ++i)
+        result[i] = sigma_ * sqrt(c_[i]);
+    return result;
+}
+
+string CMAES::toString() const
+{
+    ostringstream ss;
+    ss << setprecision(numeric_limits<double>::max_digits10);
+    ss << CHECKPOINT_HEADER << '\n'
+       << "dimension " << dimension() << '\n'
+       << "lambda " << lambda_ << '\n'
+       << "seed " << seed_ << '\n'
+       << "generation " << generation_ << '\n'
+       << "sigma " << sigma_ << '\n'
+       << "best_fitness " << bestFitness_ << '\n';
+    writeVector(ss, "mean", mean_);
+    writeVector(ss, "c", c_);
+    writeVector(ss, "pc", pc_);
+    writeVector(ss, "ps", ps_);
+    writeVector(ss, "best", best_);
+    return ss.str();
+}
+
+bool CMAES::save(const string& filename) const
+{
+    // Writes to a temporary file first not to break the checkpoint when killed.
+    string tmp = filename + ".tmp";
+    {
+        ofstream ofs(tmp, ios::out | ios::trunc);
+        ofs << toString();
+        if (!ofs) {
+            LOG(WARNING) << "CMAES::save failed: " << tmp;
+            return false;
+        }
+    }
+
+    if (rename(tmp.c_str(), filename.c_str()) != 0) {
+        PLOG(WARNING) << "CMAES::save failed: " << filename;
+        return false;
+    }
+    return true;
+}
+
+bool CMAES::load(const string& filename)
+{
+    ifstream ifs(filename, ios::in);
+    if (!ifs)
+        return false;
+
+    stringstream ss;
+    ss << ifs.rdbuf();
+    if (!loadFromString(ss.str())) {
+        LOG(ERROR) << "CMAES::load failed: " << filename;
+        return false;
+    }
+    return true;
+}
+
+bool CMAES::loadFromString(const string& s)
+{
+    istringstream is(s);
+
+    string header;
+    if (!(is >> header) || header != CHECKPOINT_HEADER)
+        return false;
+
+    int dimension;
+    int lambda, generation;
+    unsigned int seed;
+    double sigma, bestFitness;
+    if (!readValue(is, "dimension", &dimension) || dimension != this->dimension())
+        return false;
+    if (!readValue(is, "lambda", &lambda) || lambda < 2)
+        return false;
+    if (!readValue(is, "seed", &seed) || !readValue(is, "generation", &generation))
+        return false;
+    if (!readValue(is, "sigma", &sigma))
+        return false;
+
+    // "-inf" cannot be read with operator>>.
+    string bestFitnessStr;
+    if (!readValue(is, "best_fitness", &bestFitnessStr))
+        return false;
+    bestFitness = bestFitnessStr == "-inf" ? -numeric_limits<double>::infinity() : strtod(bestFitnessStr.c_str(), nullptr);
+
+    vector<double> mean, c, pc, ps, best;
+    if (!readVector(is, "mean", dimension, &mean) || !readVector(is, "c", dimension, &c) ||
+        !readVector(is, "pc", dimension, &pc) || !readVector(is, "ps", dimension, &ps) ||
+        !readVector(is, "best", dimension, &best))
+        return false;
+
+    lambda_ = lambda;
+    seed_ = seed;
+    initializeConstants();
+
+    generation_ = generation;
+    sigma_ = sigma;
+    bestFitness_ = bestFitness;
+    mean_ = std::move(mean);
+    c_ = std::move(c);
+    pc_ = std::move(pc);
+    ps_ = std::move(ps);
+    best_ = std::move(best);
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef CPU_MAYAH_CMA_ES_H_
+#define CPU_MAYAH_CMA_ES_H_
+
+#include <string>
+#include <vector>
+
+// CMAES maximizes a function of a real vector with the separable CMA-ES
+// (Ros and Hansen, 2008). Only the diagonal of the covariance matrix is adapted,
+// so a generation costs O(lambda * n), and it learns fast with hundreds of
+// dimensions. Call ask() to sample a population, evaluate it, and call tell().
+//
+// The sampling of each generation depends only on the state and the generation,
+// so the optimization resumed from a checkpoint (see save() and load()) samples
+// the same population as the original one.
+class CMAES {
+public:
+    // |initialMean| is the start point, and |initialStddevs| is the initial standard
+    // deviation of each dimension. |lambda| is the population size. If |lambda| is 0,
+    // the default size 4 + 3 ln(n) is used.
+    CMAES(const std::vector<double>& initialMean, const std::vector<double>& initialStddevs,
+          int lambda = 0, unsigned int seed = 1);
+
+    // Samples the population of the current generation.
+    std::vector<std::vector<double>> ask() const;
+    // Updates the distribution with the fitness of the population returned by ask().
+    // Higher fitness is better.
+    void tell(const std::vector<std::vector<double>>& population, const std::vector<double>& fitness);
+
+    int dimension() const { return static_cast<int>(mean_.size()); }
+    int lambda() const { return lambda_; }
+    int mu() const { return static_cast<int>(weights_.size()); }
+    int generation() const { return generation_; }
+    double sigma() const { return sigma_; }
+    const std::vector<double>& mean() const { return mean_; }
+    // Returns the standard deviation of each dimension, i.e. sigma * sqrt(C_ii).
+    std::vector<double> stddevs() const;
+
+    // The best point ever told, and its fitness.
+    const std::vector<double>& best() const { return best_; }
+    double bestFitness() const { return bestFitness_; }
+
+    std::string toString() const;
+    bool save(const std::string& filename) const;
+    // Restores the state saved with save(). The dimension must be the same.
+    bool load(const std::string& filename);
+
+private:
+    void initializeConstants();
+    bool loadFromString(const std::string&);
+
+    int lambda_;
+    unsigned int seed_;
+
+    // Constants depending on the dimension and lambda.
+    std::vector<double> weights_;
+    double mueff_;
+    double cc_;
+    double cs_;
+    double c1_;
+    double cmu_;
+    double damps_;
+    double chiN_;
+
+    // State.
+    int generation_ = 0;
+    double sigma_ = 1.0;
+    std::vector<double> mean_;
+    std::vector<double> c_;   // The diagonal of the covariance matrix.
+    std::vector<double> pc_;
+    std::vector<double> ps_;
+    std::vector<double> best_;
+    double bestFitness_;
+};
+
+#endif
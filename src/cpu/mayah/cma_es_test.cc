@@ -0,0 +1,85 @@
+#include "cma_es.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+
+double negativeSphere(const vector<double>& x)
+{
+    double s = 0;
+    for (size_t i = 0; i < x.size(); ++i)
+        s -= (x[i] - i) * (x[i] - i);
+    return s;
+}
+
+void runGeneration(CMAES* cmaes)
+{
+    vector<vector<double>> population = cmaes->ask();
+    vector<double> fitness;
+    for (const auto& x : population)
+        fitness.push_back(negativeSphere(x));
+    cmaes->tell(population, fitness);
+}
+
+}
+
+TEST(CMAESTest, sphere)
+{
+    const int N = 10;
+    CMAES cmaes(vector<double>(N, 0.0), vector<double>(N, 3.0));
+
+    for (int i = 0; i < 300; ++i)
+        runGeneration(&cmaes);
+
+    EXPECT_EQ(300, cmaes.generation());
+    for (int i = 0; i < N; ++i)
+        EXPECT_NEAR(i, cmaes.mean()[i], 1e-2);
+    EXPECT_LT(-1e-3, cmaes.bestFitness());
+}
+
+TEST(CMAESTest, defaultLambda)
+{
+    CMAES cmaes(vector<double>(100, 0.0), vector<double>(100, 1.0));
+    EXPECT_EQ(4 + 13, cmaes.lambda());
+    EXPECT_EQ(8, cmaes.mu());
+    EXPECT_EQ(17U, cmaes.ask().size());
+}
+
+TEST(CMAESTest, askIsDeterministic)
+{
+    CMAES cmaes(vector<double>(5, 0.0), vector<double>(5, 1.0), 8, 3);
+    EXPECT_EQ(cmaes.ask(), cmaes.ask());
+}
+
+TEST(CMAESTest, saveAndLoad)
+{
+    const int N = 5;
+    const string filename = "cma_es_test_checkpoint.txt";
+
+    CMAES original(vector<double>(N, 0.0), vector<double>(N, 1.0), 8, 5);
+    for (int i = 0; i < 10; ++i)
+        runGeneration(&original);
+    ASSERT_TRUE(original.save(filename));
+
+    CMAES resumed(vector<double>(N, 100.0), vector<double>(N, 100.0));
+    ASSERT_TRUE(resumed.load(filename));
+    EXPECT_EQ(original.toString(), resumed.toString());
+    EXPECT_EQ(original.ask(), resumed.ask());
+
+    // The resumed optimization continues exactly.
+    runGeneration(&original);
+    runGeneration(&resumed);
+    EXPECT_EQ(original.toString(), resumed.toString());
+
+    CMAES differentDimension(vector<double>(N + 1, 0.0), vector<double>(N + 1, 1.0));
+    EXPECT_FALSE(differentDimension.load(filename));
+    EXPECT_FALSE(resumed.load(filename + ".nonexistent"));
+
+    remove(filename.c_str());
+}
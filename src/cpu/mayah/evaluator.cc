@@ -9,6 +9,7 @@
 
 #include <glog/logging.h>
 
+#include "base/phase_profiler.h"
 #include "base/time.h"
 #include "core/algorithm/plan.h"
 #include "core/algorithm/puyo_possibility.h"
@@ -29,6 +30,8 @@ using namespace std;
 
 namespace {
 
+const int PHASE_PATTERN_RENSA_DETECTOR = PhaseProfiler::registerPhase("mayah.patternRensaDetector");
+
 const bool USE_CONNECTION_FEATURE = true;
 const bool USE_RESTRICTED_CONNECTION_HORIZONTAL_FEATURE = true;
 const bool USE_THIRD_COLUMN_HEIGHT_FEATURE = true;
@@ -664,8 +667,11 @@ void Evaluator<ScoreCollector>::collectScore(const RefPlan& plan, const CoreFiel
                         const RensaTrackResult& trackResult, const string& patternName, double patternScore) {
         evalCallback(fieldBeforeRensa, fieldAfterRensa, rensaResult, keyPuyos, firePuyos, patternScore, patternName, trackResult);
     };
-    PatternRensaDetector detector(patternBook(), fieldBeforeRensa, callback);
-    detector.iteratePossibleRensas(preEvalResult.matchablePatternIds(), maxIteration);
+    {
+        ScopedPhaseTimer phaseTimer(PHASE_PATTERN_RENSA_DETECTOR);
+        PatternRensaDetector detector(patternBook(), fieldBeforeRensa, callback);
+        detector.iteratePossibleRensas(preEvalResult.matchablePatternIds(), maxIteration);
+    }
 
     if (sideChainMaxScore >= scoreForOjama(21)) {
         sc_->addScore(HOLDING_SIDE_CHAIN_LARGE, 1);
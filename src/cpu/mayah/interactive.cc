@@ -103,6 +103,7 @@ int main(int argc, char* argv[])
         {
             double t1 = currentTime();
             ai.gaze(frameId, req.playerFrameRequest[1].field, req.playerFrameRequest[1].kumipuyoSeq);
+            ai.waitUntilGazed();
             double t2 = currentTime();
             cout << "gazer time = " << (t2 - t1) << endl;
         }
@@ -173,11 +174,11 @@ int main(int argc, char* argv[])
                 CollectedFeature mycf = ai.evalWithCollectingFeature(
                     mode, RefPlan(myThoughtResult.plan), currentField, frameId, MayahAI::DEFAULT_NUM_ITERATION,
                     ai.myPlayerState(), ai.enemyPlayerState(), preEvalResult, myThoughtResult.midEvalResult,
-                    ai.gazer().gazeResult());
+                    ai.gazeResult());
                 CollectedFeature aicf = ai.evalWithCollectingFeature(
                     mode, RefPlan(aiThoughtResult.plan), currentField, frameId, MayahAI::DEFAULT_NUM_ITERATION,
                     ai.myPlayerState(), ai.enemyPlayerState(), preEvalResult, aiThoughtResult.midEvalResult,
-                    ai.gazer().gazeResult());
+                    ai.gazeResult());
 
                 CoreField myTargetField(myThoughtResult.plan.field());
                 myTargetField.dropPuyoList(mycf.rensaKeyPuyos());
@@ -193,8 +194,8 @@ int main(int argc, char* argv[])
                     { seqToShow, seqToShow, KumipuyoSeq(), KumipuyoSeq() });
 
                 cout << mycf.toStringComparingWith(aicf, ai.evaluationParameter(mode)) << endl;
-                cout << "MY: " << myThoughtResult.message << endl;
-                cout << "AI: " << aiThoughtResult.message << endl;
+                cout << "MY: " << myThoughtResult.message() << endl;
+                cout << "AI: " << aiThoughtResult.message() << endl;
             }
         }
 
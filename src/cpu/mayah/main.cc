@@ -5,11 +5,18 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "base/phase_profiler.h"
 #include "core/algorithm/puyo_possibility.h"
+#ifdef USE_HTTPD
+#include "core/httpd/http_server.h"
+#endif
 
 using namespace std;
 
 DECLARE_int32(num_threads);
+#ifdef USE_HTTPD
+DEFINE_int32(phase_profile_port, 0, "serve the phase profile at /phases on this port if positive");
+#endif
 
 int main(int argc, char* argv[])
 {
@@ -21,6 +28,17 @@ int main(int argc, char* argv[])
 
     LOG(INFO) << "num_threads = " << FLAGS_num_threads;
 
+#ifdef USE_HTTPD
+    unique_ptr<HttpServer> httpServer;
+    if (FLAGS_phase_profile_port > 0) {
+        httpServer.reset(new HttpServer(FLAGS_phase_profile_port));
+        httpServer->installHandler("/phases", [](const HttpRequest*, HttpResponse* res) {
+            res->setContent(PhaseProfiler::toString());
+        });
+        CHECK(httpServer->start());
+    }
+#endif
+
     if (FLAGS_num_threads > 1) {
         unique_ptr<Executor> executor = Executor::makeDefaultExecutor();
         MayahAI(argc, argv, executor.get()).runLoop();
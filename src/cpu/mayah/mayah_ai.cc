@@ -1,11 +1,15 @@
 #include "mayah_ai.h"
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
 
 #include <gflags/gflags.h>
 
+#include "base/phase_profiler.h"
 #include "base/time.h"
 #include "base/wait_group.h"
 #include "core/algorithm/plan.h"
@@ -20,14 +24,34 @@ DEFINE_string(feature, SRC_DIR "/cpu/mayah/feature.toml", "the path to feature p
 DEFINE_string(decision_book, SRC_DIR "/cpu/mayah/decision.toml", "the path to decision book");
 DEFINE_string(pattern_book, SRC_DIR "/cpu/mayah/pattern.toml", "the path to pattern book");
 DEFINE_bool(use_advanced_next, false, "Use enemy's NEXT sequence also");
+DEFINE_bool(ponder, true, "think the next hand in advance while idle");
+DEFINE_bool(async_gaze, true, "gaze the enemy field in background not to consume the think budget. Only used in runLoop().");
+DEFINE_bool(sample_unknown_kumipuyos, false,
+            "search one hand deeper than the known kumipuyos by sampling them, when the think budget remains");
 
 using namespace std;
 
+namespace {
+
+const int PHASE_THINK_PLAN = PhaseProfiler::registerPhase("mayah.thinkPlan");
+const int PHASE_PRE_EVAL = PhaseProfiler::registerPhase("mayah.preEval");
+const int PHASE_MID_EVAL = PhaseProfiler::registerPhase("mayah.midEval");
+const int PHASE_EVAL = PhaseProfiler::registerPhase("mayah.eval");
+const int PHASE_MAKE_MESSAGE = PhaseProfiler::registerPhase("mayah.makeMessageFrom");
+
+}
+
+// deepeningSteps() binds them to references.
+const int MayahAI::DEFAULT_DEPTH;
+const int MayahAI::DEFAULT_NUM_ITERATION;
+const int MayahAI::FAST_NUM_ITERATION;
+
 MayahAI::MayahAI(int argc, char* argv[], Executor* executor) :
     AI(argc, argv, "mayah"),
     executor_(executor)
 {
     setBehaviorRethinkAfterOpponentRensa(true);
+    setBehaviorPonder(FLAGS_ponder);
 
     loadEvaluationParameter();
     CHECK(decisionBook_.load(FLAGS_decision_book));
@@ -55,36 +79,84 @@ bool MayahAI::loadEvaluationParameter()
 DropDecision MayahAI::think(int frameId, const CoreField& f, const KumipuyoSeq& kumipuyoSeq,
                             const PlayerState& me, const PlayerState& enemy, bool fast) const
 {
-    int depth;
-    int iteration;
-    if (fast) {
-      depth = MayahAI::DEFAULT_DEPTH;
-      iteration = MayahAI::FAST_NUM_ITERATION;
-    } else if (FLAGS_use_advanced_next) {
-        if (kumipuyoSeq.size() >= 3) {
-            depth = 3;
-            iteration = 2;
-        } else {
-            depth = MayahAI::DEFAULT_DEPTH;
-            iteration = MayahAI::DEFAULT_NUM_ITERATION;
+    pair<int, int> step = baseStep(kumipuyoSeq, fast);
+    ThoughtResult thoughtResult = thinkPlan(frameId, f, kumipuyoSeq, me, enemy, step.first, step.second);
+
+    const Plan& plan = thoughtResult.plan;
+    if (plan.decisions().empty())
+        return DropDecision(Decision(3, 0), thoughtResult.messageMaker);
+    return DropDecision(plan.decisions().front(), thoughtResult.messageMaker);
+}
+
+DropDecision MayahAI::thinkWithDeadline(int frameId, const CoreField& f, const KumipuyoSeq& kumipuyoSeq,
+                                        const PlayerState& me, const PlayerState& enemy, bool fast,
+                                        const Deadline& deadline) const
+{
+    ThoughtResult thoughtResult;
+    bool hasResult = false;
+    Deadline::Clock::duration lastDuration = Deadline::Clock::duration::zero();
+    for (const auto& step : deepeningSteps(kumipuyoSeq, fast)) {
+        // The next step takes longer than the previous one. Don't start it if it cannot finish.
+        if (hasResult && deadline.remaining() < lastDuration)
+            break;
+
+        Deadline::Clock::time_point begin = Deadline::Clock::now();
+        ThoughtResult tr = thinkPlan(frameId, f, kumipuyoSeq, me, enemy, step.first, step.second, nullptr, deadline);
+        lastDuration = Deadline::Clock::now() - begin;
+
+        // A partial result is used only when we don't have any other result.
+        if (!tr.timedOut || !hasResult) {
+            thoughtResult = tr;
+            hasResult = true;
         }
-    } else {
-        depth = MayahAI::DEFAULT_DEPTH;
-        iteration = MayahAI::DEFAULT_NUM_ITERATION;
+        if (tr.timedOut)
+            break;
     }
 
-    ThoughtResult thoughtResult = thinkPlan(frameId, f, kumipuyoSeq, me, enemy, depth, iteration);
-
     const Plan& plan = thoughtResult.plan;
     if (plan.decisions().empty())
-        return DropDecision(Decision(3, 0), thoughtResult.message);
-    return DropDecision(plan.decisions().front(), thoughtResult.message);
+        return DropDecision(Decision(3, 0), thoughtResult.messageMaker);
+    return DropDecision(plan.decisions().front(), thoughtResult.messageMaker);
+}
+
+// static
+pair<int, int> MayahAI::baseStep(const KumipuyoSeq& kumipuyoSeq, bool fast)
+{
+    if (fast)
+        return make_pair(DEFAULT_DEPTH, FAST_NUM_ITERATION);
+    if (FLAGS_use_advanced_next && kumipuyoSeq.size() >= 3)
+        return make_pair(3, 2);
+    return make_pair(DEFAULT_DEPTH, DEFAULT_NUM_ITERATION);
+}
+
+// static
+vector<pair<int, int>> MayahAI::deepeningSteps(const KumipuyoSeq& kumipuyoSeq, bool fast)
+{
+    const pair<int, int> base = baseStep(kumipuyoSeq, fast);
+
+    // The cheapest step first, so that we have some decision even on a slow machine.
+    vector<pair<int, int>> steps;
+    if (base != make_pair(DEFAULT_DEPTH, FAST_NUM_ITERATION))
+        steps.emplace_back(DEFAULT_DEPTH, FAST_NUM_ITERATION);
+    steps.push_back(base);
+
+    // Then go beyond think() while the time remains.
+    // One more iteration is cheaper than one more depth, which multiplies the plans by 22.
+    steps.emplace_back(base.first, base.second + 1);
+    // Without the known kumipuyo, one more depth multiplies the plans by 220, which never finishes
+    // in time unless the unknown kumipuyos are sampled.
+    if (kumipuyoSeq.size() > base.first || FLAGS_sample_unknown_kumipuyos)
+        steps.emplace_back(base.first + 1, base.second);
+
+    return steps;
 }
 
 ThoughtResult MayahAI::thinkPlan(int frameId, const CoreField& field, const KumipuyoSeq& kumipuyoSeq,
                                  const PlayerState& me, const PlayerState& enemy,
-                                 int depth, int maxIteration, vector<Decision>* specifiedDecisions) const
+                                 int depth, int maxIteration, vector<Decision>* specifiedDecisions,
+                                 const Deadline& deadline) const
 {
+    ScopedPhaseTimer phaseTimer(PHASE_THINK_PLAN);
     double beginTime = currentTime();
 
     EvaluationMode mode = calculateMode(me, enemy);
@@ -97,7 +169,7 @@ ThoughtResult MayahAI::thinkPlan(int frameId, const CoreField& field, const Kumi
                 << "my ojama: fixed = " << me.fixedOjama << " pending = " << me.pendingOjama << endl
                 << "enemy ojama: fixed = " << enemy.fixedOjama << " pending = " << enemy.pendingOjama << endl
                 << "enemy rensa: ending = " << (enemy.isRensaOngoing ? enemy.finishingRensaFrameId : 0) << endl
-                << gazer_.gazeResult().toRensaInfoString()
+                << gazeResult().toRensaInfoString()
                 << "----------------------------------------------------------------------" << endl;
     }
 
@@ -109,16 +181,21 @@ ThoughtResult MayahAI::thinkPlan(int frameId, const CoreField& field, const Kumi
             vector<Decision> decisions { d };
 
             ThoughtResult tr(Plan(cf, decisions, RensaResult(), 0, 0, 0),
-                             0.0, 0.0, MidEvalResult(), "BY DECISION BOOK");
+                             0.0, 0.0, MidEvalResult(), []() { return string("BY DECISION BOOK"); });
             return tr;
         }
     }
 
-    const GazeResult gazeResult = gazer_.gazeResult();
+    const GazeResult gazeResult = this->gazeResult();
 
     // Before evaling, check Book.
     const PreEvalResult preEvalResult = preEval(field);
 
+    if (FLAGS_sample_unknown_kumipuyos && depth > static_cast<int>(kumipuyoSeq.size()) && !specifiedDecisions) {
+        return thinkPlanWithSampling(frameId, field, kumipuyoSeq, me, enemy, depth, maxIteration,
+                                     mode, preEvalResult, gazeResult, beginTime, deadline);
+    }
+
     Plan bestPlan;
     double bestScore = -100000000.0;
     MidEvalResult bestMidEvalResult;
@@ -210,35 +287,96 @@ ThoughtResult MayahAI::thinkPlan(int frameId, const CoreField& field, const Kumi
 
         if (executor_) {
             wg.add(1);
-            executor_->submit([p, seq, depth, f, &wg]() {
-                Plan::iterateAvailablePlans(p.field(), seq, depth - 1, f);
+            executor_->submit([p, seq, depth, f, &deadline, &wg]() {
+                Plan::iterateAvailablePlans(p.field(), seq, depth - 1, f, deadline);
                 wg.done();
             });
         } else {
-            Plan::iterateAvailablePlans(p.field(), seq, depth - 1, f);
+            Plan::iterateAvailablePlans(p.field(), seq, depth - 1, f, deadline);
         }
     };
 
-    Plan::iterateAvailablePlans(field, kumipuyoSeq, 1, evalAfterOne);
+    Plan::iterateAvailablePlans(field, kumipuyoSeq, 1, evalAfterOne, deadline);
     if (executor_)
         wg.waitUntilDone();
+    bool timedOut = deadline.hasPassed();
 
     double endTime = currentTime();
-    if (bestVirtualRensaScore < bestRensaScore) {
-        std::string message = makeMessageFrom(mode, frameId, field, kumipuyoSeq, maxIteration,
-                                              me, enemy,
-                                              preEvalResult, bestRensaMidEvalResult, gazeResult,
-                                              bestRensaPlan, bestRensaScore, bestVirtualRensaScore,
-                                              true, endTime - beginTime);
-        return ThoughtResult(bestRensaPlan, bestRensaScore, bestVirtualRensaScore, bestRensaMidEvalResult, message);
-    } else {
-        std::string message = makeMessageFrom(mode, frameId, field, kumipuyoSeq, maxIteration,
-                                              me, enemy,
-                                              preEvalResult, bestMidEvalResult, gazeResult,
-                                              bestPlan, bestRensaScore, bestVirtualRensaScore,
-                                              false, endTime - beginTime);
-        return ThoughtResult(bestPlan, bestRensaScore, bestVirtualRensaScore, bestMidEvalResult, message);
+
+    // The message is made lazily, since most of the results are not sent
+    // (e.g. the pondered ones, or the shallower ones in thinkWithDeadline).
+    // The states are captured by value, since it's made after this returns and the states
+    // of the AI might have changed. Only the books and the parameters are read via |this|.
+    bool saturated = bestVirtualRensaScore < bestRensaScore;
+    const Plan& plan = saturated ? bestRensaPlan : bestPlan;
+    const MidEvalResult& midEvalResult = saturated ? bestRensaMidEvalResult : bestMidEvalResult;
+    auto messageMaker = [this, mode, frameId, field, kumipuyoSeq, maxIteration, me, enemy,
+                         preEvalResult, midEvalResult, gazeResult, plan,
+                         bestRensaScore, bestVirtualRensaScore, saturated, beginTime, endTime]() {
+        return makeMessageFrom(mode, frameId, field, kumipuyoSeq, maxIteration,
+                               me, enemy,
+                               preEvalResult, midEvalResult, gazeResult,
+                               plan, bestRensaScore, bestVirtualRensaScore,
+                               saturated, endTime - beginTime);
+    };
+
+    ThoughtResult tr(plan, bestRensaScore, bestVirtualRensaScore, midEvalResult, messageMaker);
+    tr.timedOut = timedOut;
+    return tr;
+}
+
+ThoughtResult MayahAI::thinkPlanWithSampling(int frameId, const CoreField& field, const KumipuyoSeq& kumipuyoSeq,
+                                             const PlayerState& me, const PlayerState& enemy,
+                                             int depth, int maxIteration,
+                                             EvaluationMode mode, const PreEvalResult& preEvalResult,
+                                             const GazeResult& gazeResult, double beginTime,
+                                             const Deadline& deadline) const
+{
+    // Like thinkPlan(), the plans are evaluated with the MidEvalResult after the first hand.
+    map<Decision, MidEvalResult> midEvalResults;
+    Plan::iterateAvailablePlans(field, kumipuyoSeq, 1, [&](const RefPlan& rp1) {
+        midEvalResults[rp1.decisions().front()] =
+            midEval(mode, rp1, field, frameId, maxIteration, me, enemy, preEvalResult, gazeResult);
+    });
+
+    auto evaluate = [&](const RefPlan& plan) {
+        MidEvalResult midEvalResult;
+        if (plan.decisions().size() > 1) {
+            auto it = midEvalResults.find(plan.decisions().front());
+            if (it != midEvalResults.end())
+                midEvalResult = it->second;
+        }
+        return eval(mode, plan, field, frameId, maxIteration, me, enemy, preEvalResult, midEvalResult, gazeResult).score();
+    };
+
+    Decision decision;
+    Plan::searchExpectedBestPlan(field, kumipuyoSeq, depth, Plan::SamplingStrategy(), evaluate, &decision, deadline);
+    bool timedOut = deadline.hasPassed();
+
+    // Only the first hand is decided. The rest depends on the kumipuyos to come.
+    Plan plan;
+    MidEvalResult midEvalResult;
+    if (decision.isValid()) {
+        CoreField cf(field);
+        cf.dropKumipuyo(decision, kumipuyoSeq.front());
+        RensaResult rensaResult = cf.simulate();
+        plan = Plan(cf, vector<Decision> { decision }, rensaResult, field.isChigiriDecision(decision) ? 1 : 0,
+                    0, field.framesToDropNext(decision));
+        midEvalResult = midEvalResults[decision];
     }
+
+    double endTime = currentTime();
+    auto messageMaker = [this, mode, frameId, field, kumipuyoSeq, maxIteration, me, enemy,
+                         preEvalResult, midEvalResult, gazeResult, plan, beginTime, endTime]() {
+        return makeMessageFrom(mode, frameId, field, kumipuyoSeq, maxIteration,
+                               me, enemy,
+                               preEvalResult, midEvalResult, gazeResult,
+                               plan, plan.score(), 0, false, endTime - beginTime);
+    };
+
+    ThoughtResult tr(plan, plan.score(), 0, midEvalResult, messageMaker);
+    tr.timedOut = timedOut;
+    return tr;
 }
 
 EvaluationMode MayahAI::calculateMode(const PlayerState& me, const PlayerState& enemy) const
@@ -262,6 +400,7 @@ EvaluationMode MayahAI::calculateMode(const PlayerState& me, const PlayerState&
 
 PreEvalResult MayahAI::preEval(const CoreField& currentField) const
 {
+    ScopedPhaseTimer phaseTimer(PHASE_PRE_EVAL);
     PreEvaluator preEvaluator(patternBook_);
     return preEvaluator.preEval(currentField);
 }
@@ -274,6 +413,7 @@ MidEvalResult MayahAI::midEval(EvaluationMode mode, const RefPlan& plan, const C
                                const GazeResult& gazeResult) const
 
 {
+    ScopedPhaseTimer phaseTimer(PHASE_MID_EVAL);
     NormalScoreCollector sc(evaluationParameterMap_.parameter(mode));
     Evaluator<NormalScoreCollector> evaluator(patternBook_, &sc);
     evaluator.collectScore(plan, currentField, currentFrameId, maxIteration, me, enemy, preEvalResult, MidEvalResult(), gazeResult);
@@ -289,6 +429,7 @@ EvalResult MayahAI::eval(EvaluationMode mode, const RefPlan& plan, const CoreFie
                          const MidEvalResult& midEvalResult,
                          const GazeResult& gazeResult) const
 {
+    ScopedPhaseTimer phaseTimer(PHASE_EVAL);
     NormalScoreCollector sc(evaluationParameterMap_.parameter(mode));
     Evaluator<NormalScoreCollector> evaluator(patternBook_, &sc);
     evaluator.collectScore(plan, currentField, currentFrameId, maxIteration, me, enemy, preEvalResult, midEvalResult, gazeResult);
@@ -320,6 +461,7 @@ std::string MayahAI::makeMessageFrom(EvaluationMode mode,
                                      bool saturated, double thoughtTimeInSeconds) const
 {
     UNUSED_VARIABLE(kumipuyoSeq);
+    ScopedPhaseTimer phaseTimer(PHASE_MAKE_MESSAGE);
 
     if (plan.decisions().empty())
         return string("give up :-(");
@@ -384,8 +526,8 @@ std::string MayahAI::makeMessageFrom(EvaluationMode mode,
            << " in " << (refPlan.totalFrames() + 200) << " / ";
     }
 
-    ss << "O = " << (myPlayerState().fixedOjama + myPlayerState().pendingOjama)
-       << "/" << (enemyPlayerState().fixedOjama + enemyPlayerState().pendingOjama) << " / ";
+    ss << "O = " << (me.fixedOjama + me.pendingOjama)
+       << "/" << (enemy.fixedOjama + enemy.pendingOjama) << " / ";
 
     ss << (thoughtTimeInSeconds * 1000) << " [ms]";
 
@@ -400,6 +542,24 @@ void MayahAI::onGameWillBegin(const FrameRequest& frameRequest)
 void MayahAI::gaze(int frameId, const CoreField& enemyField, const KumipuyoSeq& kumipuyoSeq)
 {
     gazer_.gaze(frameId, enemyField, kumipuyoSeq);
+    // Outside runLoop(), think() is called just after gaze(), and its result must not depend on
+    // whether the background gaze has finished.
+    if (!FLAGS_async_gaze || !isInRunLoop())
+        gazer_.waitUntilIdle();
+}
+
+void MayahAI::onGameHasEnded(const FrameRequest&)
+{
+    if (!PhaseProfiler::isEnabled())
+        return;
+
+    LOG(INFO) << "phase profile:\n" << PhaseProfiler::toString();
+    PhaseProfiler::dumpToFile();
+}
+
+GazeResult MayahAI::gazeResult() const
+{
+    return gazer_.gazeResult();
 }
 
 void DebuggableMayahAI::setEvaluationParameterMap(const EvaluationParameterMap& map)
@@ -3,12 +3,15 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/executor.h"
 #include "core/client/ai/ai.h"
+#include "core/client/ai/drop_decision.h"
 #include "core/algorithm/plan.h"
 
+#include "async_gazer.h"
 #include "decision_book.h"
 #include "evaluation_parameter.h"
 #include "evaluator.h"
@@ -16,23 +19,28 @@
 #include "pattern_book.h"
 
 class CoreField;
-class DropDecision;
 class KumipuyoSeq;
 
 struct ThoughtResult {
     ThoughtResult() {}
     ThoughtResult(const Plan& plan, double rensaScore, double virtualRensaScore,
-                  const MidEvalResult& midEvalResult, const std::string& message) :
+                  const MidEvalResult& midEvalResult, DropDecision::MessageMaker messageMaker) :
         plan(plan), rensaScore(rensaScore), virtualRensaScore(virtualRensaScore),
-        midEvalResult(midEvalResult), message(message)
+        midEvalResult(midEvalResult), messageMaker(std::move(messageMaker))
     {
     }
 
+    // Makes the human-readable message. This re-evaluates the plan, so it's
+    // not cheap. Pass |messageMaker| to DropDecision to make it only when needed.
+    std::string message() const { return messageMaker ? messageMaker() : std::string(); }
+
     Plan plan;
     double rensaScore;
     double virtualRensaScore;
     MidEvalResult midEvalResult;
-    std::string message;
+    DropDecision::MessageMaker messageMaker;
+    // True if the deadline has passed before all the plans are evaluated.
+    bool timedOut = false;
 };
 
 class MayahAI : public AI {
@@ -46,19 +54,41 @@ public:
 
     virtual DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
                                const PlayerState& me, const PlayerState& enemy, bool fast) const override;
+    // Deepens the search while the time budget remains. Keeps the best decision so far.
+    virtual DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                           const PlayerState& me, const PlayerState& enemy, bool fast,
+                                           const Deadline&) const override;
 
     virtual void gaze(int frameId, const CoreField& enemyField, const KumipuyoSeq&) override;
 
     virtual void onGameWillBegin(const FrameRequest&) override;
+    // Dumps the phase profile when --phase_profile is set.
+    virtual void onGameHasEnded(const FrameRequest&) override;
 
     // Use this directly in test. Otherwise, use via think.
     // When |specifiedDecisionsOnly| is specified, only that decision will be considered.
+    // When |deadline| has passed, the best plan found so far is returned with timedOut.
     ThoughtResult thinkPlan(int frameId, const CoreField&, const KumipuyoSeq&,
                             const PlayerState& me, const PlayerState& enemy,
                             int depth, int maxIteration,
-                            std::vector<Decision>* specifiedDecisions = nullptr) const;
+                            std::vector<Decision>* specifiedDecisions = nullptr,
+                            const Deadline& deadline = Deadline()) const;
 
 protected:
+    // Same as thinkPlan(), but the kumipuyos after |kumipuyoSeq| are sampled, and
+    // the first decision is chosen by the expected score. See Plan::searchExpectedBestPlan().
+    ThoughtResult thinkPlanWithSampling(int frameId, const CoreField&, const KumipuyoSeq&,
+                                        const PlayerState& me, const PlayerState& enemy,
+                                        int depth, int maxIteration,
+                                        EvaluationMode, const PreEvalResult&, const GazeResult&,
+                                        double beginTime, const Deadline&) const;
+
+    // The (depth, iteration) used by think().
+    static std::pair<int, int> baseStep(const KumipuyoSeq&, bool fast);
+    // The (depth, iteration) steps searched by thinkWithDeadline() in the order of the cost.
+    // They go beyond baseStep() when the time remains.
+    static std::vector<std::pair<int, int>> deepeningSteps(const KumipuyoSeq&, bool fast);
+
     EvaluationMode calculateMode(const PlayerState& me, const PlayerState& enemy) const;
 
     PreEvalResult preEval(const CoreField& currentField) const;
@@ -82,6 +112,10 @@ protected:
                                 bool saturated,
                                 double thoughtTimeInSeconds) const;
 
+    // Returns the latest finished result. Gazing runs in background in runLoop() unless
+    // --async_gaze=false, so this might not reflect the latest gaze() yet there.
+    GazeResult gazeResult() const;
+
     bool saveEvaluationParameter() const;
     bool loadEvaluationParameter();
 
@@ -93,7 +127,7 @@ protected:
 
     Executor* executor_;
 
-    Gazer gazer_;
+    AsyncGazer gazer_;
 };
 
 class DebuggableMayahAI : public MayahAI {
@@ -118,11 +152,13 @@ public:
     using MayahAI::evalWithCollectingFeature;
 
     using MayahAI::calculateMode;
+    using MayahAI::deepeningSteps;
 
     using MayahAI::mutableMyPlayerState;
     using MayahAI::mutableEnemyPlayerState;
 
-    const Gazer& gazer() const { return gazer_; }
+    using MayahAI::gazeResult;
+    void waitUntilGazed() { gazer_.waitUntilIdle(); }
 
     void removeNontokopuyoParameter() { evaluationParameterMap_.removeNontokopuyoParameter(); }
     const EvaluationParameterMap& evaluationParameterMap() const { return evaluationParameterMap_; }
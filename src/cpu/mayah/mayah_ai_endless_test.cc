@@ -0,0 +1,53 @@
+#include "mayah_ai.h"
+
+#include <memory>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "core/algorithm/puyo_possibility.h"
+#include "core/kumipuyo_seq.h"
+#include "core/sequence_generator.h"
+#include "solver/endless.h"
+
+using namespace std;
+
+DECLARE_bool(async_gaze);
+
+static EndlessResult runEndless(const KumipuyoSeq& seq)
+{
+    int argc = 1;
+    char arg[] = "mayah";
+    char* argv[] = {arg};
+    Endless endless(unique_ptr<AI>(new DebuggableMayahAI(argc, argv)));
+    return endless.run(seq);
+}
+
+// Outside runLoop(), think() should not depend on whether the background gaze has finished,
+// so that Endless (and so tweaker, Race, CMA-ES) is reproducible.
+TEST(MayahAIEndlessTest, reproducibleWithAsyncGaze)
+{
+    FLAGS_async_gaze = true;
+
+    KumipuyoSeq seq = generateRandomSequenceWithSeed(1);
+    EndlessResult result = runEndless(seq);
+    EndlessResult result2 = runEndless(seq);
+
+    EXPECT_EQ(result.type, result2.type);
+    EXPECT_EQ(result.hand, result2.hand);
+    EXPECT_EQ(result.score, result2.score);
+    EXPECT_EQ(result.maxRensa, result2.maxRensa);
+    EXPECT_EQ(result.decisions, result2.decisions);
+}
+
+int main(int argc, char* argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    testing::InitGoogleTest(&argc, argv);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    TsumoPossibility::initialize();
+
+    return RUN_ALL_TESTS();
+}
@@ -228,6 +228,46 @@ TEST(MayahAIPerformanceTest, slow_pattern_from_real_5)
     runTest(3, 2, f, seq);
 }
 
+// thinkPlan used to make the message eagerly. This shows how much a think
+// saves by making it only after the decision is sent.
+void runMessageTest(const CoreField& cf, const KumipuyoSeq& kumipuyoSeq)
+{
+    TimeStampCounterData thinkTsc;
+    TimeStampCounterData messageTsc;
+
+    unique_ptr<Executor> executor(Executor::makeDefaultExecutor());
+    unique_ptr<MayahAI> ai(makeAI(executor.get()));
+    int frameId = 1;
+
+    for (int i = 0; i < 10; ++i) {
+        ThoughtResult thoughtResult;
+        {
+            ScopedTimeStampCounter stsc(&thinkTsc);
+            thoughtResult = ai->thinkPlan(frameId, cf, kumipuyoSeq, PlayerState(), PlayerState(),
+                                          MayahAI::DEFAULT_DEPTH, MayahAI::FAST_NUM_ITERATION);
+        }
+        {
+            ScopedTimeStampCounter stsc(&messageTsc);
+            (void)thoughtResult.message();
+        }
+    }
+
+    cout << "thinkPlan without message:" << endl;
+    thinkTsc.showStatistics();
+    cout << "message (saved per think):" << endl;
+    messageTsc.showStatistics();
+}
+
+TEST(MayahAIPerformanceTest, message)
+{
+    runMessageTest(CoreField(), defaultKumipuyoSeq(2));
+}
+
+TEST(MayahAIPerformanceTest, message_fulfilled)
+{
+    runMessageTest(fulfilledField(), defaultKumipuyoSeq(2));
+}
+
 int main(int argc, char* argv[])
 {
     google::InitGoogleLogging(argv[0]);
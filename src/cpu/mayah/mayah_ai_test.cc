@@ -11,6 +11,9 @@
 
 using namespace std;
 
+DECLARE_bool(async_gaze);
+DECLARE_bool(sample_unknown_kumipuyos);
+
 static unique_ptr<DebuggableMayahAI> makeAI(Executor* executor = nullptr)
 {
     int argc = 1;
@@ -277,6 +280,71 @@ TEST(MayahAITest, setEvaluationParameter)
     EXPECT_EQ(1.0, ai->evaluationParameter(EvaluationMode::EARLY).getValue(SCORE));
 }
 
+TEST(MayahAITest, deepeningStepsGoBeyondThink)
+{
+    KumipuyoSeq seq("RRBBYY");
+
+    // think(fast=true) uses (2, 1).
+    vector<pair<int, int>> fastSteps = DebuggableMayahAI::deepeningSteps(seq, true);
+    ASSERT_LE(2U, fastSteps.size());
+    EXPECT_EQ(make_pair(2, 1), fastSteps[0]);
+    EXPECT_EQ(make_pair(2, 2), fastSteps[1]);
+
+    // think(fast=false) uses (2, 3). It's searched after the cheapest one, and deeper ones follow.
+    vector<pair<int, int>> steps = DebuggableMayahAI::deepeningSteps(seq, false);
+    ASSERT_LE(3U, steps.size());
+    EXPECT_EQ(make_pair(2, 1), steps[0]);
+    EXPECT_EQ(make_pair(2, 3), steps[1]);
+    EXPECT_EQ(make_pair(3, 3), steps.back());
+
+    // Without the 3rd kumipuyo, the depth is not increased.
+    for (const auto& step : DebuggableMayahAI::deepeningSteps(KumipuyoSeq("RRBB"), false))
+        EXPECT_GE(2, step.first);
+}
+
+TEST(MayahAITest, sampleUnknownKumipuyos)
+{
+    FLAGS_sample_unknown_kumipuyos = true;
+
+    // The 3rd kumipuyo is unknown, so it's sampled.
+    EXPECT_EQ(make_pair(3, 3), DebuggableMayahAI::deepeningSteps(KumipuyoSeq("RRBB"), false).back());
+
+    auto ai = makeAI();
+    ThoughtResult thoughtResult = ai->thinkPlan(2, CoreField(), KumipuyoSeq("RRBB"), PlayerState(), PlayerState(), 3, 1);
+
+    // Only the first decision is decided.
+    ASSERT_EQ(1U, thoughtResult.plan.decisions().size());
+    EXPECT_TRUE(thoughtResult.plan.decisions().front().isValid());
+
+    FLAGS_sample_unknown_kumipuyos = false;
+}
+
+// Outside runLoop(), think() is called just after gaze(), so gaze() should finish before returning.
+TEST(MayahAITest, gazeIsSynchronousOutsideRunLoop)
+{
+    FLAGS_async_gaze = true;
+
+    CoreField enemyField(
+        "RG    "
+        "GY    "
+        "GG    "
+        "YR    "
+        "GRG   "
+        "GRB   "
+        "RGY  B"
+        "RBR YR"
+        "BRG RB"
+        "RRYYRR");
+
+    auto ai = makeAI();
+    FrameRequest req;
+    req.frameId = 1;
+    ai->gameWillBegin(req);
+
+    ai->gaze(1148, enemyField, KumipuyoSeq("YRGRBG"));
+    EXPECT_EQ(1148, ai->gazeResult().frameIdGazedAt());
+}
+
 int main(int argc, char* argv[])
 {
     google::InitGoogleLogging(argv[0]);
@@ -25,8 +25,8 @@ void PatternRensaDetector::iteratePossibleRensas(const vector<int>& matchableIds
         if (complementResult.numFilledUnusedVariables > 0)
             continue;
 
-        // No ignition puyo.
-        if (cpl.sizeOn(pbf.ignitionColumn()) == 0)
+        // No ignition puyo. ignitionColumn() is 0 when the pattern doesn't specify it.
+        if (pbf.ignitionColumn() == 0 || cpl.sizeOn(pbf.ignitionColumn()) == 0)
             continue;
 
         CoreField cf(originalField_);
@@ -0,0 +1,131 @@
+#include "race.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "base/wait_group.h"
+
+using namespace std;
+
+Race::Race(int numCandidates, const Option& option) :
+    option_(option),
+    scores_(numCandidates, vector<double>(option.numCases)),
+    known_(numCandidates),
+    alive_(numCandidates, true),
+    numEvaluatedCases_(numCandidates)
+{
+    CHECK_GT(option.batchSize, 0);
+}
+
+void Race::setKnownScores(int candidate, const vector<double>& scores)
+{
+    CHECK_EQ(static_cast<size_t>(option_.numCases), scores.size());
+    scores_[candidate] = scores;
+    known_[candidate] = true;
+}
+
+void Race::run(Executor* executor, const EvaluationCallback& callback, const BatchCallback& batchCallback)
+{
+    for (int begin = 0; begin < option_.numCases; begin += option_.batchSize) {
+        int end = std::min(begin + option_.batchSize, option_.numCases);
+
+        WaitGroup wg;
+        for (int c = 0; c < numCandidates(); ++c) {
+            if (!alive_[c])
+                continue;
+            numEvaluatedCases_[c] = end;
+            if (known_[c])
+                continue;
+
+            for (int i = begin; i < end; ++i) {
+                ++numEvaluations_;
+                if (!executor) {
+                    scores_[c][i] = callback(c, i);
+                    continue;
+                }
+
+                wg.add(1);
+                executor->submit([this, &callback, &wg, c, i]() {
+                    scores_[c][i] = callback(c, i);
+                    wg.done();
+                });
+            }
+        }
+        wg.waitUntilDone();
+
+        eliminate(end);
+        if (batchCallback)
+            batchCallback(end);
+    }
+}
+
+double Race::sumScore(int candidate) const
+{
+    double sum = 0;
+    for (int i = 0; i < numEvaluatedCases_[candidate]; ++i)
+        sum += scores_[candidate][i];
+    return sum;
+}
+
+int Race::best() const
+{
+    int best = -1;
+    for (int c = 0; c < numCandidates(); ++c) {
+        if (!alive_[c] || numEvaluatedCases_[c] == 0)
+            continue;
+        if (best < 0 || sumScore(best) < sumScore(c))
+            best = c;
+    }
+    return best;
+}
+
+// static
+double Race::pairedTValue(const vector<double>& lhs, const vector<double>& rhs, int n)
+{
+    DCHECK_LE(static_cast<size_t>(n), lhs.size());
+    DCHECK_LE(static_cast<size_t>(n), rhs.size());
+    if (n == 0)
+        return 0;
+
+    double sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += lhs[i] - rhs[i];
+    double mean = sum / n;
+
+    double variance = 0;
+    for (int i = 0; i < n; ++i) {
+        double d = lhs[i] - rhs[i] - mean;
+        variance += d * d;
+    }
+    variance = n >= 2 ? variance / (n - 1) : 0;
+
+    if (variance == 0) {
+        if (mean == 0)
+            return 0;
+        return mean > 0 ? numeric_limits<double>::infinity() : -numeric_limits<double>::infinity();
+    }
+
+    return mean / sqrt(variance / n);
+}
+
+void Race::eliminate(int numCases)
+{
+    if (!option_.eliminates || numCases < option_.minCases)
+        return;
+
+    // All the alive candidates have the same number of evaluated cases here.
+    int leader = best();
+    if (leader < 0)
+        return;
+
+    for (int c = 0; c < numCandidates(); ++c) {
+        if (!alive_[c] || c == leader)
+            continue;
+        if (pairedTValue(scores_[c], scores_[leader], numCases) < -option_.threshold)
+            alive_[c] = false;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef CPU_MAYAH_RACE_H_
+#define CPU_MAYAH_RACE_H_
+
+#include <functional>
+#include <vector>
+
+#include "base/noncopyable.h"
+
+class Executor;
+
+// Race evaluates several candidates on the same cases batch by batch, and stops
+// evaluating the candidates which are clearly worse than the leader.
+// After each batch, the scores of a candidate are compared with the leader's
+// on the same cases with a paired t-test.
+class Race : noncopyable {
+public:
+    struct Option {
+        int numCases = 100;
+        int batchSize = 10;
+        // Candidates are not eliminated before this number of cases are evaluated.
+        int minCases = 20;
+        // A candidate is eliminated when the t value of (candidate - leader) is less than -threshold.
+        double threshold = 2.0;
+        // If false, no candidate is eliminated, and all the candidates are evaluated on all the cases.
+        bool eliminates = true;
+    };
+
+    // Returns the score of the |caseIndex|-th case for |candidate|. Higher is better.
+    // This is called concurrently from the threads of the executor.
+    typedef std::function<double (int candidate, int caseIndex)> EvaluationCallback;
+    // Called after each batch with the number of evaluated cases.
+    typedef std::function<void (int numCases)> BatchCallback;
+
+    Race(int numCandidates, const Option&);
+
+    // Sets the scores of |candidate| already known, e.g. of the current best parameter.
+    // |scores| must have |numCases| scores. The candidate won't be evaluated.
+    void setKnownScores(int candidate, const std::vector<double>& scores);
+
+    // Runs the race. All the cases in a batch of all the alive candidates are
+    // evaluated concurrently on |executor|. |batchCallback| can be null.
+    void run(Executor*, const EvaluationCallback&, const BatchCallback& batchCallback = BatchCallback());
+
+    int numCandidates() const { return static_cast<int>(scores_.size()); }
+    bool isAlive(int candidate) const { return alive_[candidate]; }
+    // Returns the number of cases evaluated for |candidate|.
+    int numEvaluatedCases(int candidate) const { return numEvaluatedCases_[candidate]; }
+    int numEvaluations() const { return numEvaluations_; }
+
+    const std::vector<double>& scores(int candidate) const { return scores_[candidate]; }
+    double sumScore(int candidate) const;
+
+    // Returns the alive candidate having the best sum score. Returns -1 if not run yet.
+    int best() const;
+
+    // Returns the t value of the paired differences |lhs[i] - rhs[i]| for i < n.
+    // Returns +-infinity when all the differences are the same non-zero value.
+    static double pairedTValue(const std::vector<double>& lhs, const std::vector<double>& rhs, int n);
+
+private:
+    void eliminate(int numCases);
+
+    Option option_;
+    std::vector<std::vector<double>> scores_;
+    std::vector<bool> known_;
+    std::vector<bool> alive_;
+    std::vector<int> numEvaluatedCases_;
+    int numEvaluations_ = 0;
+};
+
+#endif
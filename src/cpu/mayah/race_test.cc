@@ -0,0 +1,107 @@
+#include "race.h"
+
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+
+using namespace std;
+
+TEST(RaceTest, pairedTValue)
+{
+    vector<double> lhs { 3, 4, 5, 6 };
+    vector<double> rhs { 1, 3, 2, 5 };
+
+    // differences: 2, 1, 3, 1. mean = 1.75, variance = 0.916...
+    EXPECT_NEAR(1.75 / sqrt(2.75 / 3 / 4), Race::pairedTValue(lhs, rhs, 4), 1e-9);
+    EXPECT_EQ(numeric_limits<double>::infinity(), Race::pairedTValue(lhs, rhs, 1));
+    EXPECT_EQ(-numeric_limits<double>::infinity(), Race::pairedTValue(rhs, lhs, 1));
+    EXPECT_EQ(0.0, Race::pairedTValue(lhs, lhs, 4));
+}
+
+TEST(RaceTest, eliminateWorseCandidates)
+{
+    Race::Option option;
+    option.numCases = 100;
+    option.batchSize = 10;
+    option.minCases = 20;
+
+    // Candidate 0 and 2 are clearly worse than candidate 1. The noise is paired.
+    Race race(3, option);
+    race.run(nullptr, [](int candidate, int caseIndex) {
+        double noise = (caseIndex * 37 % 11) * 10;
+        switch (candidate) {
+        case 0: return noise;
+        case 1: return noise + 5 + caseIndex % 2;
+        default: return noise - 5;
+        }
+    });
+
+    EXPECT_FALSE(race.isAlive(0));
+    EXPECT_TRUE(race.isAlive(1));
+    EXPECT_FALSE(race.isAlive(2));
+    EXPECT_EQ(1, race.best());
+
+    // Eliminated after minCases cases.
+    EXPECT_EQ(20, race.numEvaluatedCases(0));
+    EXPECT_EQ(100, race.numEvaluatedCases(1));
+    EXPECT_EQ(140, race.numEvaluations());
+}
+
+TEST(RaceTest, noElimination)
+{
+    Race::Option option;
+    option.numCases = 40;
+    option.eliminates = false;
+
+    // Candidate 0 is clearly worse, but it's evaluated on all the cases.
+    Race race(2, option);
+    race.run(nullptr, [](int candidate, int caseIndex) {
+        return candidate * 100.0 + caseIndex % 3;
+    });
+
+    EXPECT_TRUE(race.isAlive(0));
+    EXPECT_TRUE(race.isAlive(1));
+    EXPECT_EQ(40, race.numEvaluatedCases(0));
+    EXPECT_EQ(80, race.numEvaluations());
+    EXPECT_EQ(1, race.best());
+}
+
+TEST(RaceTest, keepSimilarCandidates)
+{
+    Race::Option option;
+    option.numCases = 40;
+
+    Race race(2, option);
+    race.run(nullptr, [](int candidate, int caseIndex) {
+        return (caseIndex + candidate) % 2 * 100.0;
+    });
+
+    EXPECT_TRUE(race.isAlive(0));
+    EXPECT_TRUE(race.isAlive(1));
+    EXPECT_EQ(40, race.numEvaluatedCases(0));
+    EXPECT_EQ(40, race.numEvaluatedCases(1));
+}
+
+TEST(RaceTest, knownScores)
+{
+    Race::Option option;
+    option.numCases = 30;
+
+    Race race(2, option);
+    race.setKnownScores(0, vector<double>(30, 10.0));
+
+    Executor executor(2);
+    executor.start();
+    race.run(&executor, [](int candidate, int caseIndex) {
+        EXPECT_EQ(1, candidate);
+        return caseIndex % 3 == 0 ? 30.0 : 0.0;
+    });
+
+    // The known candidate is not evaluated.
+    EXPECT_EQ(30, race.numEvaluations());
+    EXPECT_EQ(300.0, race.sumScore(0));
+    EXPECT_EQ(300.0, race.sumScore(1));
+}
@@ -4,7 +4,6 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <future>
 #include <sstream>
 #include <random>
 
@@ -12,28 +11,38 @@
 #include <glog/logging.h>
 
 #include "base/executor.h"
+#include "base/phase_profiler.h"
 #include "core/algorithm/puyo_possibility.h"
 #include "core/sequence_generator.h"
+#include "solver/batch_endless.h"
 #include "solver/endless.h"
 
+#include "cma_es.h"
 #include "evaluation_parameter.h"
+#include "race.h"
 
 DECLARE_string(feature);
 DECLARE_string(seq);
 DECLARE_int32(seed);
+DECLARE_int32(num_threads);
 
 DEFINE_bool(once, false, "true if running only once.");
 DEFINE_int32(auto_count, 0, "run auto tweaker for this count.");
 DEFINE_bool(show_field, false, "show field after each hand.");
 DEFINE_int32(size, 100, "the number of case size.");
 DEFINE_int32(offset, 0, "offset for random seed");
+DEFINE_int32(race_candidates, 4, "the number of tweaked parameters raced at once in auto tweaker.");
+DEFINE_int32(race_batch_size, 10, "the number of cases evaluated for all the candidates before comparison.");
+DEFINE_int32(race_min_cases, 20, "candidates are not dropped before this number of cases are evaluated.");
+DEFINE_double(race_threshold, 2.0, "candidates are dropped when the t value against the best candidate is less than -this.");
 
-using namespace std;
+DEFINE_int32(cmaes_generations, 0, "run CMA-ES for this number of generations.");
+DEFINE_string(cmaes_checkpoint, "cmaes-checkpoint.txt", "CMA-ES state is saved to and resumed from this file.");
+DEFINE_int32(cmaes_lambda, 0, "the population size of CMA-ES. 0 means the default size.");
+DEFINE_double(cmaes_stddev, 10.0, "the initial standard deviation of each parameter in CMA-ES.");
+DEFINE_int32(cmaes_seed, 1, "the random seed of CMA-ES.");
 
-struct Result {
-    EndlessResult result;
-    string msg;
-};
+using namespace std;
 
 struct RunResult {
     int numZenkeshi;
@@ -49,6 +58,16 @@ struct RunResult {
     int resultScore() {
         return mainRensaCount * 20 + over60000Count * 6 + over70000Count + over80000Count;
     }
+
+    // The contribution of one case to resultScore().
+    static int caseScore(const EndlessResult& result)
+    {
+        if (result.zenkeshi && result.hand < 8)
+            return 0;
+
+        int score = result.score;
+        return (score >= 10000) * 20 + (score >= 60000) * 6 + (score >= 70000) + (score >= 80000);
+    }
 };
 
 class ParameterTweaker {
@@ -122,6 +141,68 @@ private:
     vector<EvaluationSparseFeature> tweakableSparseFeatures_;
 };
 
+// Returns the number of the tweakable values, i.e. the dimension for CMA-ES.
+size_t numTweakableValues()
+{
+    size_t n = 0;
+    for (const auto& ef : EvaluationFeature::all()) {
+        if (ef.tweakable())
+            ++n;
+    }
+    for (const auto& ef : EvaluationSparseFeature::all()) {
+        if (ef.tweakable())
+            n += ef.size();
+    }
+    return n;
+}
+
+// Converts the tweakable values of EvaluationParameter to a vector for CMA-ES.
+// A sparse feature is represented as the first value and the differences between
+// the adjacent values, so that changing one element shifts the following values
+// like ParameterTweaker does, keeping the ascending or descending shape.
+vector<double> toVector(const EvaluationParameter& parameter)
+{
+    vector<double> vs;
+    for (const auto& ef : EvaluationFeature::all()) {
+        if (ef.tweakable())
+            vs.push_back(parameter.getValue(ef.key()));
+    }
+
+    for (const auto& ef : EvaluationSparseFeature::all()) {
+        if (!ef.tweakable())
+            continue;
+        const vector<double>& values = parameter.getValues(ef.key());
+        for (size_t i = 0; i < values.size(); ++i)
+            vs.push_back(i == 0 ? values[i] : values[i] - values[i - 1]);
+    }
+
+    return vs;
+}
+
+// Returns false if |vs| doesn't have numTweakableValues() values.
+bool fromVector(const vector<double>& vs, EvaluationParameter* parameter)
+{
+    if (vs.size() != numTweakableValues())
+        return false;
+
+    size_t pos = 0;
+    for (const auto& ef : EvaluationFeature::all()) {
+        if (ef.tweakable())
+            parameter->setValue(ef.key(), vs[pos++]);
+    }
+
+    for (const auto& ef : EvaluationSparseFeature::all()) {
+        if (!ef.tweakable())
+            continue;
+        vector<double> values(ef.size());
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = (i == 0 ? 0 : values[i - 1]) + vs[pos++];
+        parameter->setValues(ef.key(), values);
+    }
+
+    return true;
+}
+
 string makePuyopURL(const KumipuyoSeq& seq, const vector<Decision>& decisions)
 {
     static const char ENCODER[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ[]";
@@ -194,32 +275,24 @@ void runOnce(const EvaluationParameterMap& paramMap)
     if (result.zenkeshi)
         cout << " / ZENKESHI";
     cout << endl;
+
+    if (PhaseProfiler::isEnabled())
+        cout << PhaseProfiler::toString();
 }
 
 RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
 {
     const int N = FLAGS_size;
-    vector<promise<Result>> ps(N);
+    vector<KumipuyoSeq> seqs;
+    for (int i = 0; i < N; ++i)
+        seqs.push_back(generateRandomSequenceWithSeed(i + FLAGS_offset));
 
-    for (int i = 0; i < N; ++i) {
-        auto f = [i, &paramMap, &ps]() {
-            auto ai = new DebuggableMayahAI;
-            ai->setEvaluationParameterMap(paramMap);
-
-            Endless endless(std::move(std::unique_ptr<AI>(ai)));
-            stringstream ss;
-            KumipuyoSeq seq = generateRandomSequenceWithSeed(i + FLAGS_offset);
-            EndlessResult result = endless.run(seq);
-            ss << "case " << setw(2) << i << ": "
-               << "score=" << setw(6) << result.score << " rensa=" << setw(2) << result.maxRensa;
-            if (result.zenkeshi)
-                ss << " / ZENKESHI";
-            ss << endl;
-
-            ps[i].set_value(Result{result, ss.str()});
-        };
-        executor->submit(f);
-    }
+    BatchEndless batchEndless([&paramMap]() {
+        auto ai = new DebuggableMayahAI;
+        ai->setEvaluationParameterMap(paramMap);
+        return unique_ptr<AI>(ai);
+    }, executor, FLAGS_num_threads);
+    BatchEndlessResult batchResult = batchEndless.run(seqs);
 
     int numZenkeshi = 0;
     int sumScore = 0;
@@ -233,13 +306,18 @@ RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
 
     vector<pair<int, int>> scores;
     for (int i = 0; i < N; ++i) {
-        Result r = ps[i].get_future().get();
-        cout << r.msg;
-        if (r.result.zenkeshi && r.result.hand < 8) {
+        const EndlessResult& result = batchResult.results[i];
+        cout << "case " << setw(2) << i << ": "
+             << "score=" << setw(6) << result.score << " rensa=" << setw(2) << result.maxRensa;
+        if (result.zenkeshi)
+            cout << " / ZENKESHI";
+        cout << endl;
+
+        if (result.zenkeshi && result.hand < 8) {
             numZenkeshi++;
             continue;
         }
-        int score = r.result.score;
+        int score = result.score;
         sumScore += score;
         scores.push_back(make_pair(score, i + FLAGS_offset));
         if (score >= 10000) {
@@ -276,6 +354,12 @@ RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
     cout << "over  70000 = " << over70000Count << endl;
     cout << "over  80000 = " << over80000Count << endl;
     cout << "over 100000 = " << over100000Count << endl;
+    cout << "think time [us] p50 = " << batchResult.thinkMicrosPercentile(50)
+         << " p90 = " << batchResult.thinkMicrosPercentile(90)
+         << " p99 = " << batchResult.thinkMicrosPercentile(99)
+         << " max = " << batchResult.thinkMicrosPercentile(100) << endl;
+    if (PhaseProfiler::isEnabled())
+        cout << PhaseProfiler::toString();
     if (scores.size() >= 10) {
         for (int i = 0; i < 5; ++i) {
             cout << "  seed " << scores[i].second << " -> " << scores[i].first << endl;
@@ -286,28 +370,70 @@ RunResult run(Executor* executor, const EvaluationParameterMap& paramMap)
             over40000Count, over60000Count, over70000Count, over80000Count, over100000Count };
 }
 
+int runCase(const EvaluationParameterMap& paramMap, int i)
+{
+    auto ai = new DebuggableMayahAI;
+    ai->setEvaluationParameterMap(paramMap);
+
+    Endless endless(std::move(std::unique_ptr<AI>(ai)));
+    KumipuyoSeq seq = generateRandomSequenceWithSeed(i + FLAGS_offset);
+    return RunResult::caseScore(endless.run(seq));
+}
+
+// Races the current best parameter and --race_candidates tweaked parameters on the same
+// cases. The cases of the current best parameter are evaluated only once, and the tweaked
+// parameters clearly worse than the best one are dropped without evaluating all the cases.
 void runAutoTweaker(Executor* executor, const EvaluationParameterMap& original, int num)
 {
-    cout << "Run with the original parameter." << endl;
-    EvaluationParameterMap currentBestParameter(original);
-    RunResult currentBestResult = run(executor, original);
+    Race::Option option;
+    option.numCases = FLAGS_size;
+    option.batchSize = FLAGS_race_batch_size;
+    option.minCases = FLAGS_race_min_cases;
+    option.threshold = FLAGS_race_threshold;
 
-    cout << "original score = " << currentBestResult.resultScore() << endl;
+    EvaluationParameterMap currentBestParameter(original);
+    vector<double> currentBestScores;
+    {
+        cout << "Run with the original parameter." << endl;
+        Race race(1, option);
+        race.run(executor, [&](int, int caseIndex) { return runCase(original, caseIndex); });
+        currentBestScores = race.scores(0);
+        cout << "original score = " << race.sumScore(0) << endl;
+    }
 
     ParameterTweaker tweaker;
 
-    for (int i = 0; i < num; ++i) {
-        EvaluationParameterMap parameter(currentBestParameter);
-        tweaker.tweakParameter(&parameter);
+    int numEvaluations = 0;
+    for (int i = 0; i < num; i += FLAGS_race_candidates) {
+        // Candidate 0 is the current best parameter.
+        int numCandidates = std::min(FLAGS_race_candidates, num - i) + 1;
+        vector<EvaluationParameterMap> parameters(numCandidates, currentBestParameter);
+        for (int c = 1; c < numCandidates; ++c)
+            tweaker.tweakParameter(&parameters[c]);
+
+        Race race(numCandidates, option);
+        race.setKnownScores(0, currentBestScores);
+        race.run(executor, [&](int c, int caseIndex) { return runCase(parameters[c], caseIndex); }, [&](int numCases) {
+            cout << "cases = " << setw(3) << numCases << ":";
+            for (int c = 0; c < numCandidates; ++c) {
+                if (race.isAlive(c))
+                    cout << " " << setw(5) << race.sumScore(c);
+                else
+                    cout << " " << setw(5) << "-";
+            }
+            cout << endl;
+        });
 
-        RunResult result = run(executor, parameter);
-        cout << "score = " << result.resultScore() << endl;
+        numEvaluations += race.numEvaluations();
+        cout << "evaluated cases = " << numEvaluations
+             << " (" << (i + numCandidates - 1) * FLAGS_size << " without racing)" << endl;
 
-        if (currentBestResult.resultScore() < result.resultScore()) {
-            currentBestResult = result;
-            currentBestParameter = parameter;
+        int best = race.best();
+        if (best > 0 && race.sumScore(0) < race.sumScore(best)) {
+            currentBestParameter = parameters[best];
+            currentBestScores = race.scores(best);
 
-            cout << "Best parameter is updated." << endl;
+            cout << "Best parameter is updated. score = " << race.sumScore(best) << endl;
             cout << currentBestParameter.toString() << endl;
 
             CHECK(currentBestParameter.save("best-parameter.txt"));
@@ -315,6 +441,76 @@ void runAutoTweaker(Executor* executor, const EvaluationParameterMap& original,
     }
 }
 
+// Optimizes all the tweakable parameters with CMA-ES. The fitness of a parameter is the sum
+// of RunResult::caseScore() over --size cases. All the cases of a population are evaluated
+// concurrently. The state is saved to --cmaes_checkpoint after each generation, and the
+// optimization is resumed from it if it exists. Returns false if the parameters or
+// the checkpoint don't match the features.
+bool runCMAES(Executor* executor, const EvaluationParameterMap& original, int numGenerations)
+{
+    vector<double> initialMean = toVector(original.defaultParameter());
+    if (initialMean.size() != numTweakableValues()) {
+        LOG(ERROR) << "The parameter has " << initialMean.size() << " tweakable values, but "
+                   << numTweakableValues() << " are expected. Check the sizes of the sparse features in "
+                   << FLAGS_feature;
+        return false;
+    }
+
+    CMAES cmaes(initialMean, vector<double>(initialMean.size(), FLAGS_cmaes_stddev),
+                FLAGS_cmaes_lambda, FLAGS_cmaes_seed);
+    if (ifstream(FLAGS_cmaes_checkpoint)) {
+        // Don't overwrite the checkpoint of the different features.
+        if (!cmaes.load(FLAGS_cmaes_checkpoint)) {
+            LOG(ERROR) << "Cannot resume from " << FLAGS_cmaes_checkpoint
+                       << ". Its dimension must be " << cmaes.dimension() << ".";
+            return false;
+        }
+        cout << "Resumed from " << FLAGS_cmaes_checkpoint
+             << " at generation " << cmaes.generation() << endl;
+    }
+
+    cout << "dimension = " << cmaes.dimension() << " lambda = " << cmaes.lambda() << endl;
+
+    Race::Option option;
+    option.numCases = FLAGS_size;
+    option.batchSize = FLAGS_size;
+    // CMA-ES needs the fitness of every candidate.
+    option.eliminates = false;
+
+    while (cmaes.generation() < numGenerations) {
+        vector<vector<double>> population = cmaes.ask();
+        vector<EvaluationParameterMap> parameters(population.size(), original);
+        for (size_t i = 0; i < population.size(); ++i)
+            CHECK(fromVector(population[i], parameters[i].mutableDefaultParameter()));
+
+        Race race(population.size(), option);
+        race.run(executor, [&](int c, int caseIndex) { return runCase(parameters[c], caseIndex); });
+
+        vector<double> fitness(population.size());
+        double previousBestFitness = cmaes.bestFitness();
+        for (size_t i = 0; i < population.size(); ++i)
+            fitness[i] = race.sumScore(i);
+        cmaes.tell(population, fitness);
+
+        cout << "generation = " << cmaes.generation()
+             << " best = " << *max_element(fitness.begin(), fitness.end())
+             << " best ever = " << cmaes.bestFitness()
+             << " sigma = " << cmaes.sigma() << endl;
+
+        if (previousBestFitness < cmaes.bestFitness()) {
+            EvaluationParameterMap best(original);
+            CHECK(fromVector(cmaes.best(), best.mutableDefaultParameter()));
+            cout << "Best parameter is updated." << endl;
+            cout << best.toString() << endl;
+            CHECK(best.save("best-parameter.txt"));
+        }
+
+        CHECK(cmaes.save(FLAGS_cmaes_checkpoint));
+    }
+
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
     google::ParseCommandLineFlags(&argc, &argv, true);
@@ -333,6 +529,9 @@ int main(int argc, char* argv[])
         runOnce(paramMap);
     } else if (FLAGS_once) {
         run(executor.get(), paramMap);
+    } else if (FLAGS_cmaes_generations > 0) {
+        if (!runCMAES(executor.get(), paramMap, FLAGS_cmaes_generations))
+            return 1;
     } else if (FLAGS_auto_count > 0) {
         runAutoTweaker(executor.get(), paramMap, FLAGS_auto_count);
     } else {
@@ -8,9 +8,11 @@
 
 #include <gflags/gflags.h>
 
+#include "base/trace.h"
 #include "core/constant.h"
 #include "core/decision.h"
 #include "core/frame_response.h"
+#include "core/key_set.h"
 #include "core/puyo_controller.h"
 #include "core/server/connector/connector.h"
 #include "core/server/connector/connector_manager.h"
@@ -61,6 +63,21 @@ struct DuelServer::DuelState {
     std::string message[2];
 };
 
+static void traceKeySetSeq(int pi, const KeySetSeq& seq)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    char text[trace::Record::TEXT_SIZE];
+    size_t size = 0;
+    for (const KeySet& ks : seq) {
+        if (size + 2 > sizeof(text))
+            break;
+        text[size++] = HEX[ks.toInt() >> 4];
+        text[size++] = HEX[ks.toInt() & 0xF];
+    }
+    trace::record(trace::Event::KEY_SET_SEQ, pi, static_cast<int32_t>(seq.size()), text, size);
+}
+
 /**
  * Updates decision when an applicable one is found.
  * Returns:
@@ -277,11 +294,19 @@ void DuelServer::play(DuelState* duelState, const vector<FrameResponse> data[2])
             me->setKeySetSeq(kss);
         }
 
+        // The message of a decision might come in a later response without any decision.
+        // See AI::sendDropDecision().
         string accepted_message;
-        if (accepted_index != -1)
-            accepted_message = data[pi][accepted_index].msg;
+        for (int i = static_cast<int>(data[pi].size()) - 1; i >= 0; --i) {
+            if (i != accepted_index && data[pi][i].decision.isValid())
+                continue;
+            if (!data[pi][i].msg.empty()) {
+                accepted_message = data[pi][i].msg;
+                break;
+            }
+        }
 
-        LOG(INFO) << "Current KeySetSeq: " << pi << " " << me->keySetSeq().toString();
+        traceKeySetSeq(pi, me->keySetSeq());
         KeySet keySet = me->frontKeySet();
         me->dropFrontKeySet();
         // For human connector. The received data from HumanConnector might have some key.
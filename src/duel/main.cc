@@ -11,8 +11,10 @@
 #include <glog/logging.h>
 
 #include "base/file.h"
+#include "base/trace.h"
 #include "core/httpd/http_server.h"
 #include "core/server/connector/human_connector.h"
+#include "core/server/async_game_state_observer.h"
 #include "core/server/connector/connector_manager_posix.h"
 #include "core/server/game_state.h"
 #include "core/server/game_state_observer.h"
@@ -40,6 +42,7 @@ using namespace std;
 
 DEFINE_string(record, "", "use Puyofu Recorder. 'transition' for transition log, 'field' for field log");
 DEFINE_bool(ignore_sigpipe, false, "true to ignore SIGPIPE");
+DEFINE_bool(async_observers, true, "notify the observers on their own threads not to stall the game");
 #ifdef USE_HTTPD
 DEFINE_bool(httpd, false, "use httpd");
 DEFINE_int32(port, 8000, "httpd port");
@@ -97,6 +100,7 @@ int main(int argc, char* argv[])
     google::InitGoogleLogging(argv[0]);
     google::ParseCommandLineFlags(&argc, &argv, true);
     google::InstallFailureSignalHandler();
+    trace::installCrashHandler();
 
     if (FLAGS_ignore_sigpipe)
         ignoreSIGPIPE();
@@ -204,20 +208,34 @@ int main(int argc, char* argv[])
 
     DuelServer duelServer(&manager);
 
+    // The drawers need only the latest state, but the recorders need all the states,
+    // since they look at the events of each frame.
+    typedef AsyncGameStateObserver::Delivery Delivery;
+    vector<unique_ptr<AsyncGameStateObserver>> asyncObservers;
+    auto addObserver = [&](GameStateObserver* observer, Delivery delivery) {
+        if (!FLAGS_async_observers) {
+            duelServer.addObserver(observer);
+            return;
+        }
+        asyncObservers.emplace_back(new AsyncGameStateObserver(observer, delivery));
+        CHECK(asyncObservers.back()->start());
+        duelServer.addObserver(asyncObservers.back().get());
+    };
+
     // --- Add necessary obesrvers here.
 #if USE_HTTPD
     if (gameStateHandler.get())
-        duelServer.addObserver(gameStateHandler.get());
+        addObserver(gameStateHandler.get(), Delivery::LATEST_ONLY);
 #endif
     if (cui.get())
-        duelServer.addObserver(cui.get());
+        addObserver(cui.get(), Delivery::LATEST_ONLY);
     if (puyofuRecorder.get())
-        duelServer.addObserver(puyofuRecorder.get());
+        addObserver(puyofuRecorder.get(), Delivery::LOSSLESS);
 #if USE_SDL2
     if (fieldDrawer.get())
-        duelServer.addObserver(fieldDrawer.get());
+        addObserver(fieldDrawer.get(), Delivery::LATEST_ONLY);
     if (commentator.get())
-        duelServer.addObserver(commentator.get());
+        addObserver(commentator.get(), Delivery::LOSSLESS);
 #endif
 #if USE_HTTPD
     if (httpServer.get())
@@ -225,7 +243,7 @@ int main(int argc, char* argv[])
 #endif
 #if USE_AUDIO_COMMENTATOR
     if (audioCommentator.get())
-        duelServer.addObserver(audioCommentator.get());
+        addObserver(audioCommentator.get(), Delivery::LOSSLESS);
     if (audioServer.get())
         audioServer->start();
 #endif
@@ -248,12 +266,17 @@ int main(int argc, char* argv[])
         mainWindow->runMainLoop();
         duelServer.stop();
     }
+#endif
 
+    duelServer.join();
+    // The remaining states are delivered, so that the recorders see the end of the game.
+    // This should be done before the observers, e.g. the commentator, are stopped.
+    for (auto& observer : asyncObservers)
+        observer->stop();
+#if USE_SDL2
     if (commentator.get())
         commentator->stop();
 #endif
-
-    duelServer.join();
 #if USE_HTTPD
     if (httpServer.get())
         httpServer->stop();
@@ -263,5 +286,6 @@ int main(int argc, char* argv[])
         audioServer->stop();
 #endif
 
+    trace::dumpToFile();
     return 0;
 }
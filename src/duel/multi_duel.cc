@@ -0,0 +1,58 @@
+// multi_duel runs many AI-vs-AI games concurrently in one process.
+// All connectors are multiplexed on one EpollConnectorHub.
+//
+// Usage: multi_duel [--num_games=N] <program1> <program2>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/trace.h"
+#include "core/server/connector/connector.h"
+#include "core/server/connector/connector_manager.h"
+#include "core/server/connector/epoll_connector_hub.h"
+#include "duel/duel_server.h"
+
+using namespace std;
+
+DEFINE_int32(num_games, 8, "the number of games to run concurrently");
+
+int main(int argc, char* argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    google::InstallFailureSignalHandler();
+    trace::installCrashHandler();
+
+    if (argc != 3) {
+        LOG(ERROR) << "There must be 2 arguments." << endl;
+        return 1;
+    }
+
+    EpollConnectorHub hub;
+    vector<unique_ptr<ConnectorManager>> managers;
+    for (int i = 0; i < FLAGS_num_games; ++i) {
+        managers.push_back(hub.addGame(Connector::create(0, string(argv[1])),
+                                       Connector::create(1, string(argv[2]))));
+    }
+    CHECK(hub.start());
+
+    vector<unique_ptr<DuelServer>> duelServers;
+    for (const auto& manager : managers) {
+        duelServers.emplace_back(new DuelServer(manager.get()));
+        CHECK(duelServers.back()->start());
+    }
+
+    for (const auto& duelServer : duelServers)
+        duelServer->join();
+
+    duelServers.clear();
+    managers.clear();
+    hub.stop();
+    trace::dumpToFile();
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 #ifndef GUI_BOX_H_
 #define GUI_BOX_H_
 
+#include <algorithm>
+
 #include <SDL.h>
 
 struct Box {
@@ -10,6 +12,25 @@ struct Box {
     int w() const { return dx - sx; }
     int h() const { return dy - sy; }
 
+    bool isEmpty() const { return dx <= sx || dy <= sy; }
+    bool intersects(const Box& b) const { return sx < b.dx && b.sx < dx && sy < b.dy && b.sy < dy; }
+
+    // Returns the smallest box containing both boxes. An empty box is ignored.
+    Box unite(const Box& b) const
+    {
+        if (isEmpty())
+            return b;
+        if (b.isEmpty())
+            return *this;
+        return Box(std::min(sx, b.sx), std::min(sy, b.sy), std::max(dx, b.dx), std::max(dy, b.dy));
+    }
+
+    // Returns the common part of the boxes. It might be empty.
+    Box intersect(const Box& b) const
+    {
+        return Box(std::max(sx, b.sx), std::max(sy, b.sy), std::min(dx, b.dx), std::min(dy, b.dy));
+    }
+
     SDL_Rect toSDLRect() const { return SDL_Rect { sx, sy, w(), h() }; }
 
     void moveOffset(int x, int y)
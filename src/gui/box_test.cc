@@ -19,3 +19,49 @@ TEST(BoxTest, ToSDLRect)
    EXPECT_EQ(30, r.w);
    EXPECT_EQ(40, r.h);
 }
+
+TEST(BoxTest, IsEmpty)
+{
+   EXPECT_TRUE(Box().isEmpty());
+   EXPECT_TRUE(Box(10, 20, 10, 60).isEmpty());
+   EXPECT_TRUE(Box(10, 20, 40, 10).isEmpty());
+   EXPECT_FALSE(Box(10, 20, 40, 60).isEmpty());
+}
+
+TEST(BoxTest, Intersects)
+{
+   Box b(10, 20, 40, 60);
+
+   EXPECT_TRUE(b.intersects(Box(30, 50, 50, 70)));
+   EXPECT_TRUE(b.intersects(Box(0, 0, 100, 100)));
+   EXPECT_FALSE(b.intersects(Box(40, 20, 50, 60)));
+   EXPECT_FALSE(b.intersects(Box(10, 0, 40, 20)));
+}
+
+TEST(BoxTest, Unite)
+{
+   Box b = Box(10, 20, 40, 60).unite(Box(30, 0, 50, 30));
+
+   EXPECT_EQ(10, b.sx);
+   EXPECT_EQ(0, b.sy);
+   EXPECT_EQ(50, b.dx);
+   EXPECT_EQ(60, b.dy);
+
+   Box c = Box().unite(Box(30, 0, 50, 30));
+   EXPECT_EQ(30, c.sx);
+   EXPECT_EQ(0, c.sy);
+   EXPECT_EQ(50, c.dx);
+   EXPECT_EQ(30, c.dy);
+}
+
+TEST(BoxTest, Intersect)
+{
+   Box b = Box(10, 20, 40, 60).intersect(Box(30, 0, 50, 30));
+
+   EXPECT_EQ(30, b.sx);
+   EXPECT_EQ(20, b.sy);
+   EXPECT_EQ(40, b.dx);
+   EXPECT_EQ(30, b.dy);
+
+   EXPECT_TRUE(Box(10, 20, 40, 60).intersect(Box(50, 0, 60, 10)).isEmpty());
+}
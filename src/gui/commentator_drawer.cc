@@ -87,6 +87,19 @@ void CommentatorDrawer::onCommentatorResultUpdate(const CommentatorResult& resul
 {
     lock_guard<mutex> lock(mu_);
     result_ = result;
+    dirty_ = true;
+}
+
+bool CommentatorDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    // The comments are drawn all around the screen, but they're not updated every frame.
+    // So redraw the whole screen when updated.
+    lock_guard<mutex> lock(mu_);
+    if (dirty_) {
+        rects->push_back(Box(0, 0, screen->surface()->w, screen->surface()->h));
+        dirty_ = false;
+    }
+    return true;
 }
 
 void CommentatorDrawer::draw(Screen* screen)
@@ -2,6 +2,7 @@
 #define GUI_COMMENTATOR_DRAWER_H_
 
 #include <mutex>
+#include <vector>
 
 #include "core/server/commentator.h"
 #include "gui/drawer.h"
@@ -14,6 +15,7 @@ public:
     virtual ~CommentatorDrawer();
 
     virtual void onCommentatorResultUpdate(const CommentatorResult&) override;
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
 
 private:
@@ -22,6 +24,7 @@ private:
 
     std::mutex mu_;
     CommentatorResult result_;
+    bool dirty_ = false;
 };
 
 #endif
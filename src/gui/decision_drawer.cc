@@ -12,14 +12,42 @@ void DecisionDrawer::onUpdate(const GameState& gameState)
 
     for (int pi = 0; pi < 2; ++pi) {
         const PlayerGameState& pgs = gameState.playerGameState(pi);
+        KumipuyoPos pos;
+        Kumipuyo kumipuyo;
         if (pgs.kumipuyoSeq.size() >= 1) {
-            pos_[pi] = pgs.kumipuyoPos;
-            kumipuyo_[pi] = pgs.kumipuyoSeq.front();
-        } else {
-            pos_[pi] = KumipuyoPos();
-            kumipuyo_[pi] = Kumipuyo();
+            pos = pgs.kumipuyoPos;
+            kumipuyo = pgs.kumipuyoSeq.front();
         }
+
+        if (pos == pos_[pi] && kumipuyo == kumipuyo_[pi])
+            continue;
+
+        // Both the old and the new circles should be redrawn.
+        addBoxes(pi);
+        pos_[pi] = pos;
+        kumipuyo_[pi] = kumipuyo;
+        addBoxes(pi);
+    }
+}
+
+void DecisionDrawer::addBoxes(int pi)
+{
+    if (!pos_[pi].isValid())
+        return;
+
+    dirtyBoxes_.push_back(BoundingBox::instance().get(pi, pos_[pi].axisX(), pos_[pi].axisY()));
+    dirtyBoxes_.push_back(BoundingBox::instance().get(pi, pos_[pi].childX(), pos_[pi].childY()));
+}
+
+bool DecisionDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    lock_guard<mutex> lock(mu_);
+    for (Box b : dirtyBoxes_) {
+        b.moveOffset(screen->mainBox().sx, screen->mainBox().sy);
+        rects->push_back(b);
     }
+    dirtyBoxes_.clear();
+    return true;
 }
 
 void DecisionDrawer::draw(Screen* screen)
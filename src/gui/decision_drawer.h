@@ -2,6 +2,7 @@
 #define GUI_DECISION_DRAWER_H_
 
 #include <mutex>
+#include <vector>
 
 #include "core/decision.h"
 #include "core/kumipuyo.h"
@@ -16,12 +17,17 @@ public:
     virtual ~DecisionDrawer() override {}
 
     virtual void onUpdate(const GameState&) override;
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
 
 private:
+    void addBoxes(int playerId);
+
     mutable std::mutex mu_;
     KumipuyoPos pos_[2];
     Kumipuyo kumipuyo_[2];
+    // The boxes changed since the last frame. They're not moved by the main box.
+    std::vector<Box> dirtyBoxes_;
 };
 
 #endif
@@ -1,12 +1,25 @@
 #ifndef GUI_DRAWER_H_
 #define GUI_DRAWER_H_
 
+#include <vector>
+
+#include "gui/box.h"
+
 class Screen;
 
 class Drawer {
 public:
     virtual ~Drawer() {}
     virtual void onInit() {}
+
+    // Adds the regions of the screen which will be drawn differently from the last frame
+    // to |rects|, and returns true. This is called once per frame before draw().
+    // MainWindow redraws only the dirty regions, so draw() might be called several times
+    // in a frame with the clip rect of the screen surface set to each region.
+    // A drawer which doesn't track its changes returns false, and then the whole screen
+    // is redrawn.
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) { return false; }
+
     virtual void draw(Screen*) = 0;
 };
 
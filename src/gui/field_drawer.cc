@@ -24,10 +24,33 @@ DECLARE_string(data_dir);
 static const string kJapaneseBdfName = "/jiskan24.bdf";
 static const string kEnglishBdfName = "/12x24.bdf";
 static const int kBdfSize = 24;
+static const int kEnglishBdfWidth = 12;
+static const int kScoreDigits = 10;
 
 static const int PUYO_W = 32;
 static const int PUYO_H = 35;
 
+// Returns the color drawn at (x, y), including the moving kumipuyo.
+static PuyoColor displayedColor(const PlayerGameState& pgs, int x, int y)
+{
+    if (pgs.playable) {
+        const Kumipuyo& kumipuyo = pgs.kumipuyoSeq.front();
+        const KumipuyoPos& kumipuyoPos = pgs.kumipuyoPos;
+        if (x == kumipuyoPos.axisX() && y == kumipuyoPos.axisY())
+            return kumipuyo.axis;
+        if (x == kumipuyoPos.childX() && y == kumipuyoPos.childY())
+            return kumipuyo.child;
+    }
+
+    return pgs.field.get(x, y);
+}
+
+static Box scoreBox(int playerId)
+{
+    Box b = BoundingBox::instance().get(playerId, 0, -1);
+    return Box(b.sx, b.sy, b.sx + kScoreDigits * kEnglishBdfWidth, b.sy + kBdfSize);
+}
+
 FieldDrawer::FieldDrawer() :
     backgroundSurface_(makeUniqueSDLSurface(IMG_Load((FLAGS_data_dir + "/assets/background.png").c_str()))),
     puyoSurface_(makeUniqueSDLSurface(IMG_Load((FLAGS_data_dir + "/assets/puyo.png").c_str()))),
@@ -51,9 +74,66 @@ void FieldDrawer::onInit()
 void FieldDrawer::onUpdate(const GameState& gameState)
 {
     lock_guard<mutex> lock(mu_);
+    if (gameState_) {
+        for (int pi = 0; pi < 2; ++pi)
+            addChangedBoxes(pi, gameState_->playerGameState(pi), gameState.playerGameState(pi));
+    } else {
+        allDirty_ = true;
+    }
     gameState_.reset(new GameState(gameState));
 }
 
+void FieldDrawer::addChangedBoxes(int playerId, const PlayerGameState& prev, const PlayerGameState& current)
+{
+    const BoundingBox& bb = BoundingBox::instance();
+
+    for (int x = 0; x < FieldConstant::MAP_WIDTH; ++x) {
+        for (int y = 0; y < FieldConstant::MAP_HEIGHT; ++y) {
+            if (displayedColor(prev, x, y) != displayedColor(current, x, y))
+                dirtyBoxes_.push_back(bb.get(playerId, x, y));
+        }
+    }
+
+    static const NextPuyoPosition positions[] = {
+        NextPuyoPosition::NEXT1_AXIS,
+        NextPuyoPosition::NEXT1_CHILD,
+        NextPuyoPosition::NEXT2_AXIS,
+        NextPuyoPosition::NEXT2_CHILD,
+    };
+    for (NextPuyoPosition npp : positions) {
+        if (prev.kumipuyoSeq.color(npp) != current.kumipuyoSeq.color(npp))
+            dirtyBoxes_.push_back(bb.get(playerId, npp));
+    }
+
+    // The ojama notices are drawn in a row from the column 1. Take the row over the walls,
+    // since a lot of notices might be wider than the field.
+    if (prev.ojama() != current.ojama())
+        dirtyBoxes_.push_back(bb.get(playerId, 0, 13).unite(bb.get(playerId, FieldConstant::MAP_WIDTH - 1, 13)));
+
+    if (prev.score != current.score)
+        dirtyBoxes_.push_back(scoreBox(playerId));
+}
+
+bool FieldDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    lock_guard<mutex> lock(mu_);
+    if (!gameState_)
+        return true;
+
+    const Box& mainBox = screen->mainBox();
+    if (allDirty_) {
+        rects->push_back(mainBox);
+        allDirty_ = false;
+    } else {
+        for (Box b : dirtyBoxes_) {
+            b.moveOffset(mainBox.sx, mainBox.sy);
+            rects->push_back(b);
+        }
+    }
+    dirtyBoxes_.clear();
+    return true;
+}
+
 void FieldDrawer::draw(Screen* screen)
 {
     if (!gameState_)
@@ -86,18 +166,9 @@ void FieldDrawer::drawField(Screen* screen, int playerId, const PlayerGameState&
 {
     SDL_Surface* surface = screen->surface();
 
-    const Kumipuyo& kumipuyo = pgs.kumipuyoSeq.front();
-    const KumipuyoPos& kumipuyoPos = pgs.kumipuyoPos;
-
     for (int x = 0; x < FieldConstant::MAP_WIDTH; ++x) {
         for (int y = 0; y < FieldConstant::MAP_HEIGHT; ++y) {
-            PuyoColor c = pgs.field.get(x, y);
-            if (pgs.playable) {
-                if (x == kumipuyoPos.axisX() && y == kumipuyoPos.axisY())
-                    c = kumipuyo.axis;
-                if (x == kumipuyoPos.childX() && y == kumipuyoPos.childY())
-                    c = kumipuyo.child;
-            }
+            PuyoColor c = displayedColor(pgs, x, y);
 
             Box b = BoundingBox::instance().get(playerId, x, y);
             b.moveOffset(screen->mainBox().sx, screen->mainBox().sy);
@@ -203,8 +274,8 @@ void FieldDrawer::drawField(Screen* screen, int playerId, const PlayerGameState&
     // Score
     {
         ostringstream ss;
-        ss << setw(10) << pgs.score;
-        Box b = BoundingBox::instance().get(playerId, 0, -1);
+        ss << setw(kScoreDigits) << pgs.score;
+        Box b = scoreBox(playerId);
         b.moveOffset(screen->mainBox().sx, screen->mainBox().sy);
         Kanji_PutText(font_, b.sx, b.sy, surface, ss.str().c_str(), white);
     }
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "base/base.h"
 #include "core/server/game_state_observer.h"
@@ -26,14 +27,20 @@ public:
 
     virtual void onInit() override;
     virtual void onUpdate(const GameState&) override;
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
 
 private:
+    // Adds the boxes which look different between |prev| and |current| to dirtyBoxes_.
+    void addChangedBoxes(int playerId, const PlayerGameState& prev, const PlayerGameState& current);
     void drawField(Screen*, int playerId, const PlayerGameState&);
     SDL_Rect toRect(PuyoColor);
 
     mutable std::mutex mu_;
     std::unique_ptr<GameState> gameState_;
+    // The boxes changed since the last frame. They're not moved by the main box.
+    std::vector<Box> dirtyBoxes_;
+    bool allDirty_ = true;
 
     UniqueSDLSurface backgroundSurface_;
     UniqueSDLSurface puyoSurface_;
@@ -10,7 +10,8 @@
 using namespace std;
 
 FPSDrawer::FPSDrawer() :
-    frames_(0)
+    frames_(0),
+    textSurface_(emptyUniqueSDLSurface())
 {
     CLEAR_ARRAY(ticks_);
 }
@@ -19,7 +20,7 @@ FPSDrawer::~FPSDrawer()
 {
 }
 
-void FPSDrawer::draw(Screen* screen)
+bool FPSDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
 {
     Uint32 prevTicks = ticks_[frames_ % 30];
     Uint32 currentTicks = SDL_GetTicks();
@@ -29,7 +30,7 @@ void FPSDrawer::draw(Screen* screen)
 
     // No time elapsed? Weird.
     if (elapsed == 0)
-        return;
+        return true;
 
     int fps = 30 * 1000 / elapsed;
     string buf = to_string(fps) + " fps";
@@ -38,14 +39,26 @@ void FPSDrawer::draw(Screen* screen)
     c.r = c.g = c.b = 0;
     c.a = 255;
 
-    UniqueSDLSurface surf(makeUniqueSDLSurface(TTF_RenderUTF8_Blended(screen->font(), buf.c_str(), c)));
-    if (surf.get()) {
-        SDL_Rect dr = {
-            static_cast<Sint16>(screen->surface()->w / 2 - surf->w / 2),
-            static_cast<Sint16>(surf->h / 2),
-            0,
-            0
-        };
-        SDL_BlitSurface(surf.get(), NULL, screen->surface(), &dr);
+    // The previous text should be erased as well.
+    rects->push_back(textBox_);
+
+    textSurface_ = makeUniqueSDLSurface(TTF_RenderUTF8_Blended(screen->font(), buf.c_str(), c));
+    if (textSurface_.get()) {
+        int x = screen->surface()->w / 2 - textSurface_->w / 2;
+        int y = textSurface_->h / 2;
+        textBox_ = Box(x, y, x + textSurface_->w, y + textSurface_->h);
+        rects->push_back(textBox_);
+    } else {
+        textBox_ = Box();
     }
+    return true;
+}
+
+void FPSDrawer::draw(Screen* screen)
+{
+    if (!textSurface_.get())
+        return;
+
+    SDL_Rect dr = textBox_.toSDLRect();
+    SDL_BlitSurface(textSurface_.get(), NULL, screen->surface(), &dr);
 }
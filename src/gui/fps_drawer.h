@@ -1,20 +1,30 @@
 #ifndef GUI_FPS_DRAWER_H_
 #define GUI_FPS_DRAWER_H_
 
+#include <vector>
+
 #include <SDL.h>
 
 #include "base/base.h"
+#include "gui/box.h"
 #include "gui/drawer.h"
+#include "gui/unique_sdl_surface.h"
 
 class FPSDrawer : public Drawer {
 public:
     FPSDrawer();
     virtual ~FPSDrawer();
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
 
 private:
     size_t frames_;
     Uint32 ticks_[30];
+
+    // The text is rendered once a frame in addDirtyRects(), since draw() might be
+    // called several times in a frame.
+    UniqueSDLSurface textSurface_;
+    Box textBox_;
 };
 
 #endif
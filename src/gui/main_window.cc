@@ -6,7 +6,50 @@
 #include "gui/drawer.h"
 #include "gui/screen.h"
 
+using namespace std;
+
 DEFINE_bool(fullscreen, false, "show fullscreen");
+DEFINE_bool(redraw_dirty_rects_only, true, "redraw and upload only the regions the drawers have changed");
+
+namespace {
+
+// When there are more dirty rects than this, they're drawn as one rect.
+const size_t MAX_DIRTY_RECTS = 16;
+
+// Clips |rects| to |screenBox|, and merges the overlapping ones, so that no region
+// is drawn twice in a frame.
+void coalesceRects(const Box& screenBox, vector<Box>* rects)
+{
+    vector<Box> result;
+    for (const Box& rect : *rects) {
+        Box b = rect.intersect(screenBox);
+        if (b.isEmpty())
+            continue;
+
+        // The united box might intersect the boxes already checked, so check from the first.
+        for (size_t i = 0; i < result.size(); ) {
+            if (!result[i].intersects(b)) {
+                ++i;
+                continue;
+            }
+            b = b.unite(result[i]);
+            result.erase(result.begin() + i);
+            i = 0;
+        }
+        result.push_back(b);
+    }
+
+    if (result.size() > MAX_DIRTY_RECTS) {
+        Box b;
+        for (const Box& r : result)
+            b = b.unite(r);
+        result.assign(1, b);
+    }
+
+    rects->swap(result);
+}
+
+}
 
 MainWindow::MainWindow(int width, int height, const Box& mainBox) :
     window_(nullptr, SDL_DestroyWindow),
@@ -73,19 +116,49 @@ void MainWindow::addEventListener(EventListener* listener)
 
 void MainWindow::draw()
 {
-    screen()->clear();
+    const Box screenBox(0, 0, width_, height_);
+
+    // All the drawers are asked every frame, since some of them count the frames.
+    vector<Box> rects;
+    bool tracked = true;
+    for (Drawer* drawer : drawers_) {
+        if (!drawer->addDirtyRects(screen(), &rects))
+            tracked = false;
+    }
+
+    if (!tracked || needsFullRedraw_ || !FLAGS_redraw_dirty_rects_only)
+        rects.assign(1, screenBox);
+    else
+        coalesceRects(screenBox, &rects);
+    needsFullRedraw_ = false;
 
-    for (Drawer* drawer : drawers_)
-        drawer->draw(screen());
+    SDL_Surface* surface = screen()->surface();
+    for (const Box& rect : rects) {
+        SDL_Rect clipRect = rect.toSDLRect();
+        SDL_SetClipRect(surface, &clipRect);
+
+        screen()->clear();
+        for (Drawer* drawer : drawers_)
+            drawer->draw(screen());
+    }
+    SDL_SetClipRect(surface, nullptr);
 
-    renderScreen();
+    renderScreen(rects);
 }
 
-void MainWindow::renderScreen()
+void MainWindow::renderScreen(const vector<Box>& rects)
 {
     SDL_Surface* surface = screen()->surface();
 
-    SDL_UpdateTexture(texture_.get(), nullptr, surface->pixels, surface->pitch);
+    // The texture keeps the regions which are not dirty.
+    for (const Box& rect : rects) {
+        SDL_Rect r = rect.toSDLRect();
+        const Uint8* pixels = static_cast<const Uint8*>(surface->pixels) + r.y * surface->pitch + r.x * surface->format->BytesPerPixel;
+        SDL_UpdateTexture(texture_.get(), &r, pixels, surface->pitch);
+    }
+
+    // The renderer is presented every frame even if nothing is dirty, since the
+    // main loop is paced by vsync.
     SDL_RenderClear(renderer_.get());
     SDL_RenderCopy(renderer_.get(), texture_.get(), nullptr, nullptr);
     SDL_RenderPresent(renderer_.get());
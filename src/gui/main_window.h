@@ -6,7 +6,8 @@
 
 #include <SDL.h>
 
-struct Box;
+#include "gui/box.h"
+
 class Drawer;
 class GameState;
 class Screen;
@@ -32,9 +33,8 @@ private:
     Screen* screen() { return screen_.get(); }
 
     void draw();
-    // Copy screen's surface to window.
-    // The content of the screen might be random after this.
-    void renderScreen();
+    // Copy |rects| of screen's surface to window.
+    void renderScreen(const std::vector<Box>& rects);
 
     std::unique_ptr<SDL_Window, void (*)(SDL_Window*)> window_;
     std::unique_ptr<SDL_Renderer, void (*)(SDL_Renderer*)> renderer_;
@@ -46,6 +46,9 @@ private:
 
     int width_;
     int height_;
+
+    // The texture is not initialized until the whole screen is drawn once.
+    bool needsFullRedraw_ = true;
 };
 
 #endif
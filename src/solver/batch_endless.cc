@@ -0,0 +1,62 @@
+#include "solver/batch_endless.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <glog/logging.h>
+
+#include "base/executor.h"
+#include "base/wait_group.h"
+#include "core/client/ai/ai.h"
+#include "core/kumipuyo_seq.h"
+
+using namespace std;
+
+int64_t BatchEndlessResult::thinkMicrosPercentile(double p) const
+{
+    if (thinkMicros.empty())
+        return 0;
+
+    DCHECK(0 <= p && p <= 100) << p;
+    size_t rank = static_cast<size_t>(ceil(p / 100 * thinkMicros.size()));
+    return thinkMicros[rank == 0 ? 0 : rank - 1];
+}
+
+BatchEndless::BatchEndless(AIFactory factory, Executor* executor, int numWorkers) :
+    factory_(std::move(factory)),
+    executor_(executor),
+    numWorkers_(numWorkers)
+{
+    CHECK(executor_);
+    CHECK_GT(numWorkers_, 0);
+}
+
+BatchEndlessResult BatchEndless::run(const vector<KumipuyoSeq>& seqs, const ResultCallback& callback) const
+{
+    BatchEndlessResult result;
+    result.results.resize(seqs.size());
+
+    atomic<size_t> next(0);
+    WaitGroup wg;
+    int numWorkers = std::min<int>(numWorkers_, seqs.size());
+    wg.add(numWorkers);
+    for (int i = 0; i < numWorkers; ++i) {
+        executor_->submit([&]() {
+            Endless endless(factory_());
+            for (size_t index = next++; index < seqs.size(); index = next++) {
+                result.results[index] = endless.run(seqs[index]);
+                if (callback)
+                    callback(index, result.results[index]);
+            }
+            wg.done();
+        });
+    }
+    wg.waitUntilDone();
+
+    for (const auto& r : result.results)
+        result.thinkMicros.insert(result.thinkMicros.end(), r.thinkMicros.begin(), r.thinkMicros.end());
+    sort(result.thinkMicros.begin(), result.thinkMicros.end());
+
+    return result;
+}
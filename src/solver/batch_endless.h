@@ -0,0 +1,50 @@
+#ifndef SOLVER_BATCH_ENDLESS_H_
+#define SOLVER_BATCH_ENDLESS_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "base/noncopyable.h"
+#include "solver/endless.h"
+
+class AI;
+class Executor;
+class KumipuyoSeq;
+
+struct BatchEndlessResult {
+    // results[i] is the result of the i-th sequence.
+    std::vector<EndlessResult> results;
+    // The think time of all the hands [us], sorted.
+    std::vector<int64_t> thinkMicros;
+
+    // Returns the |p|-th percentile (0 <= p <= 100) of the think time [us] with the
+    // nearest-rank method. Returns 0 if no hand has been thought.
+    int64_t thinkMicrosPercentile(double p) const;
+};
+
+// BatchEndless runs Endless for many sequences on an executor. Each worker has
+// its own AI, and takes the next sequence when it has finished one, so the
+// sequences are interleaved among the workers.
+class BatchEndless : noncopyable {
+public:
+    // Called once per worker, from the worker thread.
+    typedef std::function<std::unique_ptr<AI> ()> AIFactory;
+    // Called when a sequence has finished, from the worker thread.
+    typedef std::function<void (int index, const EndlessResult&)> ResultCallback;
+
+    // Doesn't take the ownership of |executor|. |executor| should have at least
+    // |numWorkers| threads to run the workers in parallel.
+    BatchEndless(AIFactory factory, Executor* executor, int numWorkers);
+
+    BatchEndlessResult run(const std::vector<KumipuyoSeq>&,
+                           const ResultCallback& callback = ResultCallback()) const;
+
+private:
+    AIFactory factory_;
+    Executor* executor_;
+    int numWorkers_;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "solver/batch_endless.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/base.h"
+#include "base/executor.h"
+#include "core/client/ai/ai.h"
+#include "core/core_field.h"
+#include "core/kumipuyo_seq.h"
+#include "core/sequence_generator.h"
+
+using namespace std;
+
+namespace {
+
+// Puts kumipuyos from left to right.
+class LeftToRightAI : public AI {
+public:
+    LeftToRightAI() : AI("left_to_right") {}
+
+    virtual DropDecision think(int frameId, const CoreField& field, const KumipuyoSeq&,
+                               const PlayerState&, const PlayerState&, bool) const override
+    {
+        UNUSED_VARIABLE(frameId);
+        for (int x = 1; x <= 6; ++x) {
+            if (x != 3 && field.height(x) < 10)
+                return DropDecision(Decision(x, 0));
+        }
+        return DropDecision(Decision(3, 0));
+    }
+};
+
+}
+
+TEST(BatchEndlessTest, run)
+{
+    vector<KumipuyoSeq> seqs;
+    for (int i = 0; i < 7; ++i)
+        seqs.push_back(generateRandomSequenceWithSeed(i));
+
+    Executor executor(3);
+    executor.start();
+
+    atomic<int> numAIs(0);
+    BatchEndless batchEndless([&numAIs]() {
+        ++numAIs;
+        return unique_ptr<AI>(new LeftToRightAI);
+    }, &executor, 3);
+
+    // Each element is written by one worker. vector<bool> would share a word among them.
+    vector<int> called(seqs.size());
+    BatchEndlessResult result = batchEndless.run(seqs, [&called](int index, const EndlessResult&) {
+        ++called[index];
+    });
+
+    EXPECT_EQ(3, numAIs.load());
+    ASSERT_EQ(seqs.size(), result.results.size());
+
+    size_t numHands = 0;
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        EXPECT_EQ(1, called[i]);
+
+        // Same as running Endless one by one.
+        EndlessResult expected = Endless(unique_ptr<AI>(new LeftToRightAI)).run(seqs[i]);
+        EXPECT_EQ(expected.decisions, result.results[i].decisions);
+        EXPECT_EQ(expected.score, result.results[i].score);
+        EXPECT_EQ(result.results[i].decisions.size(), result.results[i].thinkMicros.size());
+        numHands += result.results[i].thinkMicros.size();
+    }
+
+    EXPECT_EQ(numHands, result.thinkMicros.size());
+    EXPECT_LE(result.thinkMicrosPercentile(0), result.thinkMicrosPercentile(50));
+    EXPECT_LE(result.thinkMicrosPercentile(50), result.thinkMicrosPercentile(99));
+    EXPECT_EQ(result.thinkMicros.back(), result.thinkMicrosPercentile(100));
+}
+
+TEST(BatchEndlessTest, percentile)
+{
+    BatchEndlessResult result;
+    EXPECT_EQ(0, result.thinkMicrosPercentile(50));
+
+    result.thinkMicros = { 10, 20, 30, 40 };
+    EXPECT_EQ(10, result.thinkMicrosPercentile(0));
+    EXPECT_EQ(10, result.thinkMicrosPercentile(25));
+    EXPECT_EQ(20, result.thinkMicrosPercentile(50));
+    EXPECT_EQ(40, result.thinkMicrosPercentile(90));
+    EXPECT_EQ(40, result.thinkMicrosPercentile(100));
+}
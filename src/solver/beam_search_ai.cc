@@ -0,0 +1,84 @@
+#include "solver/beam_search_ai.h"
+
+#include <algorithm>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "base/base.h"
+#include "core/algorithm/plan.h"
+#include "core/algorithm/rensa_detector.h"
+#include "core/column_puyo_list.h"
+#include "core/core_field.h"
+
+DEFINE_int32(beam_fire_chains, 10, "BeamSearchAI fires a rensa when it can fire this chains in the search.");
+
+using namespace std;
+
+namespace {
+
+// The preferred heights relative to the average. The outer columns should be higher
+// for GTR-like building, and the 3rd column should be lower to keep the puyos alive.
+const double IDEAL_HEIGHT_DIFFS[] = { 0, 2, 0, -2, -1, 0, 1, 0 };
+
+}
+
+BeamSearchAI::BeamSearchAI(int beamWidth, int depth, unique_ptr<Executor> executor) :
+    AI("beam_search"),
+    depth_(depth),
+    executor_(std::move(executor)),
+    beamSearch_(beamWidth, executor_.get())
+{
+}
+
+DropDecision BeamSearchAI::think(int frameId, const CoreField& field, const KumipuyoSeq& seq,
+                                 const PlayerState& me, const PlayerState& enemy, bool fast) const
+{
+    return thinkWithDeadline(frameId, field, seq, me, enemy, fast, Deadline::infinite());
+}
+
+DropDecision BeamSearchAI::thinkWithDeadline(int frameId, const CoreField& field, const KumipuyoSeq& seq,
+                                             const PlayerState& me, const PlayerState& enemy, bool fast,
+                                             const Deadline& deadline) const
+{
+    UNUSED_VARIABLE(frameId);
+    UNUSED_VARIABLE(me);
+    UNUSED_VARIABLE(enemy);
+    UNUSED_VARIABLE(fast);
+
+    BeamSearchResult result = beamSearch_.search(field, seq, depth_, evaluate, deadline);
+    if (!result.rensaDecisions.empty() &&
+        (result.rensaResult.chains >= FLAGS_beam_fire_chains || result.decisions.empty())) {
+        return DropDecision(result.rensaDecisions.front(), "fire");
+    }
+
+    if (result.decisions.empty())
+        return DropDecision(Decision(3, 0), "no plan");
+
+    return DropDecision(result.decisions.front(), "build");
+}
+
+// static
+double BeamSearchAI::evaluate(const RefPlan& plan)
+{
+    const CoreField& field = plan.field();
+
+    double potential = 0;
+    RensaDetector::detectSingle(field, RensaDetectorStrategy::defaultDropStrategy(),
+                                [&potential](const CoreField&, const RensaResult& rensaResult,
+                                             const ColumnPuyoList& firePuyos) {
+        potential = std::max(potential, rensaResult.chains * 1000.0 - firePuyos.size() * 100.0);
+    });
+
+    double average = field.countPuyos() / 6.0;
+    double shape = 0;
+    for (int x = 1; x <= CoreField::WIDTH; ++x) {
+        double diff = field.height(x) - average - IDEAL_HEIGHT_DIFFS[x];
+        shape += diff * diff;
+    }
+
+    // Firing a small rensa wastes the puyos.
+    double wasted = plan.isRensaPlan() ? 2000.0 : 0.0;
+
+    return potential - shape * 10.0 - wasted;
+}
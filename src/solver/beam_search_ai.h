@@ -0,0 +1,37 @@
+#ifndef SOLVER_BEAM_SEARCH_AI_H_
+#define SOLVER_BEAM_SEARCH_AI_H_
+
+#include <memory>
+
+#include "base/executor.h"
+#include "core/algorithm/beam_search.h"
+#include "core/client/ai/ai.h"
+
+class RefPlan;
+
+// BeamSearchAI builds a large rensa with BeamSearch looking far ahead.
+// This is for solo building with a long known sequence, e.g. Endless.
+class BeamSearchAI : public AI {
+public:
+    // |executor| can be nullptr.
+    BeamSearchAI(int beamWidth, int depth, std::unique_ptr<Executor> executor = std::unique_ptr<Executor>());
+    virtual ~BeamSearchAI() {}
+
+    // The default evaluation for building. The potential rensa of the field is
+    // valued, and firing a small rensa is penalized.
+    static double evaluate(const RefPlan&);
+
+protected:
+    virtual DropDecision think(int frameId, const CoreField&, const KumipuyoSeq&,
+                               const PlayerState& me, const PlayerState& enemy, bool fast) const override;
+    virtual DropDecision thinkWithDeadline(int frameId, const CoreField&, const KumipuyoSeq&,
+                                           const PlayerState& me, const PlayerState& enemy, bool fast,
+                                           const Deadline&) const override;
+
+private:
+    int depth_;
+    std::unique_ptr<Executor> executor_;
+    BeamSearch beamSearch_;
+};
+
+#endif
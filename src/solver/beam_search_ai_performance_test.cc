@@ -0,0 +1,72 @@
+#include "solver/beam_search_ai.h"
+
+#include <iostream>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "base/executor.h"
+#include "base/time.h"
+#include "core/kumipuyo_seq.h"
+#include "core/sequence_generator.h"
+#include "solver/endless.h"
+
+using namespace std;
+
+namespace {
+
+// Runs Endless with the fixed seeds, and shows how many chains and score are
+// built per millisecond of thinking.
+void runEndless(int beamWidth, int depth, int numThreads)
+{
+    unique_ptr<Executor> executor;
+    if (numThreads > 0) {
+        executor.reset(new Executor(numThreads));
+        executor->start();
+    }
+
+    Endless endless(unique_ptr<AI>(new BeamSearchAI(beamWidth, depth, std::move(executor))));
+
+    const int N = 10;
+    int totalChains = 0;
+    int totalScore = 0;
+    int totalHands = 0;
+    double totalMillis = 0;
+    for (int seed = 0; seed < N; ++seed) {
+        KumipuyoSeq seq = generateRandomSequenceWithSeed(seed);
+        double begin = currentTime();
+        EndlessResult result = endless.run(seq);
+        double millis = (currentTime() - begin) * 1000;
+
+        cout << "seed=" << seed
+             << " type=" << static_cast<int>(result.type)
+             << " hand=" << result.hand
+             << " chains=" << result.maxRensa
+             << " score=" << result.score
+             << " ms/hand=" << millis / (result.hand + 1) << endl;
+
+        if (result.type == EndlessResult::Type::DEAD)
+            continue;
+        totalChains += result.maxRensa;
+        totalScore += result.score;
+        totalHands += result.hand + 1;
+        totalMillis += millis;
+    }
+
+    cout << "width=" << beamWidth << " depth=" << depth << " threads=" << numThreads
+         << " chains/ms=" << totalChains / totalMillis
+         << " score/ms=" << totalScore / totalMillis
+         << " ms/hand=" << totalMillis / totalHands << endl;
+}
+
+}
+
+TEST(BeamSearchAIPerformanceTest, Width16Depth8)
+{
+    runEndless(16, 8, 0);
+}
+
+TEST(BeamSearchAIPerformanceTest, Width32Depth12Parallel)
+{
+    runEndless(32, 12, 4);
+}
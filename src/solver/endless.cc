@@ -1,6 +1,7 @@
 #include "solver/endless.h"
 
 #include <algorithm>
+#include <chrono>
 
 #include "core/frame_request.h"
 #include "core/field_pretty_printer.h"
@@ -26,7 +27,12 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
     ai_->enemy_.field = req.playerFrameRequest[1].field;
     ai_->enemy_.seq = req.playerFrameRequest[1].kumipuyoSeq;
 
+    // The enemy doesn't move.
+    const CoreField enemyField(req.enemyPlayerFrameRequest().field);
+    CoreField field;
+
     vector<Decision> decisions;
+    vector<int64_t> thinkMicros;
 
     int maxRensaScore = 0;
     int maxRensa = 0;
@@ -34,19 +40,21 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
         req.frameId = i + 2;
 
         // For gazing.
-        ai_->gaze(req.frameId, CoreField(req.enemyPlayerFrameRequest().field), req.enemyPlayerFrameRequest().kumipuyoSeq);
+        ai_->gaze(req.frameId, enemyField, req.enemyPlayerFrameRequest().kumipuyoSeq);
 
         // think
         ai_->next2Appeared(req);
         ai_->decisionRequested(req);
 
-        DropDecision dropDecision = ai_->think(req.frameId, req.myPlayerFrameRequest().field,
+        auto begin = chrono::steady_clock::now();
+        DropDecision dropDecision = ai_->think(req.frameId, field,
                                                req.myPlayerFrameRequest().kumipuyoSeq,
                                                ai_->myPlayerState(),
                                                ai_->enemyPlayerState(),
                                                false);
+        thinkMicros.push_back(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count());
 
-        CoreField f(req.myPlayerFrameRequest().field);
+        CoreField f(field);
         if (!f.dropKumipuyo(dropDecision.decision(), req.myPlayerFrameRequest().kumipuyoSeq.front())) {
             // couldn't drop. break.
             break;
@@ -69,6 +77,7 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
                 .zenkeshi = false,
                 .decisions = decisions,
                 .type = EndlessResult::Type::DEAD,
+                .thinkMicros = thinkMicros,
             };
         }
         if (rensaResult.score > 10000) {
@@ -80,6 +89,7 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
                 .zenkeshi = f.isZenkeshi(),
                 .decisions = decisions,
                 .type = EndlessResult::Type::MAIN_CHAIN,
+                .thinkMicros = thinkMicros,
             };
         }
         if (f.isZenkeshi()) {
@@ -90,9 +100,11 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
                 .zenkeshi = true,
                 .decisions = decisions,
                 .type = EndlessResult::Type::ZENKESHI,
+                .thinkMicros = thinkMicros,
             };
         }
 
+        field = f;
         req.playerFrameRequest[0].field = f;
         req.playerFrameRequest[0].kumipuyoSeq.dropFront();
         req.playerFrameRequest[1].kumipuyoSeq.dropFront();
@@ -110,6 +122,7 @@ EndlessResult Endless::run(const KumipuyoSeq& seq)
         .zenkeshi = false,
         .decisions = decisions,
         .type = EndlessResult::Type::PUYOSEQ_RUNOUT,
+        .thinkMicros = thinkMicros,
     };
 }
 
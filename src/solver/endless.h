@@ -1,6 +1,7 @@
 #ifndef SOLVER_ENDLESS_H_
 #define SOLVER_ENDLESS_H_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -23,6 +24,8 @@ struct EndlessResult {
     bool zenkeshi;
     std::vector<Decision> decisions;
     Type type;
+    // The time to think each hand [us].
+    std::vector<int64_t> thinkMicros;
 };
 
 // Endless implements endless mode. This can be used to check your AI's strength.
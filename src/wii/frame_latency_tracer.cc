@@ -0,0 +1,261 @@
+#include "wii/frame_latency_tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#include "core/constant.h"
+
+using namespace std;
+
+namespace {
+
+const double MICROSECONDS_PER_GAME_FRAME = 1000000.0 / FPS;
+
+string formatMillis(double micros)
+{
+    ostringstream ss;
+    ss << fixed << setprecision(1) << micros / 1000;
+    return ss.str();
+}
+
+void writeRow(ostream& os, const string& name, const LatencyHistogram& h, bool inMicros)
+{
+    auto format = [inMicros](double v) {
+        if (inMicros)
+            return formatMillis(v);
+        ostringstream ss;
+        ss << fixed << setprecision(1) << v;
+        return ss.str();
+    };
+
+    os << left << setw(28) << name << right
+       << setw(10) << h.count()
+       << setw(10) << format(h.mean())
+       << setw(10) << format(h.percentile(50))
+       << setw(10) << format(h.percentile(90))
+       << setw(10) << format(h.percentile(99))
+       << setw(10) << format(h.max())
+       << (inMicros ? "  [ms]" : "  [frames]") << '\n';
+}
+
+}
+
+// static
+const char* FrameLatencyTracer::stageName(Stage stage)
+{
+    switch (stage) {
+    case CAPTURED:   return "captured";
+    case ANALYZED:   return "analyzed";
+    case REQUESTED:  return "requested";
+    case RESPONDED:  return "responded";
+    case KEYS_SENT:  return "keys_sent";
+    case NUM_STAGES: break;
+    }
+
+    CHECK(false) << "Unknown stage: " << static_cast<int>(stage);
+    return nullptr;
+}
+
+FrameLatencyTracer::FrameLatencyTracer() :
+    origin_(chrono::steady_clock::now())
+{
+}
+
+int64_t FrameLatencyTracer::now() const
+{
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - origin_).count();
+}
+
+void FrameLatencyTracer::beginFrame(int frameId)
+{
+    int64_t t = now();
+
+    lock_guard<mutex> lock(mu_);
+    DCHECK(!inFrame_) << "endFrame() is not called for frame " << current_.frameId;
+    ++frameIndex_;
+    inFrame_ = true;
+    current_ = FrameTrace();
+    current_.frameId = frameId;
+    current_.times[CAPTURED] = t;
+}
+
+void FrameLatencyTracer::mark(Stage stage)
+{
+    int64_t t = now();
+
+    lock_guard<mutex> lock(mu_);
+    DCHECK(inFrame_);
+    if (current_.times[stage] < 0)
+        current_.times[stage] = t;
+}
+
+void FrameLatencyTracer::endFrame()
+{
+    lock_guard<mutex> lock(mu_);
+    DCHECK(inFrame_);
+    inFrame_ = false;
+
+    // The keys can be sent before the frame requests, e.g. by KeyScheduler, so a stage is
+    // measured from the latest of the previous stages marked before it.
+    for (int stage = CAPTURED + 1; stage < NUM_STAGES; ++stage) {
+        int64_t t = current_.times[stage];
+        if (t < 0)
+            continue;
+        int64_t prev = current_.times[CAPTURED];
+        for (int s = CAPTURED + 1; s < stage; ++s) {
+            if (current_.times[s] <= t)
+                prev = max(prev, current_.times[s]);
+        }
+        stageHistograms_[stage].add(t - prev);
+    }
+    if (current_.times[KEYS_SENT] >= 0)
+        endToEndHistogram_.add(current_.times[KEYS_SENT] - current_.times[CAPTURED]);
+
+    recentTraces_.push_back(current_);
+    while (recentTraces_.size() > MAX_RECENT_TRACES)
+        recentTraces_.pop_front();
+}
+
+void FrameLatencyTracer::decisionRequested(int playerId)
+{
+    lock_guard<mutex> lock(mu_);
+    DCHECK(inFrame_);
+
+    // A new NEXT supersedes the decision requested before.
+    PendingDecision& pending = pendingDecisions_[playerId];
+    pending.valid = true;
+    pending.frameIndex = frameIndex_;
+    pending.capturedTime = current_.times[CAPTURED];
+}
+
+void FrameLatencyTracer::keysSent(int playerId)
+{
+    int64_t t = now();
+
+    lock_guard<mutex> lock(mu_);
+    DCHECK(inFrame_);
+    if (current_.times[KEYS_SENT] < 0)
+        current_.times[KEYS_SENT] = t;
+
+    PendingDecision& pending = pendingDecisions_[playerId];
+    if (!pending.valid)
+        return;
+
+    decisionHistogram_.add(t - pending.capturedTime);
+    decisionFramesHistogram_.add(frameIndex_ - pending.frameIndex);
+    pending.valid = false;
+}
+
+void FrameLatencyTracer::clearPendingDecisions()
+{
+    lock_guard<mutex> lock(mu_);
+    for (PendingDecision& pending : pendingDecisions_)
+        pending.valid = false;
+}
+
+LatencyHistogram FrameLatencyTracer::stageHistogram(Stage stage) const
+{
+    lock_guard<mutex> lock(mu_);
+    return stageHistograms_[stage];
+}
+
+LatencyHistogram FrameLatencyTracer::endToEndHistogram() const
+{
+    lock_guard<mutex> lock(mu_);
+    return endToEndHistogram_;
+}
+
+LatencyHistogram FrameLatencyTracer::decisionHistogram() const
+{
+    lock_guard<mutex> lock(mu_);
+    return decisionHistogram_;
+}
+
+LatencyHistogram FrameLatencyTracer::decisionFramesHistogram() const
+{
+    lock_guard<mutex> lock(mu_);
+    return decisionFramesHistogram_;
+}
+
+string FrameLatencyTracer::summary() const
+{
+    lock_guard<mutex> lock(mu_);
+
+    ostringstream ss;
+    ss << "capture->keys " << formatMillis(endToEndHistogram_.percentile(50))
+       << "/" << formatMillis(endToEndHistogram_.percentile(99)) << "ms"
+       << "  NEXT->keys " << decisionFramesHistogram_.percentile(50)
+       << "/" << decisionFramesHistogram_.percentile(99) << " frames"
+       << " (p50/p99)";
+    return ss.str();
+}
+
+string FrameLatencyTracer::toString() const
+{
+    lock_guard<mutex> lock(mu_);
+    return toStringWithoutLock();
+}
+
+string FrameLatencyTracer::toStringWithoutLock() const
+{
+    ostringstream ss;
+    ss << left << setw(28) << "interval" << right
+       << setw(10) << "count" << setw(10) << "mean"
+       << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << '\n';
+
+    Stage slowest = NUM_STAGES;
+    double slowestTotal = 0;
+    for (int stage = CAPTURED + 1; stage < NUM_STAGES; ++stage) {
+        const LatencyHistogram& h = stageHistograms_[stage];
+        writeRow(ss, string("-> ") + stageName(static_cast<Stage>(stage)), h, true);
+
+        // The stage taking the longest time in total is the one to optimize.
+        double total = h.mean() * h.count();
+        if (slowestTotal < total) {
+            slowestTotal = total;
+            slowest = static_cast<Stage>(stage);
+        }
+    }
+    writeRow(ss, "captured -> keys_sent", endToEndHistogram_, true);
+    writeRow(ss, "NEXT captured -> keys_sent", decisionHistogram_, true);
+    writeRow(ss, "NEXT -> keys_sent", decisionFramesHistogram_, false);
+
+    if (decisionHistogram_.count() > 0) {
+        ss << "Game frames lost from NEXT to keys: mean "
+           << fixed << setprecision(1) << decisionHistogram_.mean() / MICROSECONDS_PER_GAME_FRAME
+           << ", p99 " << decisionHistogram_.percentile(99) / MICROSECONDS_PER_GAME_FRAME << '\n';
+    }
+    if (slowest != NUM_STAGES)
+        ss << "The slowest stage: " << stageName(slowest) << '\n';
+    return ss.str();
+}
+
+bool FrameLatencyTracer::dumpToFile(const string& filename) const
+{
+    lock_guard<mutex> lock(mu_);
+
+    ofstream ofs(filename, ios::out | ios::trunc);
+    ofs << toStringWithoutLock();
+
+    // The time of each stage [us] since the frame was captured. -1 if not reached.
+    ofs << '\n' << "frame_id";
+    for (int stage = CAPTURED + 1; stage < NUM_STAGES; ++stage)
+        ofs << ' ' << stageName(static_cast<Stage>(stage));
+    ofs << '\n';
+    for (const FrameTrace& trace : recentTraces_) {
+        ofs << trace.frameId;
+        for (int stage = CAPTURED + 1; stage < NUM_STAGES; ++stage)
+            ofs << ' ' << (trace.times[stage] < 0 ? -1 : trace.times[stage] - trace.times[CAPTURED]);
+        ofs << '\n';
+    }
+
+    if (!ofs) {
+        LOG(WARNING) << "FrameLatencyTracer::dumpToFile failed: " << filename;
+        return false;
+    }
+    return true;
+}
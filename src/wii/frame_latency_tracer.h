@@ -0,0 +1,104 @@
+#ifndef WII_FRAME_LATENCY_TRACER_H_
+#define WII_FRAME_LATENCY_TRACER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "base/noncopyable.h"
+#include "base/phase_profiler.h"
+
+// FrameLatencyTracer records when each frame passes each stage from the capture
+// to the keys sent, and aggregates the time between the stages into histograms.
+// It also measures how long it takes from the frame where the AI is requested
+// a decision (i.e. a new NEXT has appeared) to the frame where the keys are sent.
+//
+// The stages of a frame are marked by one thread, and the results can be read
+// from other threads, e.g. for drawing.
+class FrameLatencyTracer : noncopyable {
+public:
+    enum Stage {
+        CAPTURED,   // The frame is taken from the source.
+        ANALYZED,   // The analyzer has finished.
+        REQUESTED,  // The frame requests are sent to the AIs.
+        RESPONDED,  // The responses of the AIs are received.
+        KEYS_SENT,  // The keys are passed to the key sender.
+        NUM_STAGES,
+    };
+
+    struct FrameTrace {
+        int frameId = 0;
+        // The time [us] since the tracer was created. -1 if the frame didn't reach the stage.
+        int64_t times[NUM_STAGES] = { -1, -1, -1, -1, -1 };
+    };
+
+    // The number of the recent frames kept for dumpToFile().
+    static const size_t MAX_RECENT_TRACES = 600;
+
+    static const char* stageName(Stage);
+
+    FrameLatencyTracer();
+
+    // Starts the trace of |frameId|, and marks CAPTURED.
+    void beginFrame(int frameId);
+    // Marks |stage| of the current frame. The first mark of each stage is used.
+    void mark(Stage);
+    // Finishes the current frame, and adds its intervals to the histograms.
+    void endFrame();
+
+    // The AI of |playerId| is requested a decision in the current frame.
+    void decisionRequested(int playerId);
+    // The keys for the decision of |playerId| are sent in the current frame.
+    // This also marks KEYS_SENT.
+    void keysSent(int playerId);
+    // Forgets the decisions which have been requested but whose keys are not sent yet.
+    void clearPendingDecisions();
+
+    // Returns the histogram [us] of the time to |stage| from the latest of the previous
+    // stages marked before it.
+    LatencyHistogram stageHistogram(Stage) const;
+    // Returns the histogram [us] from CAPTURED to KEYS_SENT of the same frame.
+    LatencyHistogram endToEndHistogram() const;
+    // Returns the histogram [us] from the capture of the frame where a decision is
+    // requested to the keys sent for it.
+    LatencyHistogram decisionHistogram() const;
+    // Returns the histogram of the number of the frames from the frame where a decision
+    // is requested to the frame where its keys are sent.
+    LatencyHistogram decisionFramesHistogram() const;
+
+    // Returns one line to draw on the screen.
+    std::string summary() const;
+    // Returns the tables of the histograms, and the stage which takes the longest time.
+    std::string toString() const;
+    // Writes toString() and the traces of the recent frames to |filename|.
+    bool dumpToFile(const std::string& filename) const;
+
+private:
+    struct PendingDecision {
+        bool valid = false;
+        int frameIndex = 0;
+        int64_t capturedTime = 0;
+    };
+
+    int64_t now() const;
+    std::string toStringWithoutLock() const;
+
+    const std::chrono::steady_clock::time_point origin_;
+
+    mutable std::mutex mu_;
+    // The number of the frames begun. Unlike the frame id, this is never reset.
+    int frameIndex_ = 0;
+    bool inFrame_ = false;
+    FrameTrace current_;
+    PendingDecision pendingDecisions_[2];
+
+    LatencyHistogram stageHistograms_[NUM_STAGES];
+    LatencyHistogram endToEndHistogram_;
+    LatencyHistogram decisionHistogram_;
+    LatencyHistogram decisionFramesHistogram_;
+    std::deque<FrameTrace> recentTraces_;
+};
+
+#endif
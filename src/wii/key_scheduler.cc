@@ -0,0 +1,85 @@
+#include "wii/key_scheduler.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include "core/constant.h"
+#include "core/puyo_controller.h"
+#include "wii/key_sender.h"
+
+using namespace std;
+
+KeyScheduler::KeyScheduler(KeySender* keySender) :
+    keySender_(keySender)
+{
+}
+
+bool KeyScheduler::setDecision(const CoreField& field, const Decision& decision, double now)
+{
+    if (hasDecision() && decision == decision_)
+        return true;
+
+    // When the kumipuyo has been moved for the previous decision, continue from there.
+    bool moving = hasDecision();
+    KumipuyoMovingState state = moving ? movingState_ : KumipuyoMovingState::initialState();
+    KeySetSeq seq = PuyoController::findKeyStrokeFrom(field, state, decision);
+    if (seq.empty())
+        return false;
+
+    if (!moving) {
+        keySender_->sendWait(INITIAL_WAIT_MILLIS);
+        startTime_ = now + INITIAL_WAIT_MILLIS / 1000.0;
+        numSentFrames_ = 0;
+    }
+
+    decision_ = decision;
+    field_ = field;
+    movingState_ = state;
+    rest_ = seq;
+
+    tick(field, now);
+    return true;
+}
+
+bool KeyScheduler::tick(const CoreField& field, double now)
+{
+    if (!hasDecision() || rest_.empty())
+        return false;
+
+    if (!(field == field_)) {
+        KeySetSeq seq = PuyoController::findKeyStrokeFrom(field, movingState_, decision_);
+        if (seq.empty()) {
+            // Keep the current keys, which would have been sent anyway without the scheduler.
+            LOG(INFO) << "Cannot find the key stroke from the predicted state. decision=" << decision_.toString();
+        } else {
+            rest_ = seq;
+        }
+        field_ = field;
+    }
+
+    int dueFrames = static_cast<int>(max(0.0, now - startTime_) * FPS) + 1 + LEAD_FRAMES;
+    KeySetSeq keys;
+    while (numSentFrames_ < dueFrames && !rest_.empty()) {
+        KeySet keySet = rest_.front();
+        rest_.removeFront();
+        movingState_.moveKumipuyo(field_, keySet);
+        keys.add(keySet);
+        ++numSentFrames_;
+    }
+
+    if (keys.empty())
+        return false;
+
+    keySender_->sendKeySetSeq(keys);
+    return true;
+}
+
+void KeyScheduler::clear()
+{
+    decision_ = Decision();
+    movingState_ = KumipuyoMovingState::initialState();
+    rest_.clear();
+    startTime_ = 0;
+    numSentFrames_ = 0;
+}
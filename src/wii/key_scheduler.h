@@ -0,0 +1,57 @@
+#ifndef WII_KEY_SCHEDULER_H_
+#define WII_KEY_SCHEDULER_H_
+
+#include "base/noncopyable.h"
+#include "core/core_field.h"
+#include "core/decision.h"
+#include "core/key_set.h"
+#include "core/kumipuyo_moving_state.h"
+
+class KeySender;
+
+// KeyScheduler keeps the keys to move the current kumipuyo to the decision, and
+// streams them to KeySender frame by frame. Since the moving kumipuyo is not
+// detected from the captured image, its state is predicted by applying the keys
+// sent so far. The keys are found again from the predicted state when the AI
+// changes the decision or the field changes, e.g. by ojama.
+class KeyScheduler : noncopyable {
+public:
+    // The number of frames to send the keys ahead, so that KeySender doesn't starve
+    // between 2 captured frames.
+    static const int LEAD_FRAMES = 3;
+    // The wait before the first key of a kumipuyo, which is the same as the wait
+    // sent before the whole key stroke.
+    static const int INITIAL_WAIT_MILLIS = 20;
+
+    // Doesn't take the ownership.
+    explicit KeyScheduler(KeySender*);
+
+    // Sets |decision| for the current kumipuyo, and sends the keys due at |now| [s].
+    // Returns false if |decision| is not reachable.
+    bool setDecision(const CoreField&, const Decision&, double now);
+    // Sends the keys due at |now| [s]. |field| is the field observed in the current frame.
+    // Returns true if some keys are sent.
+    bool tick(const CoreField& field, double now);
+    // Forgets the current kumipuyo. Call this when the kumipuyo is grounded or ojama is dropped.
+    void clear();
+
+    bool hasDecision() const { return decision_.isValid(); }
+    const Decision& decision() const { return decision_; }
+    const KumipuyoMovingState& movingState() const { return movingState_; }
+    // The keys not sent yet.
+    const KeySetSeq& restKeySetSeq() const { return rest_; }
+
+private:
+    KeySender* keySender_;
+
+    Decision decision_;
+    CoreField field_;
+    KumipuyoMovingState movingState_;
+    KeySetSeq rest_;
+
+    // The time when the first key is due, and the number of the frames sent since then.
+    double startTime_ = 0;
+    int numSentFrames_ = 0;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "wii/key_scheduler.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/constant.h"
+#include "core/puyo_controller.h"
+#include "wii/key_sender.h"
+
+using namespace std;
+
+namespace {
+
+class FakeKeySender : public KeySender {
+public:
+    virtual void sendWait(int ms) override { waits.push_back(ms); }
+    virtual void sendKeySet(const KeySet& keySet, bool /*forceSend*/) override { keySets.push_back(keySet); }
+    virtual void sendKeySetSeq(const KeySetSeq& seq) override
+    {
+        keySets.insert(keySets.end(), seq.begin(), seq.end());
+        ++numSendKeySetSeq;
+    }
+
+    vector<int> waits;
+    vector<KeySet> keySets;
+    int numSendKeySetSeq = 0;
+};
+
+// The time [s] in the middle of the frame |frames| frames after the first key is due.
+double frameTime(int frames)
+{
+    return KeyScheduler::INITIAL_WAIT_MILLIS / 1000.0 + (frames + 0.5) / FPS;
+}
+
+}
+
+TEST(KeySchedulerTest, sendKeysFrameByFrame)
+{
+    FakeKeySender sender;
+    KeyScheduler scheduler(&sender);
+    CoreField field;
+    Decision decision(6, 2);
+    KeySetSeq expected = PuyoController::findKeyStrokeFrom(field, KumipuyoMovingState::initialState(), decision);
+    ASSERT_LT(static_cast<size_t>(KeyScheduler::LEAD_FRAMES + 2), expected.size());
+
+    // The keys of LEAD_FRAMES frames ahead are sent with the first one.
+    EXPECT_TRUE(scheduler.setDecision(field, decision, 0));
+    EXPECT_EQ(vector<int> { KeyScheduler::INITIAL_WAIT_MILLIS }, sender.waits);
+    EXPECT_EQ(static_cast<size_t>(KeyScheduler::LEAD_FRAMES + 1), sender.keySets.size());
+
+    // Nothing is due in the same frame.
+    EXPECT_FALSE(scheduler.tick(field, frameTime(0)));
+    EXPECT_EQ(static_cast<size_t>(KeyScheduler::LEAD_FRAMES + 1), sender.keySets.size());
+
+    // One more frame is due in the next frame.
+    EXPECT_TRUE(scheduler.tick(field, frameTime(1)));
+    EXPECT_EQ(static_cast<size_t>(KeyScheduler::LEAD_FRAMES + 2), sender.keySets.size());
+
+    // All the keys are sent in time.
+    for (int frames = 2; frames <= static_cast<int>(expected.size()); ++frames)
+        scheduler.tick(field, frameTime(frames));
+    EXPECT_TRUE(scheduler.restKeySetSeq().empty());
+    EXPECT_EQ(KeySetSeq(sender.keySets).toString(), expected.toString());
+    EXPECT_FALSE(scheduler.tick(field, frameTime(static_cast<int>(expected.size()) + 1)));
+
+    // The wait is sent only once.
+    EXPECT_EQ(1U, sender.waits.size());
+}
+
+TEST(KeySchedulerTest, tickWithoutDecision)
+{
+    FakeKeySender sender;
+    KeyScheduler scheduler(&sender);
+
+    EXPECT_FALSE(scheduler.tick(CoreField(), 1.0));
+    EXPECT_TRUE(sender.waits.empty());
+    EXPECT_TRUE(sender.keySets.empty());
+}
+
+TEST(KeySchedulerTest, changeDecision)
+{
+    FakeKeySender sender;
+    KeyScheduler scheduler(&sender);
+    CoreField field;
+
+    EXPECT_TRUE(scheduler.setDecision(field, Decision(1, 2), 0));
+    EXPECT_TRUE(scheduler.tick(field, frameTime(1)));
+    KumipuyoMovingState state = scheduler.movingState();
+    EXPECT_FALSE(state.isInitialPosition());
+
+    // The keys for the new decision continue from the predicted state without a wait.
+    EXPECT_TRUE(scheduler.setDecision(field, Decision(6, 0), frameTime(1)));
+    EXPECT_EQ(1U, sender.waits.size());
+    EXPECT_EQ(PuyoController::findKeyStrokeFrom(field, state, Decision(6, 0)).toString(),
+              scheduler.restKeySetSeq().toString());
+
+    for (int frames = 2; !scheduler.restKeySetSeq().empty(); ++frames)
+        scheduler.tick(field, frameTime(frames));
+    EXPECT_EQ(6, scheduler.movingState().pos.axisX());
+    EXPECT_EQ(0, scheduler.movingState().pos.rot());
+}
+
+TEST(KeySchedulerTest, fieldChanged)
+{
+    FakeKeySender sender;
+    KeyScheduler scheduler(&sender);
+    CoreField field;
+
+    EXPECT_TRUE(scheduler.setDecision(field, Decision(1, 2), 0));
+    KumipuyoMovingState state = scheduler.movingState();
+
+    // When ojama is dropped on the way, the keys are found again from the predicted state.
+    CoreField ojamaField(
+        "O     "
+        "O     "
+        "O     "
+        "O     "
+        "O     "
+        "O     "
+        "O     "
+        "O     "
+        "O     ");
+    EXPECT_TRUE(scheduler.tick(ojamaField, frameTime(1)));
+    EXPECT_EQ(Decision(1, 2), scheduler.decision());
+    KeySetSeq rest = PuyoController::findKeyStrokeFrom(ojamaField, state, Decision(1, 2));
+    ASSERT_FALSE(rest.empty());
+    EXPECT_EQ(rest.size() - 1, scheduler.restKeySetSeq().size());
+}
+
+TEST(KeySchedulerTest, clear)
+{
+    FakeKeySender sender;
+    KeyScheduler scheduler(&sender);
+    CoreField field;
+
+    EXPECT_TRUE(scheduler.setDecision(field, Decision(1, 2), 0));
+    scheduler.clear();
+    EXPECT_FALSE(scheduler.hasDecision());
+    EXPECT_TRUE(scheduler.restKeySetSeq().empty());
+    EXPECT_TRUE(scheduler.movingState().isInitialPosition());
+
+    size_t numKeySets = sender.keySets.size();
+    EXPECT_FALSE(scheduler.tick(field, frameTime(1)));
+    EXPECT_EQ(numKeySets, sender.keySets.size());
+
+    // The next kumipuyo starts with the wait again.
+    EXPECT_TRUE(scheduler.setDecision(field, Decision(1, 2), frameTime(10)));
+    EXPECT_EQ(2U, sender.waits.size());
+}
@@ -0,0 +1,55 @@
+#include "wii/latency_drawer.h"
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "gui/screen.h"
+#include "wii/frame_latency_tracer.h"
+
+using namespace std;
+
+LatencyDrawer::LatencyDrawer(const FrameLatencyTracer* tracer) :
+    tracer_(tracer),
+    textSurface_(emptyUniqueSDLSurface())
+{
+}
+
+LatencyDrawer::~LatencyDrawer()
+{
+}
+
+bool LatencyDrawer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    string text = tracer_->summary();
+    if (text == text_)
+        return true;
+    text_ = text;
+
+    SDL_Color c;
+    c.r = c.g = c.b = 0;
+    c.a = 255;
+
+    // The previous text should be erased as well.
+    rects->push_back(textBox_);
+
+    // The captured image is behind, so draw with the background.
+    textSurface_ = makeUniqueSDLSurface(TTF_RenderUTF8_Shaded(screen->font(), text_.c_str(), c, screen->bgColor()));
+    if (textSurface_.get()) {
+        int x = screen->surface()->w / 2 - textSurface_->w / 2;
+        int y = screen->surface()->h - textSurface_->h * 3 / 2;
+        textBox_ = Box(x, y, x + textSurface_->w, y + textSurface_->h);
+        rects->push_back(textBox_);
+    } else {
+        textBox_ = Box();
+    }
+    return true;
+}
+
+void LatencyDrawer::draw(Screen* screen)
+{
+    if (!textSurface_.get())
+        return;
+
+    SDL_Rect dr = textBox_.toSDLRect();
+    SDL_BlitSurface(textSurface_.get(), NULL, screen->surface(), &dr);
+}
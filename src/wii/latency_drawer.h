@@ -0,0 +1,32 @@
+#ifndef WII_LATENCY_DRAWER_H_
+#define WII_LATENCY_DRAWER_H_
+
+#include <string>
+#include <vector>
+
+#include "gui/box.h"
+#include "gui/drawer.h"
+#include "gui/unique_sdl_surface.h"
+
+class FrameLatencyTracer;
+
+// LatencyDrawer draws the summary of FrameLatencyTracer at the bottom of the screen.
+class LatencyDrawer : public Drawer {
+public:
+    // Doesn't take the ownership.
+    explicit LatencyDrawer(const FrameLatencyTracer*);
+    virtual ~LatencyDrawer();
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
+    virtual void draw(Screen*) override;
+
+private:
+    const FrameLatencyTracer* tracer_;
+
+    // The text is rendered in addDirtyRects() only when the summary is changed, since
+    // draw() might be called several times in a frame.
+    std::string text_;
+    UniqueSDLSurface textSurface_;
+    Box textBox_;
+};
+
+#endif
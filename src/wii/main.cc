@@ -20,6 +20,7 @@
 #include "gui/commentator_drawer.h"
 #include "gui/decision_drawer.h"
 #include "gui/main_window.h"
+#include "wii/latency_drawer.h"
 #include "wii/serial_key_sender.h"
 #include "wii/stdout_key_sender.h"
 #include "wii/wii_connect_server.h"
@@ -35,6 +36,8 @@ using namespace std;
 DEFINE_bool(save_screenshot, false, "save screenshot");
 DEFINE_bool(draw_result, true, "draw analyzer result");
 DEFINE_bool(draw_decision, true, "draw decision");
+DEFINE_bool(draw_latency, false, "draw the latency from the capture to the keys");
+DEFINE_string(latency_dump_file, "", "the file to dump the latency of each stage to when finished");
 DEFINE_string(source, "somagic",
               "set image source. 'somagic' when using somagic video capture."
               " filename if you'd like to use movie.");
@@ -123,6 +126,10 @@ int main(int argc, char* argv[])
     if (FLAGS_draw_decision)
         decisionDrawer.reset(new DecisionDrawer);
 
+    unique_ptr<LatencyDrawer> latencyDrawer;
+    if (FLAGS_draw_latency)
+        latencyDrawer.reset(new LatencyDrawer(&server.latencyTracer()));
+
     unique_ptr<MovieSourceKeyListener> movieSourceKeyListener;
     // TODO(mayah): BAD! Don't check FLAGS_source here.
     if (FLAGS_fps == 0 && FLAGS_source != "somagic" && FLAGS_source != "syntek") {
@@ -157,6 +164,8 @@ int main(int argc, char* argv[])
 
     if (decisionDrawer.get())
         mainWindow->addDrawer(decisionDrawer.get());
+    if (latencyDrawer.get())
+        mainWindow->addDrawer(latencyDrawer.get());
 
 #if USE_AUDIO_COMMENTATOR
     unique_ptr<InternalSpeaker> internalSpeaker;
@@ -193,6 +202,11 @@ int main(int argc, char* argv[])
     if (commentator.get())
         commentator->stop();
 
+    if (!FLAGS_latency_dump_file.empty()) {
+        server.latencyTracer().dumpToFile(FLAGS_latency_dump_file);
+        cout << server.latencyTracer().toString();
+    }
+
 #if USE_AUDIO_COMMENTATOR
     if (audioServer.get())
         audioServer->stop();
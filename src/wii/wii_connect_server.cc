@@ -3,6 +3,8 @@
 #include <iostream>
 #include <vector>
 
+#include <gflags/gflags.h>
+
 #include "base/time.h"
 #include "capture/analyzer.h"
 #include "capture/source.h"
@@ -22,6 +24,31 @@
 
 using namespace std;
 
+DEFINE_bool(predictive_keys, false,
+            "stream the keys of the latest decision frame by frame, instead of sending all the keys"
+            " when the AI responds");
+
+namespace {
+
+// Makes the field to find a key stroke. This is for checking the destination is reachable,
+// so it is ok to set ojama if the cell is occupied.
+CoreField makeFieldForKeyStroke(const AdjustedField& af)
+{
+    CoreField field;
+    for (int x = 1; x <= 6; ++x) {
+        for (int y = 1; y <= 12; ++y) {
+            if (af.field.get(x, y) == RealColor::RC_EMPTY)
+                break;
+
+            field.unsafeSet(x, y, PuyoColor::OJAMA);
+        }
+        field.recalcHeightOn(x);
+    }
+    return field;
+}
+
+}
+
 WiiConnectServer::WiiConnectServer(Source* source, Analyzer* analyzer, KeySender* keySender,
                                    const string& p1Program, const string& p2Program) :
     shouldStop_(false),
@@ -38,6 +65,9 @@ WiiConnectServer::WiiConnectServer(Source* source, Analyzer* analyzer, KeySender
         Connector::create(1, p2Program),
     });
     connector_->setWaitTimeout(false);
+
+    for (int pi = 0; pi < 2; ++pi)
+        keySchedulers_[pi].reset(new KeyScheduler(keySender));
 }
 
 WiiConnectServer::~WiiConnectServer()
@@ -72,12 +102,15 @@ void WiiConnectServer::reset()
     for (int i = 0; i < 2; ++i) {
         lastDecision_[i] = Decision();
         messages_[i].clear();
+        keySchedulers_[i]->clear();
     }
 
     colorMap_.clear();
     colorMap_.insert(make_pair(RealColor::RC_EMPTY, PuyoColor::EMPTY));
     colorMap_.insert(make_pair(RealColor::RC_OJAMA, PuyoColor::OJAMA));
     colorsUsed_.fill(false);
+
+    latencyTracer_.clearPendingDecisions();
 }
 
 void WiiConnectServer::runLoop()
@@ -103,7 +136,9 @@ void WiiConnectServer::runLoop()
             continue;
         }
 
+        latencyTracer_.beginFrame(frameId);
         unique_ptr<AnalyzerResult> r = analyzer_->analyze(surface.get(), prevSurface.get(),  analyzerResults_);
+        latencyTracer_.mark(FrameLatencyTracer::ANALYZED);
         LOG(INFO) << r->toString();
 
         switch (r->state()) {
@@ -157,13 +192,17 @@ void WiiConnectServer::runLoop()
             break;
         }
 
+        latencyTracer_.endFrame();
+
         // We set frameId to surface's userdata. This will be useful for saving screen shot.
         surface->userdata = reinterpret_cast<void*>(static_cast<uintptr_t>(frameId));
 
         {
             lock_guard<mutex> lock(mu_);
+            source_->recycleFrame(move(prevSurface));
             prevSurface = move(surface_);
             surface_ = move(surface);
+            surfaceUpdated_ = true;
             analyzerResults_.push_front(move(r));
             while (analyzerResults_.size() > 10)
                 analyzerResults_.pop_back();
@@ -207,8 +246,6 @@ bool WiiConnectServer::playForLevelSelect(int frameId, const AnalyzerResult& ana
 
 bool WiiConnectServer::playForPlaying(int frameId, const AnalyzerResult& analyzerResult)
 {
-    double beginTime = currentTime();
-
     // Send KeySet() after detecting ojama-drop or grounded.
     // It's important that it is sent before requesting the decision to client,
     // because client may take time to return the rensponse.
@@ -223,6 +260,22 @@ bool WiiConnectServer::playForPlaying(int frameId, const AnalyzerResult& analyze
         }
     }
 
+    // The keys of the current kumipuyo are sent before the AI round trip, so that
+    // they don't wait for the response.
+    if (FLAGS_predictive_keys) {
+        double now = currentTime();
+        for (int pi = 0; pi < 2; ++pi) {
+            if (!isAi_[pi])
+                continue;
+
+            const PlayerAnalyzerResult* pr = analyzerResult.playerResult(pi);
+            if (pr->userEvent.grounded || pr->userEvent.ojamaDropped)
+                keySchedulers_[pi]->clear();
+            else if (keySchedulers_[pi]->tick(makeFieldForKeyStroke(pr->adjustedField), now))
+                latencyTracer_.mark(FrameLatencyTracer::KEYS_SENT);
+        }
+    }
+
     for (int pi = 0; pi < 2; pi++) {
         if (connector_->connector(pi)->isClosed()) {
             LOG(INFO) << playerText(pi) << " disconnected";
@@ -230,18 +283,27 @@ bool WiiConnectServer::playForPlaying(int frameId, const AnalyzerResult& analyze
             return false;
         }
 
-        if (isAi_[pi])
-            connector_->connector(pi)->send(makeFrameRequestFor(pi, frameId, analyzerResult));
+        if (!isAi_[pi])
+            continue;
+
+        connector_->connector(pi)->send(makeFrameRequestFor(pi, frameId, analyzerResult));
+        if (analyzerResult.playerResult(pi)->userEvent.decisionRequest)
+            latencyTracer_.decisionRequested(pi);
     }
+    latencyTracer_.mark(FrameLatencyTracer::REQUESTED);
 
     vector<FrameResponse> responses[2];
     connector_->receive(frameId, responses);
+    latencyTracer_.mark(FrameLatencyTracer::RESPONDED);
 
     for (int pi = 0; pi < 2; pi++) {
         if (!isAi_[pi])
             continue;
 
-        if (analyzerResult.playerResult(pi)->userEvent.grounded) {
+        // The key scheduler has forgotten the decision when ojama is dropped, so the same
+        // decision should be accepted again.
+        const UserEvent& userEvent = analyzerResult.playerResult(pi)->userEvent;
+        if (userEvent.grounded || (FLAGS_predictive_keys && userEvent.ojamaDropped)) {
             lastDecision_[pi] = Decision();
         }
 
@@ -253,7 +315,7 @@ bool WiiConnectServer::playForPlaying(int frameId, const AnalyzerResult& analyze
             }
         }
 
-        outputKeys(pi, analyzerResult, responses[pi], beginTime);
+        outputKeys(pi, analyzerResult, responses[pi]);
     }
 
     return true;
@@ -398,7 +460,7 @@ GameState WiiConnectServer::toGameState(int frameId, const AnalyzerResult& analy
 }
 
 void WiiConnectServer::outputKeys(int pi, const AnalyzerResult& analyzerResult,
-                                  const vector<FrameResponse>& responses, double beginTime)
+                                  const vector<FrameResponse>& responses)
 {
     // Try all commands from the newest one.
     // If we find a command we can use, we'll ignore older ones.
@@ -410,46 +472,46 @@ void WiiConnectServer::outputKeys(int pi, const AnalyzerResult& analyzerResult,
         if (!d.isValid() || d == lastDecision_[pi])
             continue;
 
-        // ----------
-        // Set's the current area.
-        // This is for checking the destination is reachable, it is ok to set ojama if the cell is occupied.
-        KeySetSeq keySetSeq;
-        {
-            CoreField field;
-            const AdjustedField& af = analyzerResult.playerResult(pi)->adjustedField;
-            for (int x = 1; x <= 6; ++x) {
-                for (int y = 1; y <= 12; ++y) {
-                    if (af.field.get(x, y) == RealColor::RC_EMPTY)
-                        break;
-
-                    field.unsafeSet(x, y, PuyoColor::OJAMA);
-                }
-                field.recalcHeightOn(x);
-            }
-
-            keySetSeq = PuyoController::findKeyStroke(field, d);
-            if (keySetSeq.empty()) {
+        CoreField field = makeFieldForKeyStroke(analyzerResult.playerResult(pi)->adjustedField);
+        if (FLAGS_predictive_keys) {
+            // The scheduler continues from the keys already sent for the previous decision.
+            if (!keySchedulers_[pi]->setDecision(field, d, currentTime())) {
                 cout << "Cannot move?" << endl;
                 continue;
             }
+            lastDecision_[pi] = d;
+            latencyTracer_.keysSent(pi);
+            return;
+        }
+
+        KeySetSeq keySetSeq = PuyoController::findKeyStroke(field, d);
+        if (keySetSeq.empty()) {
+            cout << "Cannot move?" << endl;
+            continue;
         }
 
         lastDecision_[pi] = d;
         if (!keySetSeq.empty()) {
-            double endTime = currentTime();
-            cout << (endTime - beginTime) << endl;
-            double duration = 33.3333 - (endTime - beginTime) * 1000;
-            cout << duration << endl;
-
-            // TODO(mayah): Maybe we need to wait using duration?
+            // TODO(mayah): Maybe we need to wait using the latency since the frame was captured?
             keySender_->sendWait(20);
         }
 
         keySender_->sendKeySetSeq(keySetSeq);
+        latencyTracer_.keysSent(pi);
         return;
     }
 }
 
+bool WiiConnectServer::addDirtyRects(Screen* screen, vector<Box>* rects)
+{
+    lock_guard<mutex> lock(mu_);
+    if (surfaceUpdated_) {
+        rects->push_back(screen->mainBox());
+        surfaceUpdated_ = false;
+    }
+    return true;
+}
+
 void WiiConnectServer::draw(Screen* screen)
 {
     SDL_Surface* surface = screen->surface();
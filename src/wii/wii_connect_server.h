@@ -8,6 +8,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "base/base.h"
 #include "capture/analyzer_result_drawer.h"
@@ -19,6 +20,8 @@
 #include "core/server/connector/connector_manager.h"
 #include "gui/drawer.h"
 #include "gui/unique_sdl_surface.h"
+#include "wii/frame_latency_tracer.h"
+#include "wii/key_scheduler.h"
 
 class Analyzer;
 class AnalyzerResult;
@@ -35,12 +38,15 @@ public:
     // Dont' take the ownership.
     void addObserver(GameStateObserver*);
 
+    virtual bool addDirtyRects(Screen*, std::vector<Box>*) override;
     virtual void draw(Screen*) override;
     virtual std::unique_ptr<AnalyzerResult> analyzerResult() const override;
 
     bool start();
     void stop();
 
+    const FrameLatencyTracer& latencyTracer() const { return latencyTracer_; }
+
 private:
     void reset();
     void runLoop();
@@ -51,7 +57,7 @@ private:
     bool playForFinished(int frameId);
 
     FrameRequest makeFrameRequestFor(int playerId, int frameId, const AnalyzerResult&);
-    void outputKeys(int playerId, const AnalyzerResult&, const std::vector<FrameResponse>&, double beginTime);
+    void outputKeys(int playerId, const AnalyzerResult&, const std::vector<FrameResponse>&);
 
     PuyoColor toPuyoColor(RealColor, bool allowAllocation = false);
 
@@ -63,15 +69,20 @@ private:
 
     std::vector<GameStateObserver*> observers_;
 
-    // These 3 field should be used for only drawing.
+    // These 4 field should be used for only drawing.
     mutable std::mutex mu_;
     UniqueSDLSurface surface_;
+    bool surfaceUpdated_ = false;
     std::deque<std::unique_ptr<AnalyzerResult>> analyzerResults_;
 
     Source* source_;
     Analyzer* analyzer_;
     KeySender* keySender_;
 
+    FrameLatencyTracer latencyTracer_;
+    // Used with --predictive_keys.
+    std::unique_ptr<KeyScheduler> keySchedulers_[2];
+
     std::map<RealColor, PuyoColor> colorMap_;
     std::array<bool, 4> colorsUsed_;
 